@@ -1,6 +1,8 @@
 #pragma once
 
 #include "gqf/gqf.h"
+#include "utils/verify.hpp"
+
 #include <mutex>
 #include <cmath>
 #include <cstring>
@@ -84,6 +86,31 @@ class cqf {
         return qf_count_key_value(&qf_, d & range_mask_, 0, lock);
     }
 
+    template<class Writer>
+    void BinWrite(Writer &writer) const {
+        writer.write((char*)&num_hash_bits_, sizeof(num_hash_bits_));
+        writer.write((char*)&num_slots_, sizeof(num_slots_));
+        writer.write((char*)&insertions_, sizeof(insertions_));
+        // Locks are not saved, they are recreated by qf_init()
+        writer.write((char*)qf_.metadata, sizeof(*qf_.metadata));
+        writer.write((char*)qf_.blocks, qf_.metadata->size);
+    }
+
+    template<class Reader>
+    void BinRead(Reader &reader) {
+        reader.read((char*)&num_hash_bits_, sizeof(num_hash_bits_));
+        reader.read((char*)&num_slots_, sizeof(num_slots_));
+        reader.read((char*)&insertions_, sizeof(insertions_));
+
+        qf_destroy(&qf_);
+        qf_init(&qf_, num_slots_, num_hash_bits_, 0, 42);
+        uint64_t size = qf_.metadata->size;
+        reader.read((char*)qf_.metadata, sizeof(*qf_.metadata));
+        VERIFY_MSG(qf_.metadata->size == size, "Inconsistent CQF size");
+        reader.read((char*)qf_.blocks, size);
+        range_mask_ = qf_.metadata->range - 1;
+    }
+
 private:
     void merge(QF *qf, QF *other) {
         QFi other_cfi;
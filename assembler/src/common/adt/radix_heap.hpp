@@ -0,0 +1,104 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/verify.hpp"
+
+#include <array>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace adt {
+
+// Monotone radix heap: a min-priority queue over unsigned integer keys for
+// the case when no key smaller than the last extracted one is ever pushed
+// (e.g. Dijkstra with non-negative edge weights). Element with key x lives in
+// bucket msb(x ^ last) + 1, so push is O(1) and pop is O(log(max key))
+// amortized. Bucket storage is never released by clear(), so a heap could be
+// reused across many short runs without touching the allocator.
+template<class Key, class Value>
+class radix_heap {
+    static_assert(std::is_unsigned<Key>::value, "radix heap requires unsigned keys");
+    static_assert(sizeof(Key) <= sizeof(unsigned long long), "key type is too wide");
+
+    static constexpr size_t BUCKET_COUNT = std::numeric_limits<Key>::digits + 1;
+
+public:
+    typedef std::pair<Key, Value> value_type;
+
+    radix_heap()
+            : last_(0), size_(0) {}
+
+    bool empty() const { return size_ == 0; }
+    size_t size() const { return size_; }
+
+    void push(Key key, const Value &value) {
+        VERIFY_DEV(key >= last_);
+        buckets_[bucket(key)].emplace_back(key, value);
+        size_ += 1;
+    }
+
+    // Moves the minimum into bucket 0 and returns it. Must not be called on
+    // the empty heap.
+    const value_type &top() {
+        pull();
+        return buckets_[0].back();
+    }
+
+    Key top_key() {
+        return top().first;
+    }
+
+    void pop() {
+        pull();
+        buckets_[0].pop_back();
+        size_ -= 1;
+    }
+
+    void clear() {
+        for (auto &b : buckets_)
+            b.clear();
+        last_ = 0;
+        size_ = 0;
+    }
+
+private:
+    size_t bucket(Key key) const {
+        return key == last_ ? 0 :
+                size_t(std::numeric_limits<unsigned long long>::digits -
+                       __builtin_clzll((unsigned long long)(key ^ last_)));
+    }
+
+    void pull() {
+        VERIFY_DEV(size_ > 0);
+        if (!buckets_[0].empty())
+            return;
+
+        size_t i = 1;
+        while (buckets_[i].empty())
+            ++i;
+
+        auto &src = buckets_[i];
+        Key new_last = src.front().first;
+        for (const auto &el : src)
+            new_last = std::min(new_last, el.first);
+
+        last_ = new_last;
+        // All the elements go to the buckets with smaller indices
+        for (auto &el : src)
+            buckets_[bucket(el.first)].push_back(std::move(el));
+        src.clear();
+    }
+
+    std::array<std::vector<value_type>, BUCKET_COUNT> buckets_;
+    Key last_;
+    size_t size_;
+};
+
+}
@@ -3,77 +3,123 @@
 //
 
 #include "connected_component.hpp"
+
+#include "adt/concurrent_dsu.hpp"
+#include "assembly_graph/core/graph_iterators.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
 #include <algorithm>
-#include <map>
-#include <stack>
+#include <numeric>
 #include <vector>
-#include <set>
-#include <unordered_set>
 
 namespace debruijn_graph {
 
-void ConnectedComponentCounter::CalculateComponents() const {
-    std::map<EdgeId, size_t> component_ids;
-    std::vector<std::pair<size_t, size_t>> to_sort;
-    std::map<size_t, size_t> comp_size;
-    size_t cur_id = 0;
-    for (auto e = g_.ConstEdgeBegin(); !e.IsEnd(); ++e) {
-        if (component_ids.find(*e) == component_ids.end()) {
-            std::unordered_set <EdgeId> next;
-            next.insert(*e);
-            std::set <EdgeId> used;
-            size_t ans = 0;
-            while (!next.empty()) {
-                auto cur = *next.begin();
-                next.erase(next.begin());
-                if (used.find(cur) != used.end()) {
-                    continue;
-                }
-                ans += g_.length(cur);
-                used.insert(cur);
-                std::vector<EdgeId> neighbours;
-                neighbours.push_back(g_.conjugate(cur));
-                auto start = g_.EdgeStart(cur);
-                auto tmp = g_.IncidentEdges(start);
-
-                neighbours.insert(neighbours.end(), tmp.begin(), tmp.end());
-                auto end = g_.EdgeEnd(cur);
-                tmp = g_.IncidentEdges(end);
-                neighbours.insert(neighbours.end(), tmp.begin(), tmp.end());
-                for (auto ee:neighbours) {
-                    if (used.find(ee) == used.end()) {
-                        next.insert(ee);
-                    }
-                }
+void EdgeComponents::Calculate() {
+    clear();
+
+    size_t max_id = g_.max_eid();
+    dsu::ConcurrentDSU dsu(max_id);
+
+    // Every edge is united with its conjugate once via its start, and with the other edges of every vertex
+    auto chunks = omnigraph::IterationHelper<Graph, VertexId>(g_).Chunks(16 * omp_get_max_threads());
+#   pragma omp parallel for schedule(guided)
+    for (size_t i = 0; i < chunks.size() - 1; ++i) {
+        for (auto it = chunks[i]; it != chunks[i + 1]; ++it) {
+            VertexId v = *it;
+            EdgeId first;
+            for (EdgeId e : g_.OutgoingEdges(v)) {
+                dsu.unite(e.int_id(), g_.conjugate(e).int_id());
+                if (first)
+                    dsu.unite(first.int_id(), e.int_id());
+                else
+                    first = e;
             }
-            for (auto edge: used) {
-                component_ids[edge] = cur_id;
+            for (EdgeId e : g_.IncomingEdges(v)) {
+                if (first)
+                    dsu.unite(first.int_id(), e.int_id());
+                else
+                    first = e;
             }
-            to_sort.push_back(std::make_pair(ans, cur_id));
-            comp_size[cur_id] = ans;
-            cur_id ++;
         }
     }
-    //TODO: sort in descending order
-    std::sort(to_sort.begin(), to_sort.end());
-    std::reverse(to_sort.begin(), to_sort.end());
-    std::vector<size_t> perm(to_sort.size());
-    for (size_t i = 0; i < to_sort.size(); i++) {
-        perm[to_sort[i].second] = i;
-        component_total_len_[i] = comp_size[to_sort[i].second];
+
+    std::vector<size_t> roots(max_id, NO_COMPONENT);
+#   pragma omp parallel for schedule(guided)
+    for (size_t i = 0; i < chunks.size() - 1; ++i) {
+        for (auto it = chunks[i]; it != chunks[i + 1]; ++it) {
+            for (EdgeId e : g_.OutgoingEdges(*it))
+                roots[e.int_id()] = dsu.find_set(e.int_id());
+        }
     }
-    for (auto pair:component_ids) {
-        component_ids_[pair.first] = perm[pair.second];
-        component_edges_quantity_[perm[pair.second]]++;
+
+    // Dense ids, the root slot keeps the id of its component
+    ids_.assign(max_id, NO_COMPONENT);
+    std::vector<size_t> counts;
+    for (EdgeId e : omnigraph::IterationHelper<Graph, EdgeId>(g_)) {
+        size_t &comp = ids_[roots[e.int_id()]];
+        if (comp == NO_COMPONENT) {
+            comp = lengths_.size();
+            lengths_.push_back(0);
+            counts.push_back(0);
+        }
+        lengths_[comp] += g_.length(e);
+        counts[comp] += 1;
+    }
+
+    offsets_.assign(counts.size() + 1, 0);
+    std::partial_sum(counts.begin(), counts.end(), offsets_.begin() + 1);
+    edges_.resize(offsets_.back());
+    std::vector<size_t> pos(offsets_.begin(), offsets_.end() - 1);
+    for (EdgeId e : omnigraph::IterationHelper<Graph, EdgeId>(g_))
+        edges_[pos[ids_[roots[e.int_id()]]]++] = e;
+
+#   pragma omp parallel for
+    for (size_t i = 0; i < edges_.size(); ++i) {
+        size_t id = edges_[i].int_id();
+        roots[id] = ids_[roots[id]];
+    }
+    ids_ = std::move(roots);
+}
+
+void EdgeComponents::clear() {
+    ids_.clear();
+    lengths_.clear();
+    offsets_.clear();
+    edges_.clear();
+}
+
+void ConnectedComponentCounter::CalculateComponents() const {
+    EdgeComponents components(g_);
+    components.Calculate();
+
+    std::vector<size_t> order(components.size());
+    std::iota(order.begin(), order.end(), 0);
+    // Descending by length, the later component goes first among the ones of the same length
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) {
+        return std::make_pair(components.length(a), a) > std::make_pair(components.length(b), b);
+    });
+    std::vector<size_t> perm(order.size());
+    component_total_len_.resize(order.size());
+    component_edges_quantity_.resize(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        perm[order[i]] = i;
+        component_total_len_[i] = components.length(order[i]);
+        component_edges_quantity_[i] = components.edge_count(order[i]);
+    }
+
+    component_ids_.assign(g_.max_eid(), size_t(-1));
+    for (size_t comp = 0; comp < components.size(); ++comp) {
+        for (EdgeId e : components.edges(comp))
+            component_ids_[e.int_id()] = perm[comp];
     }
-    return;
 }
 
 size_t ConnectedComponentCounter::GetComponent(EdgeId e) const {
-    if (component_ids_.size() == 0) {
+    if (component_edges_quantity_.size() == 0) {
         CalculateComponents();
     }
-    return component_ids_.at(e);
+    VERIFY(e.int_id() < component_ids_.size() && component_ids_[e.int_id()] != size_t(-1));
+    return component_ids_[e.int_id()];
 }
 
 
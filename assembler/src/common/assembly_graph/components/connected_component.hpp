@@ -3,21 +3,78 @@
 //
 #pragma once
 #include "assembly_graph/core/graph.hpp"
-#include <map>
+#include "adt/iterator_range.hpp"
+
+#include <vector>
 
 namespace debruijn_graph {
 
+/*
+ * Weakly connected components of the graph, an edge shares the component with its conjugate and
+ * with the edges incident to its ends. The labels come from a parallel union-find pass over all
+ * vertices and are stored in dense arrays: component ids are indexed by edge id, component ids
+ * themselves go in the order of graph iteration.
+ */
+class EdgeComponents {
+public:
+    typedef std::vector<EdgeId>::const_iterator edge_iterator;
+
+    explicit EdgeComponents(const Graph &g) : g_(g) {}
+
+    void Calculate();
+
+    void clear();
+
+    // Number of components
+    size_t size() const {
+        return lengths_.size();
+    }
+
+    bool contains(EdgeId e) const {
+        return e.int_id() < ids_.size() && ids_[e.int_id()] != NO_COMPONENT;
+    }
+
+    size_t component(EdgeId e) const {
+        VERIFY(contains(e));
+        return ids_[e.int_id()];
+    }
+
+    // Total length of the edges, conjugate edges are both counted
+    size_t length(size_t comp) const {
+        return lengths_[comp];
+    }
+
+    size_t edge_count(size_t comp) const {
+        return offsets_[comp + 1] - offsets_[comp];
+    }
+
+    adt::iterator_range<edge_iterator> edges(size_t comp) const {
+        return adt::make_range(edges_.begin() + offsets_[comp], edges_.begin() + offsets_[comp + 1]);
+    }
+
+private:
+    enum : size_t { NO_COMPONENT = size_t(-1) };
+
+    const Graph &g_;
+    std::vector<size_t> ids_;
+    std::vector<size_t> lengths_;
+    // Edges of the components, grouped
+    std::vector<size_t> offsets_;
+    std::vector<EdgeId> edges_;
+};
+
 class ConnectedComponentCounter {
 public:
-    mutable std::map<EdgeId, size_t> component_ids_;
-    mutable std::map<size_t, size_t> component_edges_quantity_;
-    mutable std::map<size_t, size_t> component_total_len_;
+    // Components are numbered by their total length in descending order
+    mutable std::vector<size_t> component_ids_;
+    mutable std::vector<size_t> component_edges_quantity_;
+    mutable std::vector<size_t> component_total_len_;
     const Graph &g_;
     ConnectedComponentCounter(const Graph &g):g_(g) {}
     void CalculateComponents() const;
     size_t GetComponent(EdgeId e) const;
     bool IsFilled() const {
-        return (component_ids_.size() != 0);
+        return (component_edges_quantity_.size() != 0);
     }
 };
 }
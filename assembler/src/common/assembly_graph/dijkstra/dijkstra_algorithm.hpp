@@ -7,12 +7,17 @@
 #pragma once
 
 #include "dijkstra_settings.hpp"
+#include "dijkstra_storage_pool.hpp"
 
+#include "adt/radix_heap.hpp"
 #include "utils/stl_utils.hpp"
 #include "utils/logger/logger.hpp"
 
 #include <parallel_hashmap/phmap.h>
 
+#include <algorithm>
+#include <limits>
+#include <memory>
 #include <queue>
 #include <vector>
 
@@ -245,6 +250,287 @@ private:
     DECL_LOGGER("Dijkstra");
 };
 
+// Per-vertex state of RadixHeapDijkstra stored in plain arrays indexed by
+// vertex id. Every entry is stamped with the epoch of the run that touched it,
+// so starting a new run is O(1) instead of clearing hash maps. Memory is
+// O(max vertex id) per storage, which is amortized by reusing the storages
+// within the thread (see DijkstraStoragePool).
+template<class Graph, typename distance_t>
+class DijkstraVertexStorage {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+
+    // Lowest bit of the stamp marks processed vertices
+    static constexpr uint32_t MAX_EPOCH = std::numeric_limits<uint32_t>::max() >> 1;
+
+public:
+    struct QueueElement {
+        VertexId curr_vertex;
+        VertexId prev_vertex;
+        EdgeId edge_between;
+
+        QueueElement(VertexId new_cur_vertex, VertexId new_prev_vertex, EdgeId new_edge_between) noexcept
+                : curr_vertex(new_cur_vertex), prev_vertex(new_prev_vertex),
+                  edge_between(new_edge_between) {}
+    };
+    typedef adt::radix_heap<distance_t, QueueElement> queue_t;
+
+    DijkstraVertexStorage()
+            : epoch_(0) {}
+
+    void Reset(size_t max_id, bool collect_traceback) {
+        if (stamps_.size() < max_id) {
+            stamps_.resize(max_id, 0);
+            distances_.resize(max_id);
+        }
+        if (collect_traceback && traceback_.size() < stamps_.size())
+            traceback_.resize(stamps_.size());
+
+        if (++epoch_ > MAX_EPOCH) {
+            std::fill(stamps_.begin(), stamps_.end(), 0);
+            epoch_ = 1;
+        }
+
+        reached_.clear();
+        processed_.clear();
+        queue_.clear();
+    }
+
+    bool reached(VertexId v) const {
+        size_t id = v.int_id();
+        return id < stamps_.size() && (stamps_[id] >> 1) == epoch_;
+    }
+
+    bool processed(VertexId v) const {
+        return reached(v) && (stamps_[v.int_id()] & 1);
+    }
+
+    bool has_traceback(VertexId v) const {
+        return reached(v) && v.int_id() < traceback_.size();
+    }
+
+    distance_t distance(VertexId v) const {
+        return distances_[v.int_id()];
+    }
+
+    const std::pair<VertexId, EdgeId> &traceback(VertexId v) const {
+        return traceback_[v.int_id()];
+    }
+
+    void reach(VertexId v, distance_t distance) {
+        size_t id = v.int_id();
+        VERIFY_DEV(id < stamps_.size());
+        stamps_[id] = epoch_ << 1;
+        distances_[id] = distance;
+        reached_.push_back(v);
+    }
+
+    void set_traceback(VertexId v, VertexId prev_vertex, EdgeId edge) {
+        traceback_[v.int_id()] = { prev_vertex, edge };
+    }
+
+    void process(VertexId v) {
+        stamps_[v.int_id()] |= 1;
+        processed_.push_back(v);
+    }
+
+    queue_t &queue() { return queue_; }
+    const std::vector<VertexId> &reached_vertices() const { return reached_; }
+    const std::vector<VertexId> &processed_vertices() const { return processed_; }
+
+private:
+    uint32_t epoch_;
+    std::vector<uint32_t> stamps_;
+    std::vector<distance_t> distances_;
+    std::vector<std::pair<VertexId, EdgeId>> traceback_;
+    std::vector<VertexId> reached_;
+    std::vector<VertexId> processed_;
+    queue_t queue_;
+};
+
+// Drop-in replacement of Dijkstra for short bounded searches run in large
+// numbers. Uses monotone radix heap instead of binary one and the reusable
+// epoch-stamped vertex storage instead of hash maps. Requires unsigned integer
+// distances. Vertices with equal distances might be settled in the order
+// different from the one of Dijkstra; the distances themselves are the same.
+template<class Graph, class DijkstraSettings, typename distance_t = size_t>
+class RadixHeapDijkstra {
+    typedef typename Graph::VertexId VertexId;
+    typedef typename Graph::EdgeId EdgeId;
+    typedef distance_t DistanceType;
+    typedef DijkstraVertexStorage<Graph, distance_t> storage_t;
+    typedef typename storage_t::QueueElement queue_element;
+    typedef DijkstraStoragePool<storage_t> pool_t;
+
+    // constructor parameters
+    const Graph& graph_;
+    DijkstraSettings settings_;
+    size_t max_vertex_number_;
+    bool collect_traceback_;
+
+    // changeable parameters
+    bool finished_;
+    size_t vertex_number_;
+    bool vertex_limit_exceeded_;
+
+    // accumulative structures
+    typename pool_t::pointer storage_;
+
+    void Init(VertexId start) {
+        vertex_number_ = 0;
+        storage_->Reset(graph_.max_vid() + 1, collect_traceback_);
+        set_finished(false);
+        settings_.Init(start);
+        storage_->queue().push(0, queue_element(start, VertexId(), EdgeId()));
+    }
+
+    void set_finished(bool state) {
+        finished_ = state;
+    }
+
+    bool CheckPutVertex(VertexId vertex, EdgeId edge, distance_t length) const {
+        return settings_.CheckPutVertex(vertex, edge, length);
+    }
+
+    bool CheckProcessVertex(VertexId vertex, distance_t distance) {
+        ++vertex_number_;
+        if (vertex_number_ > max_vertex_number_) {
+            vertex_limit_exceeded_ = true;
+            return false;
+        }
+        return (vertex_number_ < max_vertex_number_) && settings_.CheckProcessVertex(vertex, distance);
+    }
+
+    distance_t GetLength(EdgeId edge) const {
+        return settings_.GetLength(edge);
+    }
+
+    void AddNeighboursToQueue(VertexId cur_vertex, distance_t cur_dist) {
+        auto &queue = storage_->queue();
+        auto neigh_iterator = settings_.GetIterator(cur_vertex);
+        while (neigh_iterator.HasNext()) {
+            auto cur_pair = neigh_iterator.Next();
+            if (DistanceCounted(cur_pair.vertex))
+                continue;
+
+            distance_t new_dist = GetLength(cur_pair.edge) + cur_dist;
+            if (CheckPutVertex(cur_pair.vertex, cur_pair.edge, new_dist))
+                queue.push(new_dist, queue_element(cur_pair.vertex, cur_vertex, cur_pair.edge));
+        }
+    }
+
+public:
+    class ProcessedVerticesView {
+        const storage_t &storage_;
+    public:
+        ProcessedVerticesView(const storage_t &storage)
+                : storage_(storage) {}
+
+        auto begin() const { return storage_.processed_vertices().begin(); }
+        auto end() const { return storage_.processed_vertices().end(); }
+        size_t size() const { return storage_.processed_vertices().size(); }
+        size_t count(VertexId v) const { return storage_.processed(v); }
+    };
+
+    RadixHeapDijkstra(const Graph &graph, DijkstraSettings settings,
+                      size_t max_vertex_number = size_t(-1),
+                      bool collect_traceback = false)
+            : graph_(graph),
+              settings_(settings),
+              max_vertex_number_(max_vertex_number),
+              collect_traceback_(collect_traceback),
+              finished_(false),
+              vertex_number_(0),
+              vertex_limit_exceeded_(false),
+              storage_(pool_t::Acquire()) {
+        static_assert(std::is_unsigned<distance_t>::value, "radix heap dijkstra requires unsigned distances");
+    }
+
+    RadixHeapDijkstra(RadixHeapDijkstra&& /*other*/) = default;
+    RadixHeapDijkstra& operator=(RadixHeapDijkstra&& /*other*/) = default;
+
+    RadixHeapDijkstra(const RadixHeapDijkstra& /*other*/) = delete;
+    RadixHeapDijkstra& operator=(const RadixHeapDijkstra& /*other*/) = delete;
+
+    bool finished() const {
+        return finished_;
+    }
+
+    bool DistanceCounted(VertexId vertex) const {
+        return storage_->reached(vertex);
+    }
+
+    distance_t GetDistance(VertexId vertex) const {
+        VERIFY(DistanceCounted(vertex));
+        return storage_->distance(vertex);
+    }
+
+    void Run(VertexId start) {
+        TRACE("Starting dijkstra run from vertex " << graph_.str(start));
+        Init(start);
+        auto &queue = storage_->queue();
+
+        while (!queue.empty() && !finished()) {
+            distance_t distance = queue.top_key();
+            queue_element next = queue.top().second;
+            queue.pop();
+
+            VertexId vertex = next.curr_vertex;
+            if (DistanceCounted(vertex))
+                continue;
+
+            storage_->reach(vertex, distance);
+            if (collect_traceback_)
+                storage_->set_traceback(vertex, next.prev_vertex, next.edge_between);
+
+            if (!CheckProcessVertex(vertex, distance))
+                continue;
+
+            storage_->process(vertex);
+            AddNeighboursToQueue(vertex, distance);
+        }
+        set_finished(true);
+    }
+
+    std::vector<EdgeId> GetShortestPathTo(VertexId vertex) {
+        VERIFY_MSG(collect_traceback_, "GetShortestPathTo() is available only if traceback is collected");
+        std::vector<EdgeId> path;
+        if (!storage_->has_traceback(vertex))
+            return path;
+
+        const auto *prev_v_e = &storage_->traceback(vertex);
+        while (prev_v_e->first != VertexId()) {
+            EdgeId edge = prev_v_e->second;
+            if (graph_.EdgeStart(edge) == prev_v_e->first)
+                path.push_back(edge);
+            else
+                path.insert(path.begin(), edge);
+            prev_v_e = &storage_->traceback(prev_v_e->first);
+        }
+        // Edges were collected from the end
+        std::reverse(path.begin(), path.end());
+        return path;
+    }
+
+    std::vector<VertexId> ReachedVertices() const {
+        std::vector<VertexId> result(storage_->reached_vertices());
+        std::sort(result.begin(), result.end());
+
+        return result;
+    }
+
+    ProcessedVerticesView ProcessedVertices() const {
+        return ProcessedVerticesView(*storage_);
+    }
+
+    bool VertexLimitExceeded() const {
+        return vertex_limit_exceeded_;
+    }
+
+private:
+    DECL_LOGGER("Dijkstra");
+};
+
 template<class Graph>
 class DistanceCounter {
   typedef typename Graph::VertexId VertexId;
@@ -260,10 +546,10 @@ public:
     graph_(graph),
     dijkstra_(graph,
               BaseDijkstraSettings(
-                  LengthCalculator<Graph>(),
+                  LengthCalculator<Graph>(graph),
                   VertexProcessChecker<Graph>(),
                   VertexPutChecker<Graph>(),
-                  ForwardNeighbourIteratorFactory<Graph>())),
+                  ForwardNeighbourIteratorFactory<Graph>(graph))),
     ready_(false) {
   }
 
@@ -280,14 +566,14 @@ public:
 private:
   void EnsureFrom(VertexId from) {
     if (!ready_ || prev_ != from) {
-      dijkstra_.run(from);
+      dijkstra_.Run(from);
       ready_ = true;
       prev_ = from;
     }
   }
 
   const Graph& graph_;
-  Dijkstra<Graph, BaseDijkstraSettings> dijkstra_;
+  RadixHeapDijkstra<Graph, BaseDijkstraSettings> dijkstra_;
   VertexId prev_;
   bool ready_;
 };
@@ -10,12 +10,15 @@
 
 namespace omnigraph {
 
-template<class Graph>
+// DijkstraImpl allows to switch all the searches below to another engine with
+// the same settings interface, e.g. DijkstraHelper<Graph, RadixHeapDijkstra>
+template<class Graph,
+         template<class, class, typename = size_t> class DijkstraImpl = Dijkstra>
 class DijkstraHelper {
       typedef typename Graph::VertexId VertexId;
       typedef typename Graph::EdgeId EdgeId;
 public:
-    typedef Dijkstra<Graph, ComposedDijkstraSettings<Graph,
+    typedef DijkstraImpl<Graph, ComposedDijkstraSettings<Graph,
             LengthCalculator<Graph>,
                 VertexProcessChecker<Graph>,
                 VertexPutChecker<Graph>,
@@ -23,7 +26,7 @@ public:
 
     //------------------------------
 
-    typedef Dijkstra<Graph, ComposedDijkstraSettings<Graph,
+    typedef DijkstraImpl<Graph, ComposedDijkstraSettings<Graph,
             LengthCalculator<Graph>,
               VertexProcessChecker<Graph>,
               VertexPutChecker<Graph>,
@@ -38,7 +41,7 @@ public:
             BoundPutChecker<Graph>,
             ForwardNeighbourIteratorFactory<Graph> > BoundedDijkstraSettings;
 
-    typedef Dijkstra<Graph, BoundedDijkstraSettings> BoundedDijkstra;
+    typedef DijkstraImpl<Graph, BoundedDijkstraSettings> BoundedDijkstra;
 
     static BoundedDijkstra CreateBoundedDijkstra(const Graph &graph, size_t length_bound,
                                                  size_t max_vertex_number = -1ul,
@@ -63,7 +66,7 @@ public:
             BoundPutChecker<Graph>,
             BackwardNeighbourIteratorFactory<Graph> > BackwardBoundedDijkstraSettings;
 
-    typedef Dijkstra<Graph, BackwardBoundedDijkstraSettings> BackwardBoundedDijkstra;
+    typedef DijkstraImpl<Graph, BackwardBoundedDijkstraSettings> BackwardBoundedDijkstra;
 
     static BackwardBoundedDijkstra
     CreateBackwardBoundedDijkstra(const Graph &graph,
@@ -82,21 +85,21 @@ public:
 
     //------------------------------
 
-    typedef Dijkstra<Graph, ComposedDijkstraSettings<Graph,
+    typedef DijkstraImpl<Graph, ComposedDijkstraSettings<Graph,
             LengthCalculator<Graph>,
             VertexProcessChecker<Graph>,
             EdgeComponentPutChecker<Graph>,
             UnorientedNeighbourIteratorFactory<Graph> > > ComponentFinder;
     //------------------------------
 
-    typedef Dijkstra<Graph, ComposedDijkstraSettings<Graph,
+    typedef DijkstraImpl<Graph, ComposedDijkstraSettings<Graph,
             ComponentLenCalculator<Graph>,
             BoundProcessChecker<Graph>,
             VertexPutChecker<Graph>,
             UnorientedNeighbourIteratorFactory<Graph> > > NeighbourhoodFinder;
     //------------------------------
 
-    typedef Dijkstra<Graph, ComposedDijkstraSettings<Graph,
+    typedef DijkstraImpl<Graph, ComposedDijkstraSettings<Graph,
             LengthCalculator<Graph>,
             VertexProcessChecker<Graph>,
             SubgraphPutChecker<Graph>,
@@ -118,7 +121,7 @@ public:
             VertexPutChecker<Graph>,
             UnorientedNeighbourIteratorFactory<Graph> > ShortEdgeDijkstraSettings;
 
-    typedef Dijkstra<Graph, ShortEdgeDijkstraSettings> ShortEdgeDijkstra;
+    typedef DijkstraImpl<Graph, ShortEdgeDijkstraSettings> ShortEdgeDijkstra;
 
     static ShortEdgeDijkstra CreateShortEdgeDijkstra(const Graph &graph, size_t edge_length_bound,
                                                      size_t max_vertex_number = size_t(-1),
@@ -139,7 +142,7 @@ public:
     typedef CountingDijkstraSettings<Graph,
             UnorientedNeighbourIteratorFactory<Graph> > UnorientCountingDijkstraSettings;
 
-    typedef Dijkstra<Graph, UnorientCountingDijkstraSettings> CountingDijkstra;
+    typedef DijkstraImpl<Graph, UnorientCountingDijkstraSettings> CountingDijkstra;
 
     static CountingDijkstra CreateCountingDijkstra(const Graph &graph, size_t max_size,
                                                    size_t edge_length_bound,
@@ -165,7 +168,7 @@ public:
             BoundPutChecker<Graph>,
             ForwardNeighbourIteratorFactory<Graph> > TargetedBoundedDijkstraSettings;
 
-    typedef Dijkstra<Graph, TargetedBoundedDijkstraSettings> TargetedBoundedDijkstra;
+    typedef DijkstraImpl<Graph, TargetedBoundedDijkstraSettings> TargetedBoundedDijkstra;
 
     static TargetedBoundedDijkstra CreateTargetedBoundedDijkstra(const Graph &graph,
                                                                  VertexId target_vertex, size_t bound,
@@ -188,7 +191,7 @@ public:
             CoveragePutChecker<Graph>,
             ForwardNeighbourIteratorFactory<Graph> > CoverageBoundedDijkstraSettings;
 
-    typedef Dijkstra<Graph, CoverageBoundedDijkstraSettings> CoverageBoundedDijkstra;
+    typedef DijkstraImpl<Graph, CoverageBoundedDijkstraSettings> CoverageBoundedDijkstra;
 
     static CoverageBoundedDijkstra CreateCoverageBoundedDijkstra(const Graph &graph, size_t length_bound, double min_coverage,
                                                                  size_t max_vertex_number = -1ul, bool collect_traceback = false) {
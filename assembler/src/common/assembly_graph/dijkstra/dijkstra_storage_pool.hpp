@@ -0,0 +1,122 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+#pragma once
+
+#include <memory>
+#include <mutex>
+#include <unordered_set>
+#include <vector>
+
+namespace omnigraph {
+
+namespace details {
+
+class DijkstraStoragePoolBase {
+public:
+    virtual void Clear() = 0;
+
+protected:
+    ~DijkstraStoragePoolBase() = default;
+};
+
+// Pools of all threads, so that their storages can be released from one place
+class DijkstraStoragePools {
+    std::mutex lock_;
+    std::unordered_set<DijkstraStoragePoolBase*> pools_;
+
+public:
+    static DijkstraStoragePools &instance() {
+        static DijkstraStoragePools pools;
+        return pools;
+    }
+
+    void Register(DijkstraStoragePoolBase *pool) {
+        std::lock_guard<std::mutex> lock(lock_);
+        pools_.insert(pool);
+    }
+
+    void Unregister(DijkstraStoragePoolBase *pool) {
+        std::lock_guard<std::mutex> lock(lock_);
+        pools_.erase(pool);
+    }
+
+    void Clear() {
+        std::lock_guard<std::mutex> lock(lock_);
+        for (auto *pool : pools_)
+            pool->Clear();
+    }
+};
+
+}
+
+// Thread-local free list of Dijkstra storages. Several searches could be alive
+// within a thread at the same time (e.g. forward and backward ones), so every
+// search owns its storage and returns it to the pool of the current thread on
+// destruction. A pool keeps at most MAX_FREE storages, the rest are freed.
+template<class Storage>
+class DijkstraStoragePool : public details::DijkstraStoragePoolBase {
+    enum : size_t { MAX_FREE = 4 };
+
+    std::mutex lock_;
+    std::vector<std::unique_ptr<Storage>> free_;
+
+    DijkstraStoragePool() {
+        details::DijkstraStoragePools::instance().Register(this);
+    }
+
+    ~DijkstraStoragePool() {
+        details::DijkstraStoragePools::instance().Unregister(this);
+    }
+
+    static DijkstraStoragePool &instance() {
+        static thread_local DijkstraStoragePool pool;
+        return pool;
+    }
+
+    void Put(Storage *storage) {
+        std::unique_ptr<Storage> ptr(storage);
+        std::lock_guard<std::mutex> lock(lock_);
+        if (free_.size() < MAX_FREE)
+            free_.push_back(std::move(ptr));
+    }
+
+    std::unique_ptr<Storage> Take() {
+        std::lock_guard<std::mutex> lock(lock_);
+        if (free_.empty())
+            return nullptr;
+
+        auto res = std::move(free_.back());
+        free_.pop_back();
+        return res;
+    }
+
+public:
+    struct Releaser {
+        void operator()(Storage *storage) const {
+            instance().Put(storage);
+        }
+    };
+    typedef std::unique_ptr<Storage, Releaser> pointer;
+
+    static pointer Acquire() {
+        auto storage = instance().Take();
+        return pointer(storage ? storage.release() : new Storage());
+    }
+
+    void Clear() override {
+        std::lock_guard<std::mutex> lock(lock_);
+        free_.clear();
+    }
+};
+
+// Frees the storages kept by the pools of all threads, e.g. when the graph the
+// storages were sized for is about to change a lot. The searches alive at the
+// moment keep their storages and return them to the pools as usual.
+inline void ReleaseDijkstraStorages() {
+    details::DijkstraStoragePools::instance().Clear();
+}
+
+}
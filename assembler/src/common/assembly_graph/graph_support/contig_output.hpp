@@ -9,27 +9,37 @@
 
 #include "assembly_graph/core/graph.hpp"
 #include "io/reads/osequencestream.hpp"
+#include "io/utils/ordered_writer.hpp"
+
+#include <fstream>
 
 namespace debruijn_graph {
 
 inline void OutputEdgeSequences(const Graph &g, const std::string &contigs_output_filename) {
     INFO("Outputting contigs to " << contigs_output_filename << ".fasta");
-    io::osequencestream_cov oss(contigs_output_filename + ".fasta");
+    std::ofstream os(contigs_output_filename + ".fasta");
 
-    for (EdgeId e: g.canonical_edges()) {
-        oss << g.coverage(e);
-        oss << g.EdgeNucls(e).str();
-    }
+    std::vector<EdgeId> edges(g.canonical_edges().begin(), g.canonical_edges().end());
+    // Same format as io::osequencestream_cov
+    io::WriteOrdered(os, edges.size(), [&](size_t i, std::ostream &out) {
+        EdgeId e = edges[i];
+        std::string s = g.EdgeNucls(e).str();
+        out << ">" << io::MakeContigId(i + 1, s.size(), g.coverage(e)) << std::endl;
+        io::WriteWrapped(s, out);
+    });
 }
 
 inline void OutputEdgesByID(const Graph &g,
                             const std::string &contigs_output_filename) {
     INFO("Outputting contigs to " << contigs_output_filename << ".fasta");
-    io::OFastaReadStream oss(contigs_output_filename + ".fasta");
-    for (EdgeId e: g.canonical_edges()) {
+    std::ofstream os(contigs_output_filename + ".fasta");
+
+    std::vector<EdgeId> edges(g.canonical_edges().begin(), g.canonical_edges().end());
+    io::WriteOrdered(os, edges.size(), [&](size_t i, std::ostream &out) {
+        EdgeId e = edges[i];
         std::string s = g.EdgeNucls(e).str();
-        oss << io::SingleRead(io::MakeContigId(g.int_id(e), s.size(), g.coverage(e), "EDGE"), s);
-    }
+        io::FastaWriter::Write(out, io::SingleRead(io::MakeContigId(g.int_id(e), s.size(), g.coverage(e), "EDGE"), s));
+    });
 }
 } // namespace debruijn_graph
 
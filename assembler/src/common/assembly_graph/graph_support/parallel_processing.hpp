@@ -88,6 +88,7 @@ public:
 
         #pragma omp parallel for schedule(guided)
         for (size_t i = 0; i < chunk_iterators.size() - 1; ++i) {
+            TIME_TRACE_THREAD_SCOPE("FindInterestingFromChunkIterators chunk");
             DEBUG("Processing chunk " << i << " by thread " << omp_get_thread_num());
             size_t cnt = 0;
             for (auto it = chunk_iterators[i], end = chunk_iterators[i + 1]; it != end; ++it) {
@@ -201,7 +201,7 @@ public:
   template<class Writer>
   void BinWrite(Writer &writer) const {
       this->index_ptr_->serialize(writer);
-      size_t sz = this->data_.size();
+      size_t sz = this->size();
       writer.write((char*)&sz, sizeof(sz));
       this->BinWriteKmers(writer);
   }
@@ -212,7 +212,7 @@ public:
       this->index_ptr_->deserialize(reader);
       size_t sz = 0;
       reader.read((char*)&sz, sizeof(sz));
-      this->data_.resize(sz);
+      this->resize(sz);
       this->BinReadKmers(reader, FileName);
   }
 
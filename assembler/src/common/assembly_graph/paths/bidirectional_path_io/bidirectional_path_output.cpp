@@ -6,6 +6,8 @@
 
 #include "bidirectional_path_output.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
+
 namespace path_extend {
 
 void path_extend::ContigWriter::OutputPaths(const PathContainer &paths, const std::vector<PathsWriterT> &writers) const {
@@ -13,16 +15,25 @@ void path_extend::ContigWriter::OutputPaths(const PathContainer &paths, const st
 
     ScaffoldSequenceMaker scaffold_maker(g_);
     DEBUG("started" << paths.size());
+    std::vector<const BidirectionalPath*> nonempty;
     for (auto iter = paths.begin(); iter != paths.end(); ++iter) {
         const BidirectionalPath &path = iter.get();
         DEBUG("path: " <<  path.Length());
         if (path.Length() <= 0)
             continue;
-        auto path_string = scaffold_maker.MakeSequence(path);
-        if (path_string.length() >= g_.k()) {
-            storage.emplace_back(path_string, &path);
+        nonempty.push_back(&path);
+    }
+
+    // Sequences are formed in parallel, the storage keeps the order of the container
+    std::vector<std::string> path_strings(nonempty.size());
+#   pragma omp parallel for schedule(guided)
+    for (size_t i = 0; i < nonempty.size(); ++i)
+        path_strings[i] = scaffold_maker.MakeSequence(*nonempty[i]);
+
+    for (size_t i = 0; i < nonempty.size(); ++i) {
+        if (path_strings[i].length() >= g_.k()) {
+            storage.emplace_back(std::move(path_strings[i]), nonempty[i]);
         }
-        DEBUG("over");
     }
     DEBUG("sort");
     //sorting by length and coverage
@@ -10,6 +10,7 @@
 #include "io/utils/edge_namer.hpp"
 #include "io/graph/gfa_writer.hpp"
 #include "io/graph/fastg_writer.hpp"
+#include "io/utils/ordered_writer.hpp"
 #include "io_support.hpp"
 
 namespace path_extend {
@@ -54,12 +55,13 @@ public:
 
     void WritePaths(const ScaffoldStorage &scaffold_storage, const std::string &fn) const {
         std::ofstream os(fn);
-        for (const auto& scaffold_info : scaffold_storage) {
-            os << scaffold_info.name << "\n"
-               << path_writer_.ToPathString(*scaffold_info.path) << "\n"
-               << scaffold_info.name << "'" << "\n"
-               << path_writer_.ToPathString(*scaffold_info.path->GetConjPath()) << "\n";
-        }
+        io::WriteOrdered(os, scaffold_storage.size(), [&](size_t i, std::ostream &out) {
+            const auto &scaffold_info = scaffold_storage[i];
+            out << scaffold_info.name << "\n"
+                << path_writer_.ToPathString(*scaffold_info.path) << "\n"
+                << scaffold_info.name << "'" << "\n"
+                << path_writer_.ToPathString(*scaffold_info.path->GetConjPath()) << "\n";
+        });
     }
 
   private:
@@ -68,20 +70,21 @@ public:
 
 
 class GFAPathWriter : public gfa::GFAWriter {
-    void WritePath(const std::string &name, size_t segment_id,
-                   const std::vector<std::string> &edge_strs,
-                   const std::string &flags) {
-        os_ << "P" << "\t" ;
-        os_ << name << "_" << segment_id << "\t";
+    static void WritePath(const std::string &name, size_t segment_id,
+                          const std::vector<std::string> &edge_strs,
+                          const std::string &flags,
+                          std::ostream &os) {
+        os << "P" << "\t" ;
+        os << name << "_" << segment_id << "\t";
         std::string delimeter = "";
         for (const auto& e : edge_strs) {
-            os_ << delimeter << e;
+            os << delimeter << e;
             delimeter = ",";
         }
-        os_ << "\t*";
+        os << "\t*";
         if (flags.length())
-            os_ << "\t" << flags;
-        os_ << "\n";
+            os << "\t" << flags;
+        os << "\n";
     }
 
 public:
@@ -96,21 +99,22 @@ public:
             EdgeId e = edges[i];
             segmented_path.push_back(edge_namer_.EdgeOrientationString(e));
             if (graph_.EdgeEnd(e) != graph_.EdgeStart(edges[i+1])) {
-                WritePath(name, segment_id, segmented_path, flags);
+                WritePath(name, segment_id, segmented_path, flags, os_);
                 segment_id++;
                 segmented_path.clear();
             }
         }
 
         segmented_path.push_back(edge_namer_.EdgeOrientationString(edges.back()));
-        WritePath(name, segment_id, segmented_path, flags);
+        WritePath(name, segment_id, segmented_path, flags, os_);
     }
 
     void WritePaths(const ScaffoldStorage &scaffold_storage) {
-        for (const auto& scaffold_info : scaffold_storage) {
+        io::WriteOrdered(os_, scaffold_storage.size(), [&](size_t idx, std::ostream &os) {
+            const auto &scaffold_info = scaffold_storage[idx];
             const path_extend::BidirectionalPath &p = *scaffold_info.path;
             if (p.Size() == 0) {
-                continue;
+                return;
             }
             std::vector<std::string> segmented_path;
             //size_t id = p.GetId();
@@ -119,15 +123,15 @@ public:
                 EdgeId e = p[i];
                 segmented_path.push_back(edge_namer_.EdgeOrientationString(e));
                 if (graph_.EdgeEnd(e) != graph_.EdgeStart(p[i+1]) || p.GapAt(i+1).gap > 0) {
-                    WritePath(scaffold_info.name, segment_id, segmented_path, "");
+                    WritePath(scaffold_info.name, segment_id, segmented_path, "", os);
                     segment_id++;
                     segmented_path.clear();
                 }
             }
 
             segmented_path.push_back(edge_namer_.EdgeOrientationString(p.Back()));
-            WritePath(scaffold_info.name, segment_id, segmented_path, "");
-        }
+            WritePath(scaffold_info.name, segment_id, segmented_path, "", os);
+        });
     }
 };
 
@@ -139,13 +143,12 @@ class ContigWriter {
 
 public:
     static void WriteScaffolds(const ScaffoldStorage &scaffold_storage, const std::string &fn) {
-        io::OFastaReadStream oss(fn);
-        std::ofstream os_fastg;
-
-        for (const auto& scaffold_info : scaffold_storage) {
+        std::ofstream os(fn);
+        io::WriteOrdered(os, scaffold_storage.size(), [&](size_t i, std::ostream &out) {
+            const auto &scaffold_info = scaffold_storage[i];
             TRACE("Scaffold " << scaffold_info.name << " originates from path " << scaffold_info.path->str());
-            oss << io::SingleRead(scaffold_info.name, scaffold_info.sequence);
-        }
+            io::FastaWriter::Write(out, io::SingleRead(scaffold_info.name, scaffold_info.sequence));
+        });
     }
 
     static PathsWriterT BasicFastaWriter(const std::string &fn) {
@@ -68,16 +68,16 @@ void path_extend::TranscriptToGeneJoiner::Construct(const PathContainer &paths)
     GraphCoverageMap edges_coverage(g_, paths);
 
     DEBUG("Union trees");
-    //  For all edges in coverage map
-    for (const auto &entry : edges_coverage) {
+    //  For all edges covered by paths
+    for (EdgeId edge : g_.edges()) {
         // Select a path covering an edge
-        EdgeId edge = entry.first;
-        auto &edge_paths = entry.second;
+        auto edge_paths = edges_coverage.GetEdgePaths(edge);
+        size_t path_cnt = edges_coverage.GetCoverage(edge);
 
-        if (g_.length(edge) <= min_edge_len_ || edge_paths.size() <= 1)
+        if (g_.length(edge) <= min_edge_len_ || path_cnt <= 1)
             continue;
 
-        DEBUG("Long edge " << edge.int_id() << " Paths " << edge_paths.size());
+        DEBUG("Long edge " << edge.int_id() << " Paths " << path_cnt);
         // For all other paths covering this edge join then into single gene with the first path
         for (auto it_edge = std::next(edge_paths.begin()); it_edge != edge_paths.end(); ++it_edge) {
             size_t first = path_id_[edge_paths.begin()->first->GetId()];
@@ -31,7 +31,9 @@ class PathProcessor {
     typedef typename Graph::EdgeId EdgeId;
     typedef typename Graph::VertexId VertexId;
     typedef std::vector<EdgeId> Path;
-    typedef typename DijkstraHelper<Graph>::BoundedDijkstra DijkstraT;
+    // Path processors are created in large numbers for short bounded searches
+    typedef DijkstraHelper<Graph, RadixHeapDijkstra> DijkstraHelperT;
+    typedef typename DijkstraHelperT::BoundedDijkstra DijkstraT;
 public:
     class Callback {
 
@@ -188,8 +190,8 @@ public:
                   size_t dijkstra_vertex_limit = MAX_DIJKSTRA_VERTICES) :
               g_(g),
               start_(start),
-              dijkstra_(DijkstraHelper<Graph>::CreateBoundedDijkstra(g, length_bound,
-                                                                     dijkstra_vertex_limit)) {
+              dijkstra_(DijkstraHelperT::CreateBoundedDijkstra(g, length_bound,
+                                                               dijkstra_vertex_limit)) {
         //TIME_TRACE_SCOPE("PathProcessor:Dijkstra");
         TRACE("Dijkstra launched");
         dijkstra_.Run(start);
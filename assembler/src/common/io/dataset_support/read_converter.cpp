@@ -147,13 +147,14 @@ void ConvertIfNeeded(DataSet<LibraryData> &data, unsigned nthreads) {
 BinaryPairedStreams paired_binary_readers(SequencingLibraryT &lib,
                                           bool followed_by_rc,
                                           size_t insert_size,
-                                          bool include_merged) {
+                                          bool include_merged,
+                                          size_t split_factor) {
     const auto& data = lib.data();
     CHECK_FATAL_ERROR(data.binary_reads_info.binary_converted,
             "Lib was not converted to binary, cannot produce binary stream");
 
     ReadStreamList<PairedReadSeq> paired_streams;
-    const size_t n = data.binary_reads_info.chunk_num;
+    const size_t n = data.binary_reads_info.chunk_num * split_factor;
 
     for (size_t i = 0; i < n; ++i) {
         ReadStream<PairedReadSeq> stream{BinaryFilePairedStream(data.binary_reads_info.paired_read_prefix,
@@ -177,13 +178,14 @@ BinaryPairedStreams paired_binary_readers(SequencingLibraryT &lib,
 
 BinarySingleStreams single_binary_readers(SequencingLibraryT &lib,
                                           bool followed_by_rc,
-                                          bool including_paired_and_merged) {
+                                          bool including_paired_and_merged,
+                                          size_t split_factor) {
     const auto& data = lib.data();
     CHECK_FATAL_ERROR(data.binary_reads_info.binary_converted,
                "Lib was not converted to binary, cannot produce binary stream");
 
     BinarySingleStreams single_streams;
-    const size_t n = data.binary_reads_info.chunk_num;
+    const size_t n = data.binary_reads_info.chunk_num * split_factor;
 
     for (size_t i = 0; i < n; ++i)
         single_streams.push_back(BinaryFileSingleStream(data.binary_reads_info.single_read_prefix,
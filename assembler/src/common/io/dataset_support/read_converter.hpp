@@ -38,13 +38,17 @@ public:
 
 void ConvertIfNeeded(DataSet<LibraryData> &data, unsigned nthreads);
 
+// Each of chunk_num portions of the converted reads is further split into split_factor streams,
+// so that consumers dispatching the streams dynamically are able to balance the load
 BinaryPairedStreams paired_binary_readers(SequencingLibraryT &lib,
                                           bool followed_by_rc,
                                           size_t insert_size,
-                                          bool include_merged);
+                                          bool include_merged,
+                                          size_t split_factor = 1);
 BinarySingleStreams single_binary_readers(SequencingLibraryT &lib,
                                           bool followed_by_rc,
-                                          bool including_paired_and_merged);
+                                          bool including_paired_and_merged,
+                                          size_t split_factor = 1);
 
 BinarySingleStreams single_binary_readers_for_libs(DataSet<LibraryData>& dataset_info,
                                                    const std::vector<size_t>& libs,
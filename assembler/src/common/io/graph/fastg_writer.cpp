@@ -9,6 +9,7 @@
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/core/graph_iterators.hpp"
 #include "common/io/reads/osequencestream.hpp"
+#include "common/io/utils/ordered_writer.hpp"
 
 #include <set>
 #include <string>
@@ -33,15 +34,19 @@ static std::string FormHeader(const std::string &id,
 }
 
 void FastgWriter::WriteSegmentsAndLinks() {
-    io::OFastaReadStream os(fn_);
-    for (auto it = graph_.ConstEdgeBegin(); !it.IsEnd(); ++it) {
-        EdgeId e = *it;
+    std::ofstream os(fn_);
+    std::vector<EdgeId> edges;
+    for (auto it = graph_.ConstEdgeBegin(); !it.IsEnd(); ++it)
+        edges.push_back(*it);
+
+    io::WriteOrdered(os, edges.size(), [&](size_t i, std::ostream &out) {
+        EdgeId e = edges[i];
         std::set<std::string> next;
         for (EdgeId next_e : graph_.OutgoingEdges(graph_.EdgeEnd(e))) {
             next.insert(extended_namer_.EdgeOrientationString(next_e));
         }
-        os << io::SingleRead(FormHeader(extended_namer_.EdgeOrientationString(e), next),
-                             graph_.EdgeNucls(e).str());
-    }
+        io::FastaWriter::Write(out, io::SingleRead(FormHeader(extended_namer_.EdgeOrientationString(e), next),
+                                                   graph_.EdgeNucls(e).str()));
+    });
 }
 
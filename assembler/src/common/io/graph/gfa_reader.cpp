@@ -9,42 +9,440 @@
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/core/construction_helper.hpp"
 
+#include "io/kmers/mmapped_reader.hpp"
 #include "io/utils/id_mapper.hpp"
+#include "utils/filesystem/path_helper.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
-#include "gfa1/gfa.h"
+#include <boost/functional/hash.hpp>
+#include <boost/utility/string_ref.hpp>
+#include <parallel_hashmap/phmap.h>
+#include <zlib.h>
 
+#include <algorithm>
+#include <cctype>
+#include <limits>
 #include <string>
 #include <memory>
 #include <vector>
-#include <unordered_set>
 
 using namespace debruijn_graph;
 
 namespace gfa {
 
-GFAReader::GFAReader()
-        : gfa_(nullptr, gfa_destroy) {}
-GFAReader::GFAReader(const std::string &filename)
-        : gfa_(gfa_read(filename.c_str()), gfa_destroy) {}
+namespace {
+
+typedef boost::string_ref StrRef;
+
+struct StrRefHash {
+    size_t operator()(StrRef s) const {
+        return boost::hash_range(s.begin(), s.end());
+    }
+};
+
+static constexpr int32_t NO_OVERLAP = std::numeric_limits<int32_t>::max();
+
+// Raw records of a single chunk of the file, fields point into the file buffer
+struct RawSegment {
+    StrRef name, seq;
+    int32_t kc;
+};
+
+struct RawLink {
+    StrRef from, to;
+    bool from_rc, to_rc;
+    int32_t ov, ow;
+};
+
+struct RawPath {
+    StrRef name, segments;
+};
+
+struct RawChunk {
+    std::vector<RawSegment> segments;
+    std::vector<RawLink> links;
+    std::vector<RawPath> paths;
+    size_t invalid = 0;
+};
+
+// Splits [begin, end) by the delimiter
+static size_t Split(const char *begin, const char *end, char delim,
+                    StrRef *fields, size_t max_fields) {
+    size_t n = 0;
+    const char *p = begin;
+    while (n < max_fields) {
+        const char *q = std::find(p, end, delim);
+        fields[n++] = StrRef(p, q - p);
+        if (q == end)
+            break;
+        p = q + 1;
+    }
+    return n;
+}
+
+static bool IsDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+static long ParseLong(const char *&p, const char *end) {
+    bool neg = false;
+    if (p != end && (*p == '-' || *p == '+'))
+        neg = (*p++ == '-');
+    long res = 0;
+    for (; p != end && IsDigit(*p); ++p)
+        res = res * 10 + (*p - '0');
+    return neg ? -res : res;
+}
+
+// Overlap field of L-line, same rules as in gfa1: either CIGAR or "ov:ow"
+static bool ParseOverlap(StrRef f, int32_t &ov, int32_t &ow) {
+    const char *q = f.begin(), *end = f.end();
+    ov = ow = NO_OVERLAP;
+    if (q != end && *q == ':') {
+        ++q;
+        if (q != end && IsDigit(*q))
+            ow = int32_t(ParseLong(q, end));
+        return true;
+    }
+    if (q == end || !IsDigit(*q))
+        return false;
+
+    const char *r = q;
+    long l = ParseLong(r, end);
+    if (r != end && std::isupper(*r)) {
+        ov = ow = 0;
+        do {
+            l = ParseLong(q, end);
+            char op = q != end ? *q : 0;
+            if (op == 'M' || op == 'D' || op == 'N') ov += int32_t(l);
+            if (op == 'M' || op == 'I' || op == 'S') ow += int32_t(l);
+            if (q != end)
+                ++q;
+        } while (q != end && IsDigit(*q));
+        return true;
+    }
+    if (r != end && *r == ':') {
+        ov = int32_t(l);
+        ++r;
+        if (r != end && IsDigit(*r))
+            ow = int32_t(ParseLong(r, end));
+        return true;
+    }
+    return false;
+}
+
+static bool ParseOrientation(StrRef f, bool &rc) {
+    if (f.empty() || (f[0] != '+' && f[0] != '-'))
+        return false;
+    rc = f[0] == '-';
+    return true;
+}
+
+static void ParseLine(const char *begin, const char *end, RawChunk &chunk) {
+    if (end != begin && end[-1] == '\r')
+        --end;
+    if (end - begin < 3 || begin[1] != '\t')
+        return;
+
+    StrRef f[6];
+    char type = begin[0];
+    if (type == 'S') {
+        size_t n = Split(begin + 2, end, '\t', f, 3);
+        if (n < 2) {
+            chunk.invalid += 1;
+            return;
+        }
+        RawSegment seg{f[0], f[1], 0};
+        if (n == 3) {
+            // Optional tags, only KC is used
+            const char *p = f[2].begin();
+            while (p < end) {
+                const char *q = std::find(p, end, '\t');
+                if (q - p >= 5 && p[0] == 'K' && p[1] == 'C' && p[2] == ':' && p[3] == 'i' && p[4] == ':') {
+                    const char *v = p + 5;
+                    seg.kc = int32_t(ParseLong(v, q));
+                }
+                p = q + 1;
+            }
+        }
+        chunk.segments.push_back(seg);
+    } else if (type == 'L') {
+        RawLink link;
+        if (Split(begin + 2, end, '\t', f, 6) < 5 ||
+            !ParseOrientation(f[1], link.from_rc) || !ParseOrientation(f[3], link.to_rc) ||
+            !ParseOverlap(f[4], link.ov, link.ow)) {
+            chunk.invalid += 1;
+            return;
+        }
+        link.from = f[0];
+        link.to = f[2];
+        chunk.links.push_back(link);
+    } else if (type == 'P') {
+        if (Split(begin + 2, end, '\t', f, 4) < 3) {
+            chunk.invalid += 1;
+            return;
+        }
+        chunk.paths.push_back({ f[0], f[1] });
+    }
+}
+
+static void ParseChunk(const char *begin, const char *end, RawChunk &chunk) {
+    while (begin < end) {
+        const char *eol = std::find(begin, end, '\n');
+        ParseLine(begin, eol, chunk);
+        begin = eol + 1;
+    }
+}
+
+// The whole file: either mapped or, if compressed, inflated into memory
+class GFABuffer {
+  public:
+    GFABuffer(const std::string &filename)
+            : reader_(filename, false, -1ULL) {
+        const char *data = static_cast<const char*>(reader_.data());
+        size_t size = reader_.size();
+        if (size < 2 || (uint8_t)data[0] != 0x1f || (uint8_t)data[1] != 0x8b) {
+            data_ = data;
+            size_ = size;
+            return;
+        }
+
+        gzFile fp = gzopen(filename.c_str(), "r");
+        VERIFY_MSG(fp, "Failed to open " << filename);
+        char buf[1 << 16];
+        int len;
+        while ((len = gzread(fp, buf, sizeof(buf))) > 0)
+            inflated_.append(buf, len);
+        VERIFY_MSG(len == 0, "Failed to decompress " << filename);
+        gzclose(fp);
+        data_ = inflated_.data();
+        size_ = inflated_.size();
+    }
+
+    const char *data() const { return data_; }
+    size_t size() const { return size_; }
+
+  private:
+    MMappedReader reader_;
+    std::string inflated_;
+    const char *data_;
+    size_t size_;
+};
+
+}
+
+struct GFAReader::Storage {
+    // Arc between oriented segments (id << 1 | rc), the same as in gfa1
+    struct Arc {
+        uint32_t v, w;
+        int32_t ov, ow;
+        bool del, comp;
+    };
+
+    std::vector<std::string> names;
+    std::vector<Sequence> seqs;
+    std::vector<unsigned> coverage;
+
+    // Arcs sorted by the source, outgoing arcs of v are [arc_idx[v], arc_idx[v + 1])
+    std::vector<Arc> arcs;
+    std::vector<size_t> arc_idx;
+
+    std::vector<std::pair<std::string, std::vector<uint32_t>>> paths;
+
+    void IndexArcs() {
+        std::stable_sort(arcs.begin(), arcs.end(),
+                         [](const Arc &a, const Arc &b) { return a.v < b.v; });
+        arc_idx.assign(2 * names.size() + 1, 0);
+        for (const Arc &a : arcs)
+            arc_idx[a.v + 1] += 1;
+        for (size_t v = 0; v + 1 < arc_idx.size(); ++v)
+            arc_idx[v + 1] += arc_idx[v];
+    }
+
+    Arc *arcs_begin(uint32_t v) { return arcs.data() + arc_idx[v]; }
+    Arc *arcs_end(uint32_t v) { return arcs.data() + arc_idx[v + 1]; }
+
+    // Infers the missing overlaps from the complementary arcs (gfa_fix_semi_arc)
+    void FixSemiArcs() {
+        for (uint32_t v = 0; v < 2 * names.size(); ++v) {
+            for (Arc *a = arcs_begin(v); a != arcs_end(v); ++a) {
+                if (a->del || (a->ow != NO_OVERLAP && a->ov != NO_OVERLAP))
+                    continue;
+                uint32_t w = a->w ^ 1;
+                size_t c = 0;
+                Arc *comp = nullptr;
+                for (Arc *b = arcs_begin(w); b != arcs_end(w); ++b)
+                    if (!b->del && b->w == (v ^ 1))
+                        ++c, comp = b;
+
+                bool is_multi = false;
+                if (c == 1) {
+                    if (a->ov != NO_OVERLAP && comp->ow != NO_OVERLAP && a->ov != comp->ow) is_multi = true;
+                    if (a->ow != NO_OVERLAP && comp->ov != NO_OVERLAP && a->ow != comp->ov) is_multi = true;
+                }
+                if (c == 1 && !is_multi) {
+                    if (comp->ov != NO_OVERLAP) a->ow = comp->ov;
+                    if (comp->ow != NO_OVERLAP) a->ov = comp->ow;
+                } else {
+                    WARN("Cannot infer overlap length for " <<
+                         names[v >> 1] << "+-"[v & 1] << " -> " << names[a->w >> 1] << "+-"[a->w & 1]);
+                    a->del = true;
+                }
+            }
+        }
+    }
+
+    // Adds the missing complementary arcs (gfa_fix_symm) and drops the deleted ones
+    void FixSymmetry() {
+        std::vector<Arc> added;
+        for (uint32_t v = 0; v < 2 * names.size(); ++v) {
+            for (Arc *a = arcs_begin(v); a != arcs_end(v); ++a) {
+                if (a->del || a->comp)
+                    continue;
+                uint32_t w = a->w ^ 1;
+                Arc *b = arcs_begin(w);
+                for (; b != arcs_end(w); ++b) {
+                    if (b->del || b->comp)
+                        continue;
+                    if (b->w == (v ^ 1) && b->ov == a->ow && b->ow == a->ov) {
+                        b->comp = true;
+                        break;
+                    }
+                }
+                if (b == arcs_end(w))
+                    added.push_back({ w, v ^ 1, a->ow, a->ov, false, true });
+            }
+        }
+
+        arcs.erase(std::remove_if(arcs.begin(), arcs.end(), [](const Arc &a) { return a.del; }),
+                   arcs.end());
+        arcs.insert(arcs.end(), added.begin(), added.end());
+        IndexArcs();
+    }
+};
+
+GFAReader::GFAReader() = default;
+GFAReader::GFAReader(const std::string &filename) {
+    open(filename);
+}
+GFAReader::~GFAReader() = default;
+
 bool GFAReader::open(const std::string &filename) {
-    gfa_.reset(gfa_read(filename.c_str()));
+    storage_.reset();
+    paths_.clear();
+    if (!fs::is_regular_file(filename))
+        return false;
 
-    return (bool)gfa_;
+    GFABuffer buffer(filename);
+    const char *data = buffer.data(), *data_end = data + buffer.size();
+
+    // Split the file into chunks at the line boundaries, the chunks are parsed independently
+    size_t nchunks = std::max<size_t>(1, std::min<size_t>(4 * omp_get_max_threads(),
+                                                           buffer.size() / (1 << 20)));
+    std::vector<const char*> bounds(nchunks + 1, data_end);
+    bounds[0] = data;
+    for (size_t i = 1; i < nchunks; ++i) {
+        const char *p = std::max(bounds[i - 1], data + buffer.size() / nchunks * i);
+        p = std::find(p, data_end, '\n');
+        bounds[i] = p == data_end ? p : p + 1;
+    }
+
+    std::vector<RawChunk> chunks(nchunks);
+#   pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < nchunks; ++i)
+        ParseChunk(bounds[i], bounds[i + 1], chunks[i]);
+
+    size_t n_seg = 0, n_link = 0, n_path = 0, n_invalid = 0;
+    std::vector<size_t> seg_offset(nchunks), link_offset(nchunks);
+    for (size_t i = 0; i < nchunks; ++i) {
+        seg_offset[i] = n_seg, link_offset[i] = n_link;
+        n_seg += chunks[i].segments.size();
+        n_link += chunks[i].links.size();
+        n_path += chunks[i].paths.size();
+        n_invalid += chunks[i].invalid;
+    }
+    if (n_invalid)
+        WARN("Skipped " << n_invalid << " invalid lines in " << filename);
+
+    // Segments are numbered in order of their S-lines
+    phmap::flat_hash_map<StrRef, uint32_t, StrRefHash> ids;
+    ids.reserve(n_seg);
+    for (const auto &chunk : chunks) {
+        for (const auto &seg : chunk.segments) {
+            bool inserted = ids.insert({ seg.name, uint32_t(ids.size()) }).second;
+            VERIFY_MSG(inserted, "Duplicate segment " << seg.name << " in " << filename);
+        }
+    }
+    VERIFY_MSG(n_seg < (1u << 31), "Too many segments in " << filename);
+
+    auto segment_id = [&](StrRef name) {
+        auto it = ids.find(name);
+        VERIFY_MSG(it != ids.end(), "Segment " << name << " is used but not defined on an S-line in " << filename);
+        return it->second;
+    };
+
+    std::unique_ptr<Storage> storage(new Storage());
+    storage->names.resize(n_seg);
+    storage->seqs.resize(n_seg);
+    storage->coverage.resize(n_seg);
+    storage->arcs.resize(n_link);
+#   pragma omp parallel for schedule(dynamic, 1)
+    for (size_t i = 0; i < nchunks; ++i) {
+        const RawChunk &chunk = chunks[i];
+        for (size_t j = 0; j < chunk.segments.size(); ++j) {
+            const RawSegment &seg = chunk.segments[j];
+            size_t id = seg_offset[i] + j;
+            VERIFY_MSG(seg.seq != "*", "Segment " << seg.name << " has no sequence in " << filename);
+            storage->names[id] = seg.name.to_string();
+            storage->seqs[id] = Sequence(seg.seq);
+            storage->coverage[id] = unsigned(seg.kc);
+        }
+
+        for (size_t j = 0; j < chunk.links.size(); ++j) {
+            const RawLink &link = chunk.links[j];
+            storage->arcs[link_offset[i] + j] = { segment_id(link.from) << 1 | link.from_rc,
+                                                  segment_id(link.to) << 1 | link.to_rc,
+                                                  link.ov, link.ow, false, false };
+        }
+    }
+
+    storage->paths.reserve(n_path);
+    for (const auto &chunk : chunks) {
+        for (const auto &path : chunk.paths) {
+            std::vector<uint32_t> segments;
+            StrRef s = path.segments;
+            while (!s.empty()) {
+                size_t pos = std::min(s.find(','), s.size());
+                StrRef item = s.substr(0, pos);
+                VERIFY_MSG(!item.empty() && (item.back() == '+' || item.back() == '-'),
+                           "Invalid segment " << item << " of path " << path.name << " in " << filename);
+                segments.push_back(segment_id(item.substr(0, item.size() - 1)) << 1 | (item.back() == '-'));
+                s.remove_prefix(std::min(pos + 1, s.size()));
+            }
+            storage->paths.emplace_back(path.name.to_string(), std::move(segments));
+        }
+    }
+
+    storage->IndexArcs();
+    storage->FixSemiArcs();
+    storage->FixSymmetry();
+
+    storage_ = std::move(storage);
+    return true;
 }
 
-uint32_t GFAReader::num_edges() const { return gfa_->n_seg; }
-uint64_t GFAReader::num_links() const { return gfa_->n_arc; }
+uint32_t GFAReader::num_edges() const { return uint32_t(storage_->names.size()); }
+uint64_t GFAReader::num_links() const { return storage_->arcs.size(); }
 
 unsigned GFAReader::k() const {
     unsigned k = -1U;
-    for (size_t i = 0; i < gfa_->n_arc; ++i) {
-        gfa_arc_t *arc = gfa_->arc + i;
-        if (arc->ov != arc->ow || arc->ov < 0)
+    for (const auto &arc : storage_->arcs) {
+        if (arc.ov != arc.ow || arc.ov < 0)
             return -1U;
 
         if (k == -1U)
-            k = unsigned(arc->ov);
-        else if (k != unsigned(arc->ov))
+            k = unsigned(arc.ov);
+        else if (k != unsigned(arc.ov))
             return -1U;
     }
 
@@ -54,74 +452,55 @@ unsigned GFAReader::k() const {
 void GFAReader::to_graph(ConjugateDeBruijnGraph &g,
                          io::IdMapper<std::string> *id_mapper) {
     auto helper = g.GetConstructionHelper();
+    Storage &storage = *storage_;
+    size_t n_seg = storage.names.size();
 
     // INFO("Loading segments");
     std::vector<EdgeId> edges;
-    edges.reserve(gfa_->n_seg);
-    g.ereserve(2 * gfa_->n_seg);
-    for (size_t i = 0; i < gfa_->n_seg; ++i) {
-        gfa_seg_t *seg = gfa_->seg + i;
-
-        uint8_t *kc = gfa_aux_get(seg->aux.l_aux, seg->aux.aux, "KC");
-        unsigned cov = 0;
-        if (kc && kc[0] == 'i')
-            cov = *(int32_t*)(kc+1);
-        DeBruijnEdgeData edata(Sequence(seg->seq));
+    edges.reserve(n_seg);
+    g.ereserve(2 * n_seg);
+    for (size_t i = 0; i < n_seg; ++i) {
+        unsigned cov = storage.coverage[i];
+        DeBruijnEdgeData edata(storage.seqs[i]);
         EdgeId e = helper.AddEdge(edata);
         g.coverage_index().SetRawCoverage(e, cov);
         g.coverage_index().SetRawCoverage(g.conjugate(e), cov);
 
         if (id_mapper) {
-            (*id_mapper)[e.int_id()] = seg->name;
+            (*id_mapper)[e.int_id()] = storage.names[i];
             if (e != g.conjugate(e)) {
-                (*id_mapper)[g.conjugate(e).int_id()] = std::string(seg->name) + '\'';
+                (*id_mapper)[g.conjugate(e).int_id()] = storage.names[i] + '\'';
             }
         }
         edges.push_back(e);
     }
 
     // INFO("Creating vertices");
-    g.vreserve(gfa_->n_seg * 4);
-    std::unordered_set<VertexId> vertices;
-    for (uint32_t i = 0; i < gfa_->n_seg; ++i) {
+    g.vreserve(n_seg * 4);
+    std::vector<VertexId> vertices;
+    vertices.reserve(2 * n_seg);
+    for (size_t i = 0; i < n_seg; ++i) {
         VertexId v1 = helper.CreateVertex(DeBruijnVertexData());
         helper.LinkIncomingEdge(v1, edges[i]);
-        vertices.insert(v1);
+        vertices.push_back(v1);
 
         if (edges[i] != g.conjugate(edges[i])) {
             VertexId v2 = helper.CreateVertex(DeBruijnVertexData());
             helper.LinkIncomingEdge(v2, g.conjugate(edges[i]));
-            vertices.insert(v2);
+            vertices.push_back(v2);
         }
     }
 
-    // INFO("Linking edges");
-    for (uint32_t i = 0; i < gfa_->n_seg; ++i) {
-        EdgeId e1 = edges[i];
-        // Process direct links
-        {
-            uint32_t vv = i << 1 | 0;
-            gfa_arc_t *av = gfa_arc_a(gfa_.get(), vv);
-            for (size_t j = 0; j < gfa_arc_n(gfa_.get(), vv); ++j) {
-                EdgeId e2 = edges[av[j].w >> 1];
-                if (av[j].w & 1)
-                    e2 = g.conjugate(e2);
-                helper.LinkEdges(e1, e2);
-            }
-        }
+    auto oriented_edge = [&](uint32_t v) {
+        EdgeId e = edges[v >> 1];
+        return (v & 1) ? g.conjugate(e) : e;
+    };
 
-        // Process rc links
-        {
-            e1 = g.conjugate(e1);
-            uint32_t vv = i << 1 | 1;
-            gfa_arc_t *av = gfa_arc_a(gfa_.get(), vv);
-            for (size_t j = 0; j < gfa_arc_n(gfa_.get(), vv); ++j) {
-                EdgeId e2 = edges[av[j].w >> 1];
-                if (av[j].w & 1)
-                    e2 = g.conjugate(e2);
-                helper.LinkEdges(e1, e2);
-            }
-        }
+    // INFO("Linking edges");
+    for (uint32_t v = 0; v < 2 * n_seg; ++v) {
+        EdgeId e1 = oriented_edge(v);
+        for (auto *arc = storage.arcs_begin(v); arc != storage.arcs_end(v); ++arc)
+            helper.LinkEdges(e1, oriented_edge(arc->w));
     }
 
     // INFO("Filtering dangling vertices");
@@ -133,17 +512,12 @@ void GFAReader::to_graph(ConjugateDeBruijnGraph &g,
     }
 
     // INFO("Reading paths")
-    paths_.reserve(gfa_->n_path);
-    for (uint32_t i = 0; i < gfa_->n_path; ++i) {
-        const gfa_path_t &path = gfa_->path[i];
-        paths_.emplace_back(path.name);
+    paths_.reserve(storage.paths.size());
+    for (const auto &path : storage.paths) {
+        paths_.emplace_back(path.first);
         GFAPath &cpath = paths_.back();
-        for (unsigned j = 0; j < path.n_seg; ++j) {
-            EdgeId e = edges[path.v[j] >> 1];
-            if (path.v[j] & 1)
-                e = g.conjugate(e);
-            cpath.edges.push_back(e);
-        }
+        for (uint32_t v : path.second)
+            cpath.edges.push_back(oriented_edge(v));
     }
 }
 
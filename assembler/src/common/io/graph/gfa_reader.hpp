@@ -14,10 +14,6 @@
 #include <string>
 #include <vector>
 
-extern "C" {
-    typedef struct gfa_s gfa_t;
-};
-
 namespace debruijn_graph {
 class DeBruijnGraph;
 };
@@ -45,9 +41,9 @@ class GFAReader {
 
     GFAReader();
     GFAReader(const std::string &filename);
+    ~GFAReader();
     bool open(const std::string &filename);
-    bool valid() const { return (bool)gfa_; }
-    gfa_t *get() const { return gfa_.get(); }
+    bool valid() const { return (bool)storage_; }
 
     uint32_t num_edges() const;
     uint64_t num_links() const;
@@ -63,7 +59,10 @@ class GFAReader {
     void to_graph(debruijn_graph::DeBruijnGraph &g, io::IdMapper<std::string> *id_mapper = nullptr);
 
   private:
-    std::unique_ptr<gfa_t, void(*)(gfa_t*)> gfa_;
+    // Segments and arcs in columnar form, see gfa_reader.cpp
+    struct Storage;
+
+    std::unique_ptr<Storage> storage_;
     std::vector<GFAPath> paths_;
 };
 
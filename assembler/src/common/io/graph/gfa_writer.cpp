@@ -9,6 +9,7 @@
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/core/graph_iterators.hpp"
 #include "assembly_graph/components/graph_component.hpp"
+#include "io/utils/ordered_writer.hpp"
 
 using namespace gfa;
 using namespace debruijn_graph;
@@ -25,7 +26,7 @@ static void WriteSegment(const std::string& edge_id, const Sequence &seq,
 }
 
 static void WriteLink(EdgeId e1, EdgeId e2, size_t overlap_size,
-                      std::ostream &os, io::CanonicalEdgeHelper<Graph> &namer) {
+                      std::ostream &os, const io::CanonicalEdgeHelper<Graph> &namer) {
     os << "L\t"
        << namer.EdgeOrientationString(e1, "\t") << '\t'
        << namer.EdgeOrientationString(e2, "\t") << '\t'
@@ -33,22 +34,26 @@ static void WriteLink(EdgeId e1, EdgeId e2, size_t overlap_size,
 }
 
 void GFAWriter::WriteSegments() {
-    for (EdgeId e : graph_.canonical_edges()) {
+    std::vector<EdgeId> edges(graph_.canonical_edges().begin(), graph_.canonical_edges().end());
+    io::WriteOrdered(os_, edges.size(), [&](size_t i, std::ostream &os) {
+        EdgeId e = edges[i];
         WriteSegment(edge_namer_.EdgeString(e), graph_.EdgeNucls(e),
                      graph_.coverage(e), graph_.kmer_multiplicity(e),
-                     os_);
-    }
+                     os);
+    });
 }
 
 void GFAWriter::WriteLinks() {
-    for (VertexId v : graph_.canonical_vertices()) {
+    std::vector<VertexId> vertices(graph_.canonical_vertices().begin(), graph_.canonical_vertices().end());
+    io::WriteOrdered(os_, vertices.size(), [&](size_t i, std::ostream &os) {
+        VertexId v = vertices[i];
         for (auto inc_edge : graph_.IncomingEdges(v)) {
             for (auto out_edge : graph_.OutgoingEdges(v)) {
                 WriteLink(inc_edge, out_edge, graph_.k(),
-                          os_, edge_namer_);
+                          os, edge_namer_);
             }
         }
-    }
+    });
 }
 
 
@@ -16,6 +16,7 @@
 #include "utils/logger/logger.hpp"
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/filesystem/file_opener.hpp"
+#include "utils/perf/timetracer.hpp"
 
 #include <fstream>
 
@@ -29,13 +30,36 @@ protected:
     virtual bool ReadImpl(SeqT &read) = 0;
 
 private:
+    std::string file_name_;
     size_t offset_, count_, current_;
+    // Position up to which the read bytes were reported to the tracer
+    size_t traced_;
+    bool closed_;
+
+    // The file is opened on the first read and closed after the last one, so that
+    // only the streams being read at the moment hold file descriptors
+    void Open() {
+        stream_.open(file_name_, std::ios_base::binary | std::ios_base::in);
+        stream_.seekg(offset_);
+        VERIFY_MSG(stream_.good(), "Stream is not good(), offset_ " << offset_ << " count_ " << count_);
+    }
 
     void Init() {
+        if (stream_.is_open())
+            stream_.close();
         stream_.clear();
-        stream_.seekg(offset_);
-        VERIFY_MSG(stream_.good(), "Stream is not good(), offset_ " << offset_ << " count_ " << count_);
         current_ = 0;
+        traced_ = offset_;
+    }
+
+    void TraceBytesRead() {
+        if (!utils::trace::enabled())
+            return;
+        auto pos = stream_.tellg();
+        if (pos < 0)
+            return;
+        TIME_TRACE_COUNTER(BytesRead, size_t(pos) - traced_);
+        traced_ = size_t(pos);
     }
 
 public:
@@ -45,13 +69,15 @@ public:
      * @param portion_count Total number of (roughly equal) portions.
      * @param portion_num Index of the portion (0..portion_count - 1).
      */
-    BinaryFileStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num) {
+    BinaryFileStream(const std::string &file_name_prefix, size_t portion_count, size_t portion_num)
+            : file_name_(file_name_prefix + ".seq"), closed_(false) {
         DEBUG("Preparing binary stream #" << portion_num << "/" << portion_count);
         VERIFY(portion_num < portion_count);
-        const std::string fname = file_name_prefix + ".seq";
-        stream_.open(fname, std::ios_base::binary | std::ios_base::in);
         ReadStreamStat stat;
-        stat.read(stream_);
+        {
+            auto stat_stream = fs::open_file(file_name_, std::ios_base::binary | std::ios_base::in);
+            stat.read(stat_stream);
+        }
 
         const std::string offset_name = file_name_prefix + ".off";
         const size_t chunk_count = fs::filesize(offset_name) / sizeof(size_t);
@@ -103,14 +129,21 @@ public:
             : BinaryFileStream(file_name_prefix, 1, 0) {}
 
     BinaryFileStream<SeqT>& operator>>(SeqT &read) {
+        VERIFY(!closed_);
+        if (!stream_.is_open())
+            Open();
         ReadImpl(read);
         VERIFY(current_ < count_);
         ++current_;
+        if (current_ % 1024 == 0 || current_ == count_)
+            TraceBytesRead();
+        if (current_ == count_)
+            stream_.close();
         return *this;
     }
 
     bool is_open() {
-        return stream_.is_open();
+        return !closed_;
     }
 
     bool eof() {
@@ -118,8 +151,8 @@ public:
     }
 
     void close() {
-        current_ = 0;
-        stream_.close();
+        Init();
+        closed_ = true;
     }
 
     void reset() {
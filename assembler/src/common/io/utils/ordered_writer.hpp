@@ -0,0 +1,43 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "utils/parallel/openmp_wrapper.h"
+
+#include <algorithm>
+#include <ostream>
+#include <sstream>
+#include <string>
+
+namespace io {
+
+/**
+ * Writes count records to os formatting them in parallel. Consecutive
+ * records are grouped into chunks, every chunk is formatted by a single thread
+ * into its own buffer and the buffers are committed in order, so the output
+ * is byte-identical to the sequential one.
+ * @param format callable (size_t idx, std::ostream &os) writing the idx-th record
+ */
+template<class Format>
+void WriteOrdered(std::ostream &os, size_t count, const Format &format,
+                  size_t chunk_size = 1024) {
+    size_t chunks = (count + chunk_size - 1) / chunk_size;
+
+#   pragma omp parallel for ordered schedule(static, 1)
+    for (size_t chunk = 0; chunk < chunks; ++chunk) {
+        std::ostringstream buf;
+        size_t end = std::min(count, (chunk + 1) * chunk_size);
+        for (size_t i = chunk * chunk_size; i < end; ++i)
+            format(i, buf);
+
+        std::string s = buf.str();
+#       pragma omp ordered
+        os.write(s.data(), s.size());
+    }
+}
+
+}
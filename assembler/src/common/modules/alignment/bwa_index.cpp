@@ -110,9 +110,8 @@ static uint8_t* seqlib_add1(const std::string &seq, const std::string &name,
     return pac;
 }
 
-static uint8_t* seqlib_make_pac(const debruijn_graph::Graph &g,
-                                const std::vector<debruijn_graph::EdgeId> &ids,
-                                bool for_only) {
+static uint8_t* seqlib_make_pac(size_t n, const SequenceGetter &get_seq,
+                                bool for_only, std::vector<size_t> *lens = nullptr) {
     bntseq_t * bns = (bntseq_t*)calloc(1, sizeof(bntseq_t));
     uint8_t *pac = 0;
     int32_t m_seqs, m_holes;
@@ -127,9 +126,11 @@ static uint8_t* seqlib_make_pac(const debruijn_graph::Graph &g,
     q = bns->ambs;
 
     // Move through the sequences
-    for (auto e : ids) {
-        std::string ref = std::to_string(g.int_id(e));
-        std::string seq = g.EdgeNucls(e).str();
+    for (size_t i = 0; i < n; ++i) {
+        std::string ref = std::to_string(i);
+        std::string seq = get_seq(i);
+        if (lens)
+            lens->push_back(seq.size());
 
         // make the forward only pac
         pac = seqlib_add1(seq, ref, bns, pac, &m_pac, &m_seqs, &m_holes, &q);
@@ -207,11 +208,11 @@ static bwt_t *seqlib_bwt_pac2bwt(const uint8_t *pac, size_t bwt_seq_lenr) {
     return bwt;
 }
 
-static bntann1_t* seqlib_add_to_anns(const std::string& name, const std::string& seq, bntann1_t* ann, size_t offset) {
+static bntann1_t* seqlib_add_to_anns(const std::string& name, size_t len, bntann1_t* ann, size_t offset) {
     ann->offset = offset;
     ann->name = strdup(name.c_str());
     ann->anno = strdup("(null)");
-    ann->len = int(seq.length());
+    ann->len = int(len);
     ann->n_ambs = 0; // number of "holes"
     ann->gi = 0; // gi?
     ann->is_alt = 0;
@@ -219,23 +220,19 @@ static bntann1_t* seqlib_add_to_anns(const std::string& name, const std::string&
     return ann;
 }
 
-void BWAIndex::Init() {
-    idx_.reset((bwaidx_t*)calloc(1, sizeof(bwaidx_t)));
-    ids_.clear();
-
-    for (debruijn_graph::EdgeId e : g_.canonical_edges()) {
-        ids_.push_back(e);
-    }
+BWAIdxPtr BuildBWAIndex(size_t n, const SequenceGetter &get_name, const SequenceGetter &get_seq) {
+    BWAIdxPtr idx((bwaidx_t*)calloc(1, sizeof(bwaidx_t)), bwa_idx_destroy);
 
     // construct the forward-only pac
-    uint8_t* fwd_pac = seqlib_make_pac(g_, ids_, true); // true->for_only
+    std::vector<size_t> lens;
+    uint8_t* fwd_pac = seqlib_make_pac(n, get_seq, true, &lens); // true->for_only
 
     // construct the forward-reverse pac ("packed" 2 bit sequence)
-    uint8_t* pac = seqlib_make_pac(g_, ids_, false); // don't write, because only used to make BWT
+    uint8_t* pac = seqlib_make_pac(n, get_seq, false); // don't write, because only used to make BWT
 
     size_t tlen = 0;
-    for (auto e : ids_)
-        tlen += g_.EdgeNucls(e).size();
+    for (size_t len : lens)
+        tlen += len;
 
     // make the bwt
     bwt_t *bwt;
@@ -250,28 +247,40 @@ void BWAIndex::Init() {
     // make the bns
     bntseq_t * bns = (bntseq_t*) calloc(1, sizeof(bntseq_t));
     bns->l_pac = tlen;
-    bns->n_seqs = int(ids_.size());
+    bns->n_seqs = int(n);
     bns->seed = 11;
     bns->n_holes = 0;
 
     // make the anns
     // FIXME: Do we really need this?
-    bns->anns = (bntann1_t*)calloc(ids_.size(), sizeof(bntann1_t));
-    size_t offset = 0, k = 0;
-    for (auto e: ids_) {
-        std::string name = std::to_string(g_.int_id(e));
-        std::string seq = g_.EdgeNucls(e).str();
-        seqlib_add_to_anns(name, seq, &bns->anns[k++], offset);
-        offset += seq.length();
+    bns->anns = (bntann1_t*)calloc(n, sizeof(bntann1_t));
+    size_t offset = 0;
+    for (size_t i = 0; i < n; ++i) {
+        seqlib_add_to_anns(get_name(i), lens[i], &bns->anns[i], offset);
+        offset += lens[i];
     }
 
     // ambs is "holes", like N bases
     bns->ambs = 0;
 
     // Make the in-memory idx struct
-    idx_->bwt = bwt;
-    idx_->bns = bns;
-    idx_->pac = fwd_pac;
+    idx->bwt = bwt;
+    idx->bns = bns;
+    idx->pac = fwd_pac;
+
+    return idx;
+}
+
+void BWAIndex::Init() {
+    ids_.clear();
+
+    for (debruijn_graph::EdgeId e : g_.canonical_edges()) {
+        ids_.push_back(e);
+    }
+
+    idx_ = BuildBWAIndex(ids_.size(),
+                         [this](size_t i) { return std::to_string(g_.int_id(ids_[i])); },
+                         [this](size_t i) { return g_.EdgeNucls(ids_[i]).str(); });
 }
 
 #if 0
@@ -9,6 +9,10 @@
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/paths/mapping_path.hpp"
 
+#include <functional>
+#include <memory>
+#include <string>
+
 extern "C" {
 struct bwaidx_s;
 typedef struct bwaidx_s bwaidx_t;
@@ -23,6 +27,15 @@ typedef struct mem_alnreg_vs mem_alnreg_v;
 
 namespace alignment {
 
+typedef std::unique_ptr<bwaidx_t, void(*)(bwaidx_t*)> BWAIdxPtr;
+typedef std::function<std::string(size_t)> SequenceGetter;
+
+/**
+ * Builds the in-memory BWA index of n sequences, the i-th sequence gets reference id i.
+ * Sequences are requested twice, so they are not kept in memory all at once.
+ */
+BWAIdxPtr BuildBWAIndex(size_t n, const SequenceGetter &get_name, const SequenceGetter &get_seq);
+
 class BWAIndex {
   public:
     enum class AlignmentMode {
@@ -49,7 +62,7 @@ class BWAIndex {
     std::unique_ptr<mem_opt_t, void(*)(void*)> memopt_;
 
     // hold the full index structure
-    std::unique_ptr<bwaidx_t, void(*)(bwaidx_t*)> idx_;
+    BWAIdxPtr idx_;
 
     std::vector<debruijn_graph::EdgeId> ids_;
 
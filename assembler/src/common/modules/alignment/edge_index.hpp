@@ -43,16 +43,36 @@ private:
     EdgeIndexRefiller refiller_;
 
     template<class Index>
-    std::pair<EdgeId, size_t> get(const Index *index, const KMer& kmer) const {
-        auto kwh = index->ConstructKWH(kmer);
+    std::pair<EdgeId, size_t> get(const Index *index, const typename Index::KeyWithHash &kwh) const {
         if (index->contains(kwh)) {
             auto entry = index->get_value(kwh);
             return { entry.edge(), (size_t)entry.offset() };
         }
-        
+
         return { EdgeId(), NOT_FOUND };
     }
 
+    template<class Index>
+    std::pair<EdgeId, size_t> get(const Index *index, const KMer& kmer) const {
+        return get(index, index->ConstructKWH(kmer));
+    }
+
+    template<class Index>
+    void get(const Index *index, const KMer *kmers, size_t n, std::pair<EdgeId, size_t> *positions) const {
+        // Perfect hash lookups of different k-mers are independent, so all of them are
+        // resolved first with the entries prefetched, and only then the entries are read
+        std::vector<typename Index::KeyWithHash> kwhs;
+        kwhs.reserve(n);
+        for (size_t i = 0; i < n; ++i) {
+            kwhs.push_back(index->ConstructKWH(kmers[i]));
+            if (index->valid(kwhs.back()))
+                __builtin_prefetch(&index->get_raw_value_reference(kwhs.back()));
+        }
+
+        for (size_t i = 0; i < n; ++i)
+            positions[i] = get(index, kwhs[i]);
+    }
+
     template<class Index>
     bool contains(const Index *index, const KMer& kmer) const {
         return index->contains(index->ConstructKWH(kmer));
@@ -149,6 +169,13 @@ public:
         DISPATCH_TO(get, kmer);
     }
 
+    /**
+     * Batched version of get() for the k-mers not depending on each other
+     */
+    void get(const KMer *kmers, size_t n, std::pair<EdgeId, size_t> *positions) const {
+        DISPATCH_TO(get, kmers, n, positions);
+    }
+
     void Refill() {
         clear();
         uint64_t max_id = this->g().max_eid();
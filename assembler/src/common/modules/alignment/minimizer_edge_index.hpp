@@ -0,0 +1,215 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "assembly_graph/core/graph.hpp"
+#include "sequence/rtseq.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/logger/logger.hpp"
+#include "utils/verify.hpp"
+
+#include <parallel_hashmap/phmap.h>
+
+#include <deque>
+#include <vector>
+
+namespace debruijn_graph {
+
+/**
+ * MinimizerEdgeIndex is a sparse alternative to EdgeIndex: it keeps positions of the (w, k+1)-minimizers
+ * of the edges only, i.e. of the k-mers having the smallest hash among w consecutive k-mers of some edge.
+ * Every window of w k-mers of an edge has a sampled k-mer, so a read sharing such a window with the graph
+ * gets a seed, which BasicSequenceMapper then extends along the graph by the direct comparison
+ * with the edge sequences (TryThread). The minimizers are chosen over canonical k-mers, so both strands
+ * share the samples and only canonical positions are stored.
+ *
+ * Unlike EdgeIndex this is a snapshot of the graph: it is not updated on graph modifications
+ * and has to be refilled afterwards.
+ */
+template<class Graph>
+class MinimizerEdgeIndex {
+    typedef typename Graph::EdgeId EdgeId;
+
+public:
+    typedef RtSeq KMer;
+    static constexpr size_t NOT_FOUND = size_t(-1);
+
+private:
+    static constexpr uint32_t AMBIGUOUS = uint32_t(-1);
+
+    struct Position {
+        uint64_t edge;
+        uint32_t offset;
+    } __attribute__((packed));
+
+    struct Sample {
+        uint64_t hash;
+        Position pos;
+    };
+
+    const Graph &g_;
+    size_t w_;
+    phmap::flat_hash_map<uint64_t, Position> positions_;
+
+    static uint64_t Hash(const KMer &kmer) {
+        return kmer.GetHash();
+    }
+
+    // Canonical position of the k-mer at the given offset of the edge
+    Position Canonical(EdgeId e, size_t offset, bool rc) const {
+        if (!rc)
+            return { e.int_id(), uint32_t(offset) };
+        return { g_.conjugate(e).int_id(), uint32_t(g_.length(e) - offset - 1) };
+    }
+
+    void CollectMinimizers(EdgeId e, std::vector<Sample> &samples) const {
+        const Sequence &nucls = g_.EdgeNucls(e);
+        size_t k = this->k(), n = g_.length(e);
+        VERIFY(nucls.size() == n + k - 1);
+
+        // Sliding window minimum over the hashes of canonical k-mers, the leftmost one wins the ties
+        std::deque<std::pair<uint64_t, size_t>> window;
+        std::vector<bool> rc;
+        rc.reserve(n);
+        KMer kmer = nucls.start<KMer>(k) >> 'A';
+        KMer rc_kmer = !kmer;
+        size_t last = NOT_FOUND;
+        size_t w = std::min(w_, n);
+        for (size_t i = 0; i < n; ++i) {
+            char c = nucls[i + k - 1];
+            kmer <<= c;
+            rc_kmer >>= complement(c);
+            bool is_rc = rc_kmer < kmer;
+            rc.push_back(is_rc);
+            uint64_t h = Hash(is_rc ? rc_kmer : kmer);
+
+            while (!window.empty() && window.back().first > h)
+                window.pop_back();
+            window.emplace_back(h, i);
+            if (window.front().second + w <= i)
+                window.pop_front();
+
+            if (i + 1 < w)
+                continue;
+
+            size_t pos = window.front().second;
+            if (pos != last) {
+                samples.push_back({ window.front().first, Canonical(e, pos, rc[pos]) });
+                last = pos;
+            }
+        }
+    }
+
+    const Position *Find(const KMer &kmer, bool &rc) const {
+        KMer rc_kmer = !kmer;
+        rc = rc_kmer < kmer;
+        const KMer &canonical = rc ? rc_kmer : kmer;
+        auto it = positions_.find(Hash(canonical));
+        if (it == positions_.end() || it->second.offset == AMBIGUOUS)
+            return nullptr;
+
+        // Different k-mers might share the hash value
+        const Position &pos = it->second;
+        if (!g_.EdgeNucls(EdgeId(pos.edge)).contains(canonical, pos.offset))
+            return nullptr;
+
+        return &pos;
+    }
+
+public:
+    MinimizerEdgeIndex(const Graph &g, size_t w)
+            : g_(g), w_(w) {
+        VERIFY(w_ > 0);
+    }
+
+    size_t k() const {
+        return g_.k() + 1;
+    }
+
+    size_t w() const {
+        return w_;
+    }
+
+    size_t size() const {
+        return positions_.size();
+    }
+
+    /**
+     * Approximate memory footprint of the index in bytes
+     */
+    size_t mem_size() const {
+        return positions_.capacity() * (sizeof(typename decltype(positions_)::value_type) + 1);
+    }
+
+    void clear() {
+        decltype(positions_)().swap(positions_);
+    }
+
+    void Refill() {
+        clear();
+
+        std::vector<EdgeId> edges(g_.canonical_edges().begin(), g_.canonical_edges().end());
+        std::vector<std::vector<Sample>> samples(omp_get_max_threads());
+#       pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < edges.size(); ++i)
+            CollectMinimizers(edges[i], samples[omp_get_thread_num()]);
+
+        size_t total = 0, kmers = 0;
+        for (const auto &chunk : samples)
+            total += chunk.size();
+        for (EdgeId e : edges)
+            kmers += g_.length(e);
+
+        positions_.reserve(total);
+        for (auto &chunk : samples) {
+            for (const Sample &sample : chunk) {
+                auto res = positions_.insert({ sample.hash, sample.pos });
+                if (res.second)
+                    continue;
+                // Drop hash collisions, the repeated minimizers of self-conjugate edges are fine
+                Position &pos = res.first->second;
+                if (pos.offset != AMBIGUOUS &&
+                    (pos.edge != sample.pos.edge || pos.offset != sample.pos.offset))
+                    pos.offset = AMBIGUOUS;
+            }
+            std::vector<Sample>().swap(chunk);
+        }
+
+        INFO("Minimizer index (w = " << w_ << ") filled: " << positions_.size() << " of " << kmers <<
+             " k-mers sampled, " << mem_size() / 1024 / 1024 << " Mb");
+    }
+
+    bool contains(const KMer &kmer) const {
+        bool rc;
+        return Find(kmer, rc) != nullptr;
+    }
+
+    std::pair<EdgeId, size_t> get(const KMer &kmer) const {
+        bool rc;
+        const Position *pos = Find(kmer, rc);
+        if (!pos)
+            return { EdgeId(), NOT_FOUND };
+
+        EdgeId e(pos->edge);
+        if (!rc)
+            return { e, pos->offset };
+        return { g_.conjugate(e), g_.length(e) - pos->offset - 1 };
+    }
+
+    /**
+     * Batched version of get(), see EdgeIndex
+     */
+    void get(const KMer *kmers, size_t n, std::pair<EdgeId, size_t> *positions) const {
+        for (size_t i = 0; i < n; ++i)
+            positions[i] = get(kmers[i]);
+    }
+};
+
+template<class Graph>
+constexpr size_t MinimizerEdgeIndex<Graph>::NOT_FOUND;
+
+}
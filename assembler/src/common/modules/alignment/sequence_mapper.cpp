@@ -20,5 +20,12 @@ std::shared_ptr<BasicSequenceMapper<Graph, EdgeIndex<Graph>>> MapperInstance(con
                                                                           index,
                                                                           gp.get<KmerMapper<Graph>>());
 }
+
+std::shared_ptr<BasicSequenceMapper<Graph, MinimizerEdgeIndex<Graph>>> MapperInstance(const GraphPack &gp,
+                                                                                      const MinimizerEdgeIndex<Graph> &index) {
+    return std::make_shared<BasicSequenceMapper<Graph, MinimizerEdgeIndex<Graph>>>(gp.get<Graph>(),
+                                                                                   index,
+                                                                                   gp.get<KmerMapper<Graph>>());
+}
 }
 
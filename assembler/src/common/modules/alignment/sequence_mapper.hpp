@@ -17,6 +17,7 @@
 
 #include "kmer_mapper.hpp"
 #include "edge_index.hpp"
+#include "minimizer_edge_index.hpp"
 
 #include <cstdlib>
 
@@ -54,6 +55,19 @@ public:
 
     virtual MappingPath<EdgeId> MapRead(const io::SingleRead &read,
                                         bool only_simple = false) const = 0;
+
+    /**
+     * Maps a batch of sequences, the result is the same as of MapSequence applied to each of them.
+     * Mappers able to overlap the index lookups of different sequences override this.
+     */
+    virtual std::vector<MappingPath<EdgeId>> MapSequences(const std::vector<Sequence> &sequences,
+                                                          bool only_simple = false) const {
+        std::vector<MappingPath<EdgeId>> result;
+        result.reserve(sequences.size());
+        for (const Sequence &s : sequences)
+            result.push_back(MapSequence(s, only_simple));
+        return result;
+    }
 };
 
 template<class Graph>
@@ -120,6 +134,14 @@ public:
                                 bool only_simple = false) const override {
         return processing_f_(inner_mapper_->MapRead(r, only_simple), r.size());
     }
+
+    std::vector<MappingPath<EdgeId>> MapSequences(const std::vector<Sequence> &sequences,
+                                                  bool only_simple = false) const override {
+        auto result = inner_mapper_->MapSequences(sequences, only_simple);
+        for (size_t i = 0; i < result.size(); ++i)
+            result[i] = processing_f_(result[i], sequences[i].size());
+        return result;
+    }
 };
 
 template<class Graph>
@@ -299,9 +321,33 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
   size_t k_;
   bool optimization_on_;
 
+  // State of a sequence mapped within a batch, see MapSequences
+  struct BatchState {
+      const Sequence &sequence;
+      size_t kmer_pos;
+      Kmer kmer;
+      Kmer lookup;
+      bool try_thread;
+      bool substituted;
+      bool done;
+      std::vector<EdgeId> passed_edges;
+      RangeMappings range_mapping;
+
+      BatchState(const Sequence &sequence, size_t k)
+              : sequence(sequence), kmer_pos(0), kmer(k), lookup(k),
+                try_thread(false), substituted(false), done(sequence.size() < k) {
+          if (!done)
+              kmer = sequence.start<Kmer>(k);
+      }
+  };
+
   bool FindKmer(const Kmer &kmer, size_t kmer_pos, std::vector<EdgeId> &passed,
                 RangeMappings& range_mappings) const {
-    const auto& position = index_.get(kmer);
+    return AddPosition(index_.get(kmer), kmer_pos, passed, range_mappings);
+  }
+
+  bool AddPosition(const std::pair<EdgeId, size_t> &position, size_t kmer_pos, std::vector<EdgeId> &passed,
+                   RangeMappings& range_mappings) const {
     if (position.second == Index::NOT_FOUND)
         return false;
     
@@ -370,6 +416,38 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
     return FindKmer(kmer, kmer_pos, passed_edges, range_mapping);
   }
 
+  // Threads the sequence as far as possible, stops at the k-mer which has to be looked up in the index
+  void Advance(BatchState &state, bool only_simple) const {
+    while (!state.done) {
+      if (state.try_thread && TryThread(state.kmer, state.kmer_pos, state.passed_edges, state.range_mapping)) {
+        Next(state, only_simple);
+        continue;
+      }
+
+      // Same as in ProcessKmer: the result of the lookup of a substituted k-mer is not threaded further
+      state.substituted = state.try_thread || kmer_mapper_.CanSubstitute(state.kmer);
+      state.lookup = state.substituted ? kmer_mapper_.Substitute(state.kmer) : state.kmer;
+      return;
+    }
+  }
+
+  void Next(BatchState &state, bool only_simple) const {
+    if (only_simple && state.passed_edges.size() > 1) {
+      state.passed_edges.clear();
+      state.range_mapping.clear();
+      state.done = true;
+      return;
+    }
+
+    size_t next = state.kmer_pos + k_;
+    if (next >= state.sequence.size()) {
+      state.done = true;
+      return;
+    }
+    state.kmer <<= state.sequence[next];
+    state.kmer_pos += 1;
+  }
+
  public:
   BasicSequenceMapper(const Graph& g,
                       const Index& index,
@@ -403,10 +481,60 @@ class BasicSequenceMapper: public AbstractSequenceMapper<Graph> {
     return MappingPath<EdgeId>(passed_edges, range_mapping);
   }
 
+  /**
+   * Maps the sequences in lock-step: every sequence is threaded along the graph up to the next k-mer
+   * requiring an index lookup, then the lookups of all the sequences are done together, so the
+   * index is able to overlap their memory accesses. The result is the same as of MapSequence.
+   */
+  std::vector<MappingPath<EdgeId>> MapSequences(const std::vector<Sequence> &sequences,
+                                                bool only_simple = false) const override {
+    std::vector<BatchState> states;
+    states.reserve(sequences.size());
+    std::vector<size_t> pending;
+    for (const Sequence &sequence : sequences) {
+      states.emplace_back(sequence, k_);
+      if (!states.back().done)
+        pending.push_back(states.size() - 1);
+    }
+
+    std::vector<Kmer> kmers;
+    std::vector<std::pair<EdgeId, size_t>> positions;
+    while (!pending.empty()) {
+      kmers.clear();
+      size_t cnt = 0;
+      for (size_t i = 0; i < pending.size(); ++i) {
+        BatchState &state = states[pending[i]];
+        Advance(state, only_simple);
+        if (state.done)
+          continue;
+        pending[cnt++] = pending[i];
+        kmers.push_back(state.lookup);
+      }
+      pending.resize(cnt);
+
+      positions.resize(cnt);
+      index_.get(kmers.data(), cnt, positions.data());
+      for (size_t i = 0; i < cnt; ++i) {
+        BatchState &state = states[pending[i]];
+        bool found = AddPosition(positions[i], state.kmer_pos, state.passed_edges, state.range_mapping);
+        state.try_thread = !state.substituted && found;
+        Next(state, only_simple);
+      }
+    }
+
+    std::vector<MappingPath<EdgeId>> result;
+    result.reserve(states.size());
+    for (const BatchState &state : states)
+      result.emplace_back(state.passed_edges, state.range_mapping);
+    return result;
+  }
+
   DECL_LOGGER("BasicSequenceMapper");
 };
 
 std::shared_ptr<BasicSequenceMapper<Graph, EdgeIndex<Graph>>> MapperInstance(const GraphPack &gp);
 std::shared_ptr<BasicSequenceMapper<Graph, EdgeIndex<Graph>>> MapperInstance(const GraphPack &gp,
                                                                              const EdgeIndex<Graph> &index);
+std::shared_ptr<BasicSequenceMapper<Graph, MinimizerEdgeIndex<Graph>>> MapperInstance(const GraphPack &gp,
+                                                                                      const MinimizerEdgeIndex<Graph> &index);
 } // namespace debruijn_graph
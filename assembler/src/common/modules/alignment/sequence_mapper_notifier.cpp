@@ -12,6 +12,48 @@
 
 namespace debruijn_graph {
 
+template<class PairedRead>
+static void PassPairedReads(SequenceMapperListener& listener, size_t thread_index,
+                            const std::vector<PairedRead>& reads,
+                            const std::vector<MappingPath<EdgeId>>& paths1,
+                            const std::vector<MappingPath<EdgeId>>& paths2) {
+    for (size_t i = 0; i < reads.size(); ++i) {
+        listener.ProcessPairedRead(thread_index, reads[i], paths1[i], paths2[i]);
+        listener.ProcessSingleRead(thread_index, reads[i].first(), paths1[i]);
+        listener.ProcessSingleRead(thread_index, reads[i].second(), paths2[i]);
+    }
+}
+
+template<class SingleRead>
+static void PassSingleReads(SequenceMapperListener& listener, size_t thread_index,
+                            const std::vector<SingleRead>& reads,
+                            const std::vector<MappingPath<EdgeId>>& paths) {
+    for (size_t i = 0; i < reads.size(); ++i)
+        listener.ProcessSingleRead(thread_index, reads[i], paths[i]);
+}
+
+void SequenceMapperListener::ProcessPairedReads(size_t thread_index, const std::vector<io::PairedRead>& reads,
+                                                const std::vector<MappingPath<EdgeId>>& paths1,
+                                                const std::vector<MappingPath<EdgeId>>& paths2) {
+    PassPairedReads(*this, thread_index, reads, paths1, paths2);
+}
+
+void SequenceMapperListener::ProcessPairedReads(size_t thread_index, const std::vector<io::PairedReadSeq>& reads,
+                                                const std::vector<MappingPath<EdgeId>>& paths1,
+                                                const std::vector<MappingPath<EdgeId>>& paths2) {
+    PassPairedReads(*this, thread_index, reads, paths1, paths2);
+}
+
+void SequenceMapperListener::ProcessSingleReads(size_t thread_index, const std::vector<io::SingleRead>& reads,
+                                                const std::vector<MappingPath<EdgeId>>& paths) {
+    PassSingleReads(*this, thread_index, reads, paths);
+}
+
+void SequenceMapperListener::ProcessSingleReads(size_t thread_index, const std::vector<io::SingleReadSeq>& reads,
+                                                const std::vector<MappingPath<EdgeId>>& paths) {
+    PassSingleReads(*this, thread_index, reads, paths);
+}
+
 SequenceMapperNotifier::SequenceMapperNotifier(const GraphPack& gp, size_t lib_count)
     : gp_(gp)
     , listeners_(lib_count) 
@@ -39,59 +81,98 @@ void SequenceMapperNotifier::NotifyMergeBuffer(size_t ilib, size_t ithread) cons
         listener->MergeBuffer(ithread);
 }
 
+void SequenceMapperNotifier::TryMergeBuffers(size_t ilib, size_t ithread,
+                                             std::vector<bool> &unmerged, std::vector<std::mutex> &locks) const {
+    for (size_t i = 0; i < unmerged.size(); ++i) {
+        if (!unmerged[i])
+            continue;
+
+        std::unique_lock<std::mutex> lock(locks[i], std::try_to_lock);
+        if (!lock.owns_lock())
+            continue;
+
+        std::string thread_str = std::to_string(ithread);
+        TIME_TRACE_SCOPE("SequenceMapperNotifier::MergeBuffer", thread_str);
+        listeners_[ilib][i]->MergeBuffer(ithread);
+        unmerged[i] = false;
+    }
+}
+
+void SequenceMapperNotifier::ReportProgress(std::atomic<size_t> &counter, size_t processed) {
+    size_t prev = counter.fetch_add(processed);
+    size_t cur = prev + processed;
+    // Report every time the counter passes a power of two, starting from 2^15
+    if ((cur >> 15) && (cur ^ prev) > prev)
+        INFO("Processed " << cur << " reads");
+}
+
 template<>
-void SequenceMapperNotifier::NotifyProcessRead(const io::PairedReadSeq& r,
-                                               const SequenceMapperT& mapper,
-                                               size_t ilib,
-                                               size_t ithread) const
+void SequenceMapperNotifier::NotifyProcessReads(const std::vector<io::PairedReadSeq>& reads,
+                                                const SequenceMapperT& mapper,
+                                                size_t ilib,
+                                                size_t ithread) const
 {
-    const Sequence& read1 = r.first().sequence();
-    const Sequence& read2 = r.second().sequence();
-    MappingPath<EdgeId> path1 = mapper.MapSequence(read1);
-    MappingPath<EdgeId> path2 = mapper.MapSequence(read2);
-    for (const auto& listener : listeners_[ilib]) {
-        listener->ProcessPairedRead(ithread, r, path1, path2);
-        listener->ProcessSingleRead(ithread, r.first(), path1);
-        listener->ProcessSingleRead(ithread, r.second(), path2);
-    }
+    // Both ends of all the pairs are mapped as a single batch
+    std::vector<Sequence> sequences;
+    sequences.reserve(2 * reads.size());
+    for (const auto& r : reads)
+        sequences.push_back(r.first().sequence());
+    for (const auto& r : reads)
+        sequences.push_back(r.second().sequence());
+
+    std::vector<MappingPath<EdgeId>> paths1 = mapper.MapSequences(sequences);
+    std::vector<MappingPath<EdgeId>> paths2(std::make_move_iterator(paths1.begin() + reads.size()),
+                                            std::make_move_iterator(paths1.end()));
+    paths1.resize(reads.size());
+    for (const auto& listener : listeners_[ilib])
+        listener->ProcessPairedReads(ithread, reads, paths1, paths2);
 }
 
 template<>
-void SequenceMapperNotifier::NotifyProcessRead(const io::PairedRead& r,
-                                               const SequenceMapperT& mapper,
-                                               size_t ilib,
-                                               size_t ithread) const
+void SequenceMapperNotifier::NotifyProcessReads(const std::vector<io::PairedRead>& reads,
+                                                const SequenceMapperT& mapper,
+                                                size_t ilib,
+                                                size_t ithread) const
 {
-    MappingPath<EdgeId> path1 = mapper.MapRead(r.first());
-    MappingPath<EdgeId> path2 = mapper.MapRead(r.second());
-    for (const auto& listener : listeners_[ilib]) {
-        listener->ProcessPairedRead(ithread, r, path1, path2);
-        listener->ProcessSingleRead(ithread, r.first(), path1);
-        listener->ProcessSingleRead(ithread, r.second(), path2);
+    std::vector<MappingPath<EdgeId>> paths1, paths2;
+    paths1.reserve(reads.size());
+    paths2.reserve(reads.size());
+    for (const auto& r : reads) {
+        paths1.push_back(mapper.MapRead(r.first()));
+        paths2.push_back(mapper.MapRead(r.second()));
     }
+    for (const auto& listener : listeners_[ilib])
+        listener->ProcessPairedReads(ithread, reads, paths1, paths2);
 }
 
 template<>
-void SequenceMapperNotifier::NotifyProcessRead(const io::SingleReadSeq& r,
-                                               const SequenceMapperT& mapper,
-                                               size_t ilib,
-                                               size_t ithread) const
+void SequenceMapperNotifier::NotifyProcessReads(const std::vector<io::SingleReadSeq>& reads,
+                                                const SequenceMapperT& mapper,
+                                                size_t ilib,
+                                                size_t ithread) const
 {
-    const Sequence& read = r.sequence();
-    MappingPath<EdgeId> path = mapper.MapSequence(read);
+    std::vector<Sequence> sequences;
+    sequences.reserve(reads.size());
+    for (const auto& r : reads)
+        sequences.push_back(r.sequence());
+
+    std::vector<MappingPath<EdgeId>> paths = mapper.MapSequences(sequences);
     for (const auto& listener : listeners_[ilib])
-        listener->ProcessSingleRead(ithread, r, path);
+        listener->ProcessSingleReads(ithread, reads, paths);
 }
 
 template<>
-void SequenceMapperNotifier::NotifyProcessRead(const io::SingleRead& r,
-                                               const SequenceMapperT& mapper,
-                                               size_t ilib,
-                                               size_t ithread) const
+void SequenceMapperNotifier::NotifyProcessReads(const std::vector<io::SingleRead>& reads,
+                                                const SequenceMapperT& mapper,
+                                                size_t ilib,
+                                                size_t ithread) const
 {
-    MappingPath<EdgeId> path = mapper.MapRead(r);
+    std::vector<MappingPath<EdgeId>> paths;
+    paths.reserve(reads.size());
+    for (const auto& r : reads)
+        paths.push_back(mapper.MapRead(r));
     for (const auto& listener : listeners_[ilib])
-        listener->ProcessSingleRead(ithread, r, path);
+        listener->ProcessSingleReads(ithread, reads, paths);
 }
 
 } // namespace debruijn_graph
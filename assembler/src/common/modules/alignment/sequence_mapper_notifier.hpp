@@ -15,8 +15,11 @@
 #include "io/reads/paired_read.hpp"
 #include "io/reads/read_stream_vector.hpp"
 
+#include "utils/parallel/openmp_wrapper.h"
 #include "utils/perf/timetracer.hpp"
 
+#include <atomic>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -35,6 +38,18 @@ public:
     virtual void ProcessSingleRead(size_t /* thread_index */, const io::SingleRead& /* r */, const MappingPath<EdgeId>& /* read */) {}
     virtual void ProcessSingleRead(size_t /* thread_index */, const io::SingleReadSeq& /* r */, const MappingPath<EdgeId>& /* read */) {}
 
+    // Batch callbacks, by default they pass every read (and every end of a paired read) to the ones above
+    virtual void ProcessPairedReads(size_t thread_index, const std::vector<io::PairedRead>& reads,
+                                    const std::vector<MappingPath<EdgeId>>& paths1,
+                                    const std::vector<MappingPath<EdgeId>>& paths2);
+    virtual void ProcessPairedReads(size_t thread_index, const std::vector<io::PairedReadSeq>& reads,
+                                    const std::vector<MappingPath<EdgeId>>& paths1,
+                                    const std::vector<MappingPath<EdgeId>>& paths2);
+    virtual void ProcessSingleReads(size_t thread_index, const std::vector<io::SingleRead>& reads,
+                                    const std::vector<MappingPath<EdgeId>>& paths);
+    virtual void ProcessSingleReads(size_t thread_index, const std::vector<io::SingleReadSeq>& reads,
+                                    const std::vector<MappingPath<EdgeId>>& paths);
+
     virtual void MergeBuffer(size_t /* thread_index */) {}
     
     virtual ~SequenceMapperListener() {}
@@ -42,7 +57,12 @@ public:
 
 class SequenceMapperNotifier {
     static constexpr size_t BUFFER_SIZE = 200000;
+    static constexpr size_t BATCH_SIZE = 1000;
 public:
+    // Binary read streams for ProcessLibrary are split this many times finer than the threads.
+    // Binary streams open their files lazily, so only the streams being read hold descriptors
+    static constexpr size_t STREAM_SPLIT_FACTOR = 8;
+
     typedef SequenceMapper<Graph> SequenceMapperT;
 
     typedef std::vector<SequenceMapperListener*> ListenersContainer;
@@ -51,42 +71,54 @@ public:
 
     void Subscribe(size_t lib_index, SequenceMapperListener* listener);
 
+    /**
+     * Streams are dispatched to the threads dynamically, so splitting the library into more streams than
+     * threads (see STREAM_SPLIT_FACTOR) keeps all the threads busy until the last
+     * stream. Threads merge their buffers into each listener independently and without waiting: if another
+     * thread is merging into the same listener at the moment, the merge is retried after the next batch.
+     */
     template<class ReadType>
     void ProcessLibrary(io::ReadStreamList<ReadType>& streams,
                         size_t lib_index, const SequenceMapperT& mapper, size_t threads_count = 0) {
         std::string lib_str = std::to_string(lib_index);
         TIME_TRACE_SCOPE("SequenceMapperNotifier::ProcessLibrary", lib_str);
         if (threads_count == 0)
-            threads_count = streams.size();
+            threads_count = std::max<size_t>(1, std::min<size_t>(streams.size(), omp_get_max_threads()));
 
         streams.reset();
         NotifyStartProcessLibrary(lib_index, threads_count);
-        size_t counter = 0, n = 15;
+        std::atomic<size_t> counter{0}, next_stream{0};
+        std::vector<std::mutex> merge_locks(listeners_[lib_index].size());
 
-        #pragma omp parallel for num_threads(threads_count) shared(counter)
-        for (size_t i = 0; i < streams.size(); ++i) {
+        #pragma omp parallel num_threads(threads_count)
+        {
+            size_t thread = omp_get_thread_num();
+            std::vector<bool> unmerged(merge_locks.size(), false);
             size_t size = 0;
-            ReadType r;
-            auto& stream = streams[i];
-            while (!stream.eof()) {
-                if (size == BUFFER_SIZE) {
-                    #pragma omp critical
-                    {
-                        counter += size;
-                        if (counter >> n) {
-                            INFO("Processed " << counter << " reads");
-                            n += 1;
-                        }
+            std::vector<ReadType> reads;
+            reads.reserve(BATCH_SIZE);
+            for (size_t i = next_stream++; i < streams.size(); i = next_stream++) {
+                auto& stream = streams[i];
+                TIME_TRACE_THREAD_SCOPE("SequenceMapperNotifier::ProcessLibrary stream");
+                while (!stream.eof()) {
+                    // Reads are mapped and passed to the listeners in batches
+                    reads.clear();
+                    while (reads.size() < BATCH_SIZE && !stream.eof()) {
+                        reads.emplace_back();
+                        stream >> reads.back();
+                    }
+                    NotifyProcessReads(reads, mapper, lib_index, thread);
+                    TIME_TRACE_COUNTER(ReadsMapped, reads.size());
+                    ReportProgress(counter, reads.size());
+
+                    size += reads.size();
+                    if (size >= BUFFER_SIZE) {
+                        unmerged.assign(unmerged.size(), true);
                         size = 0;
-                        NotifyMergeBuffer(lib_index, i);
                     }
+                    TryMergeBuffers(lib_index, thread, unmerged, merge_locks);
                 }
-                stream >> r;
-                ++size;
-                NotifyProcessRead(r, mapper, lib_index, i);
             }
-            #pragma omp atomic
-            counter += size;
         }
 
         for (size_t i = 0; i < threads_count; ++i)
@@ -98,7 +130,8 @@ public:
 
 private:
     template<class ReadType>
-    void NotifyProcessRead(const ReadType& r, const SequenceMapperT& mapper, size_t ilib, size_t ithread) const;
+    void NotifyProcessReads(const std::vector<ReadType>& reads, const SequenceMapperT& mapper,
+                            size_t ilib, size_t ithread) const;
 
     void NotifyStartProcessLibrary(size_t ilib, size_t thread_count) const;
 
@@ -106,6 +139,11 @@ private:
 
     void NotifyMergeBuffer(size_t ilib, size_t ithread) const;
 
+    void TryMergeBuffers(size_t ilib, size_t ithread,
+                         std::vector<bool> &unmerged, std::vector<std::mutex> &locks) const;
+
+    static void ReportProgress(std::atomic<size_t> &counter, size_t processed);
+
     const GraphPack& gp_;
 
     std::vector<std::vector<SequenceMapperListener*> > listeners_;  //first vector's size = count libs
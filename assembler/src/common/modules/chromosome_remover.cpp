@@ -48,48 +48,33 @@ void ChromosomeRemover::FillForbiddenSet(Graph &g, VertexSet &forbidden) {
     }
 }
 
-size_t ChromosomeRemover::CalculateComponentSize(EdgeId e, const Graph &g) {
-    std::unordered_set<EdgeId> next;
-    size_t deadend_count = 0;
-    next.insert(e);
-    std::unordered_set<EdgeId> used;
-    size_t ans = 0;
-    while (!next.empty()) {
-        auto cur = *next.begin();
-        next.erase(next.begin());
-        if (used.count(cur)) {
-            continue;
-        }
-        ans += g.length(cur);
-
-        used.insert(cur);
-        std::vector<EdgeId> neighbours;
-        neighbours.push_back(g.conjugate(cur));
-        auto start = g.EdgeStart(cur);
-        auto tmp = g.IncidentEdges(start);
-
-        neighbours.insert(neighbours.end(), tmp.begin(), tmp.end());
-        auto end = g.EdgeEnd(cur);
-        if (g.IsDeadStart(start))
-            deadend_count++;
-        if (g.IsDeadEnd(end))
-            deadend_count++;
-        tmp = g.IncidentEdges(end);
-        neighbours.insert(neighbours.end(), tmp.begin(), tmp.end());
-        for (auto ee:neighbours) {
-            if (!used.count(ee)) {
-                next.insert(ee);
-            }
+void ChromosomeRemover::CalculateComponents(const Graph &g) {
+    components_.Calculate();
+
+    deadends_count_.assign(components_.size(), 0);
+    long_vertex_component_.assign(g.max_vid(), 0);
+#   pragma omp parallel for schedule(guided)
+    for (size_t comp = 0; comp < components_.size(); ++comp) {
+        size_t size = components_.length(comp);
+        for (EdgeId edge : components_.edges(comp)) {
+            VertexId start = g.EdgeStart(edge), end = g.EdgeEnd(edge);
+            if (g.IsDeadStart(start))
+                deadends_count_[comp] += 1;
+            if (g.IsDeadEnd(end))
+                deadends_count_[comp] += 1;
+            // Vertices belong to a single component, so the slots are written by one thread
+            long_vertex_component_[start.int_id()] = size;
+            long_vertex_component_[end.int_id()] = size;
         }
     }
-    for (EdgeId edge: used) {
-        long_component_[edge] = ans;
-        long_vertex_component_[g.EdgeStart(edge)] = ans;
-        long_vertex_component_[g.EdgeEnd(edge)] = ans;
-        deadends_count_[edge] = deadend_count;
-    }
-    component_list_.push_back(std::vector<EdgeId>(used.begin(), used.end()));
-    return ans;
+}
+
+size_t ChromosomeRemover::ComponentSize(EdgeId e) const {
+    return components_.contains(e) ? components_.length(components_.component(e)) : 0;
+}
+
+size_t ChromosomeRemover::DeadendCount(EdgeId e) const {
+    return components_.contains(e) ? deadends_count_[components_.component(e)] : 0;
 }
 
 double ChromosomeRemover::RemoveLongGenomicEdges(size_t long_edge_bound, double coverage_limits, double external_chromosome_coverage) {
@@ -117,11 +102,7 @@ double ChromosomeRemover::RemoveLongGenomicEdges(size_t long_edge_bound, double
         } else {
             INFO(size_t((1 - fraction) * 100) << "% of bases from long edges have coverage significantly different from median");
         }
-        for (EdgeId e : graph.edges()) {
-            if (!long_component_.count(e)) {
-                CalculateComponentSize(e, graph);
-            }
-        }
+        CalculateComponents(graph);
         INFO("Connected components calculated");
     } else {
         median_long_edge_coverage = external_chromosome_coverage;
@@ -138,8 +119,8 @@ double ChromosomeRemover::RemoveLongGenomicEdges(size_t long_edge_bound, double
             continue;
 
         DEBUG("Considering long edge: id " << graph.int_id(e) << " length: " << graph.length(e) << " coverage: " << graph.coverage(e));
-        if (long_component_.count(e) && 300000 > long_component_[e] && deadends_count_[e] == 0) {
-            DEBUG("Edge " << graph.int_id(e) << " skipped - because of small nondeadend connected component of size " << long_component_[e]);
+        if (components_.contains(e) && 300000 > ComponentSize(e) && DeadendCount(e) == 0) {
+            DEBUG("Edge " << graph.int_id(e) << " skipped - because of small nondeadend connected component of size " << ComponentSize(e));
         } else {
             DEBUG("Edge " << graph.int_id(e) << " deleted");
             deleted += 1;
@@ -225,24 +206,16 @@ void ChromosomeRemover::RemoveNearlyEverythingByCoverage(double cur_limit) {
 
 vector<vector<EdgeId>> ChromosomeRemover::GetNineShapeComponents () {
     const auto& graph = gp_.get<Graph>();
-    long_vertex_component_.clear();
-    long_component_.clear();
-    deadends_count_.clear();
-    component_list_.clear();
     vector<vector<EdgeId>> res;
 
-    for (EdgeId e : graph.edges()) {
-        if (long_component_.count(e) == 0) {
-            CalculateComponentSize(e, graph);
-        }
-    }
+    CalculateComponents(graph);
     size_t count = 0;
-    for (auto &comp: component_list_) {
-        if (comp.size() == 4) {
-            EdgeId first_edge = comp[0];
+    for (size_t comp_id = 0; comp_id < components_.size(); ++comp_id) {
+        if (components_.edge_count(comp_id) == 4) {
+            vector<EdgeId> comp(components_.edges(comp_id).begin(), components_.edges(comp_id).end());
 //conjugate, so /2
-            size_t comp_size = (long_component_[first_edge])/2;
-            size_t deadends_count = deadends_count_[first_edge] ;
+            size_t comp_size = components_.length(comp_id) / 2;
+            size_t deadends_count = deadends_count_[comp_id];
             if (deadends_count != 2)
                 break;
             int incoming = -1;
@@ -272,10 +245,6 @@ vector<vector<EdgeId>> ChromosomeRemover::GetNineShapeComponents () {
 
 void ChromosomeRemover::OutputSuspiciousComponents () {
     auto& graph = gp_.get_mutable<Graph>();
-    long_vertex_component_.clear();
-    long_component_.clear();
-    deadends_count_.clear();
-    component_list_.clear();
     size_t component_size_max = 200000;
     size_t component_size_min = 1000;
     std::string tmp = std::to_string(ext_limit_);
@@ -283,21 +252,17 @@ void ChromosomeRemover::OutputSuspiciousComponents () {
     std::string out_file = "components" + tmp + ".fasta";
     double var = 0.3;
     DEBUG("calculating component sizes");
-    for (EdgeId e: graph.canonical_edges()) {
-        if (!long_component_.count(e)) {
-            CalculateComponentSize(e, graph);
-        }
-    }
+    CalculateComponents(graph);
     CoverageUniformityAnalyzer coverage_analyzer(graph, 0);
     std::ofstream is(cfg::get().output_dir + out_file);
     size_t component_count = 1;
     const auto& used_edges = gp_.get<SmartContainer<std::unordered_set<EdgeId>, Graph>>("used_edges");
-    for (auto &comp: component_list_) {
-        VERIFY(comp.size() > 0);
-        EdgeId first_edge = comp[0];
+    for (size_t comp_id = 0; comp_id < components_.size(); ++comp_id) {
+        auto comp = components_.edges(comp_id);
+        VERIFY(components_.edge_count(comp_id) > 0);
 //conjugate, so /2
-        size_t comp_size = (long_component_[first_edge])/2;
-        size_t deadends_count = deadends_count_[first_edge] ;
+        size_t comp_size = components_.length(comp_id) / 2;
+        size_t deadends_count = deadends_count_[comp_id];
         if (comp_size > component_size_min && comp_size < component_size_max &&
             (deadends_count <= 4)) {
             DEBUG("Checking component size " << comp_size);
@@ -434,30 +399,26 @@ void ChromosomeRemover::RunIsolatedPipeline() {
 void ChromosomeRemover::FilterSmallComponents() {
     auto& graph = gp_.get_mutable<Graph>();
     //Small repetitive components after filtering
-    std::unordered_map<VertexId, size_t> old_vertex_weights(long_vertex_component_.begin(), long_vertex_component_.end());
+    std::vector<size_t> old_vertex_weights(long_vertex_component_);
+    auto old_vertex_weight = [&](VertexId v) -> size_t {
+        return v.int_id() < old_vertex_weights.size() ? old_vertex_weights[v.int_id()] : 0;
+    };
     for (size_t i = 0; i < max_iteration_count; i++) {
         DEBUG("Iteration " << i);
         size_t graph_size = graph.size();
-        long_vertex_component_.clear();
-        long_component_.clear();
-        deadends_count_.clear();
         DEBUG("Calculating component sizes");
-        for (EdgeId e: graph.canonical_edges()) {
-            if (!long_component_.count(e)) {
-                CalculateComponentSize(e, graph);
-            }
-        }
+        CalculateComponents(graph);
         DEBUG("Component sizes calculated");
 //removing edges of coverage ~chromosome coverage that before this iteration were in relatively large components and now are in relatively small ones - both isolated and small components.
         for (auto iter = graph.SmartEdgeBegin(); !iter.IsEnd(); ++iter) {
             EdgeId e = *iter;
-            if (long_component_[e] >= 2 * plasmid_config_.small_component_size)
+            if (ComponentSize(e) >= 2 * plasmid_config_.small_component_size)
                 continue;
 
             if (graph.IsDeadEnd(graph.EdgeEnd(e)) && graph.IsDeadStart(graph.EdgeStart(e)) &&
-                old_vertex_weights.count(graph.EdgeStart(e)) &&
+                old_vertex_weight(graph.EdgeStart(e)) &&
                 // * 2 - because all coverages are taken with rc
-                old_vertex_weights[graph.EdgeStart(e)] > long_component_[e] + plasmid_config_.long_edge_length * 2)  {
+                old_vertex_weight(graph.EdgeStart(e)) > ComponentSize(e) + plasmid_config_.long_edge_length * 2)  {
                 DEBUG("Deleting isolated edge of length" << graph.length(e));
                 graph.DeleteEdge(e);
             }
@@ -465,14 +426,13 @@ void ChromosomeRemover::FilterSmallComponents() {
         DEBUG("isolated deleted");
         for (auto iter = graph.SmartEdgeBegin(); !iter.IsEnd(); ++iter) {
             EdgeId e = *iter;
-            if (long_component_[e] >= 2 * plasmid_config_.small_component_size)
+            if (ComponentSize(e) >= 2 * plasmid_config_.small_component_size)
                 continue;
 
-            if (old_vertex_weights.count(graph.EdgeStart(e)) &&
-                old_vertex_weights[graph.EdgeStart(e)] > plasmid_config_.small_component_size * 4 &&
+            if (old_vertex_weight(graph.EdgeStart(e)) > plasmid_config_.small_component_size * 4 &&
                 graph.coverage(e) < chromosome_coverage_ * (1 + plasmid_config_.small_component_relative_coverage) &&
                 graph.coverage(e) > chromosome_coverage_ * (1 - plasmid_config_.small_component_relative_coverage)) {
-                DEBUG("Deleting edge from fake small component, length " << graph.length(e) << " id " << graph.int_id(e) << " coverage " << graph.coverage(e) << " component_size " << old_vertex_weights[graph.EdgeStart(e)]);
+                DEBUG("Deleting edge from fake small component, length " << graph.length(e) << " id " << graph.int_id(e) << " coverage " << graph.coverage(e) << " component_size " << old_vertex_weight(graph.EdgeStart(e)));
                 graph.DeleteEdge(e);
             }
         }
@@ -482,9 +442,9 @@ void ChromosomeRemover::FilterSmallComponents() {
 // TODO:: think, whether it may be bad in viral setting.
         for (auto iter = graph.SmartEdgeBegin(); !iter.IsEnd(); ++iter) {
             EdgeId e = *iter;
-            bool should_leave = deadends_count_[e] == 0;
+            bool should_leave = DeadendCount(e) == 0;
             should_leave &= graph.length(e) > plasmid_config_.min_isolated_length;
-            if (long_component_[e] < 2 * plasmid_config_.min_component_length &&
+            if (ComponentSize(e) < 2 * plasmid_config_.min_component_length &&
                 !should_leave) {
                 graph.DeleteEdge(e);
             }
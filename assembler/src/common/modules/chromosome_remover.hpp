@@ -7,6 +7,7 @@
 #pragma once
 
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/components/connected_component.hpp"
 #include "pipeline/graph_pack.hpp"
 #include "pipeline/config_struct.hpp"
 #include <unordered_set>
@@ -18,8 +19,8 @@ namespace debruijn_graph {
 class ChromosomeRemover {
 public:
     ChromosomeRemover(GraphPack &gp, size_t ext_limit, config::debruijn_config::plasmid plasmid_config)
-            : gp_(gp), ext_limit_(ext_limit), plasmid_config_(plasmid_config), chromosome_coverage_((double) ext_limit), long_component_(), long_vertex_component_(),
-              deadends_count_(), component_list_(), full_name_(std::string("chromosome_removal") + (ext_limit == 0 ? std::string(""):std::to_string(ext_limit))) {
+            : gp_(gp), ext_limit_(ext_limit), plasmid_config_(plasmid_config), chromosome_coverage_((double) ext_limit), components_(gp.get<Graph>()),
+              full_name_(std::string("chromosome_removal") + (ext_limit == 0 ? std::string(""):std::to_string(ext_limit))) {
     }
 
     void run(GraphPack &gp, const char *);
@@ -32,15 +33,19 @@ private:
     size_t ext_limit_;
     config::debruijn_config::plasmid plasmid_config_;
     double chromosome_coverage_;
-    std::unordered_map <EdgeId, size_t> long_component_;
-    std::unordered_map <VertexId, size_t> long_vertex_component_;
-    std::unordered_map <EdgeId, size_t> deadends_count_;
-    std::vector<std::vector<EdgeId>> component_list_;
+    EdgeComponents components_;
+    // Dead ends in every component of components_
+    std::vector<size_t> deadends_count_;
+    // Lengths of the components of the vertices, indexed by vertex id, zero for the vertices without edges
+    std::vector<size_t> long_vertex_component_;
 
     std::string full_name_;
     const size_t max_iteration_count = 30;
 
-    size_t CalculateComponentSize(debruijn_graph::EdgeId e, const Graph &g);
+    void CalculateComponents(const Graph &g);
+    // Zero for the edges added after the components are calculated
+    size_t ComponentSize(EdgeId e) const;
+    size_t DeadendCount(EdgeId e) const;
 
     double RemoveLongGenomicEdges(size_t long_edge_bound, double coverage_limits,
                                   double external_chromosome_coverage = 0);
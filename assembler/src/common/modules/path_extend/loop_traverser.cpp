@@ -131,9 +131,10 @@ bool LoopTraverser::TraverseLoop(EdgeId start, EdgeId end, const std::set<Vertex
         VertexId first_vertex = g_.EdgeStart(end_path.Front());
 
         if (first_vertex != last_vertex) {
-            auto dijkstra = omnigraph::DijkstraHelper<Graph>::CreateBoundedDijkstra(g_, shortest_path_limit_,
-                                                                                    DIJKSTRA_LIMIT,
-                                                                                    true /* collect traceback */);
+            typedef omnigraph::DijkstraHelper<Graph, omnigraph::RadixHeapDijkstra> DijkstraHelperT;
+            auto dijkstra = DijkstraHelperT::CreateBoundedDijkstra(g_, shortest_path_limit_,
+                                                                   DIJKSTRA_LIMIT,
+                                                                   true /* collect traceback */);
             dijkstra.Run(last_vertex);
             auto shortest_path = dijkstra.GetShortestPathTo(first_vertex);
 
@@ -13,17 +13,28 @@
 #include "assembly_graph/paths/bidirectional_path_container.hpp"
 
 #include "adt/flat_map.hpp"
+#include "adt/iterator_range.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include "parallel_hashmap/phmap.h"
 
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
 namespace path_extend {
 
 using namespace debruijn_graph;
 
 // Handles all paths in PathContainer.
 // For each edge output all paths  that _traverse_ this path. If path contains multiple instances - count them. Position of the edge is not reported.
+// Subscribed paths are tracked incrementally. The paths added without subscription never change the map afterwards,
+// so they are indexed in bulk: the entries are collected in parallel and packed into per-edge ranges (CSR).
+// A map keeps either subscribed paths or bulk-added ones.
 class GraphCoverageMap: public PathListener {
 public:
     typedef adt::flat_map<BidirectionalPath*, size_t> MapDataT;
+    typedef MapDataT::const_iterator entry_iterator;
+    typedef adt::iterator_range<entry_iterator> EdgePaths;
 
 private:
     const Graph& g_;
@@ -31,6 +42,15 @@ private:
     phmap::parallel_flat_hash_map<EdgeId, MapDataT> edge_coverage_;
     const MapDataT empty_;
 
+    // Bulk index, the entries of edge e are entries_[offsets_[e] .. offsets_[e + 1]) sorted by path
+    std::vector<size_t> offsets_;
+    std::vector<MapDataT::value_type> entries_;
+    size_t covered_edges_;
+
+    bool bulk() const {
+        return !offsets_.empty();
+    }
+
     void EdgeAdded(EdgeId e, BidirectionalPath &path) {
         edge_coverage_[e][&path] += 1;
     }
@@ -51,22 +71,99 @@ private:
         }
     }
 
-    void ProcessPath(BidirectionalPath &path, bool subscribe) {
-        if (subscribe)
-            path.Subscribe(*this);
-        
+    void ProcessPath(BidirectionalPath &path) {
+        VERIFY_MSG(!bulk(), "Paths cannot be subscribed to the coverage map built in bulk");
+        path.Subscribe(*this);
+
         for (size_t i = 0; i < path.Size(); ++i) {
             EdgeAdded(path.At(i), path);
         }
     }
 
+    struct BulkEntry {
+        size_t edge;
+        BidirectionalPath *path;
+        size_t count;
+    };
+
+    static void CollectEntries(BidirectionalPath &path, std::vector<BulkEntry> &entries) {
+        std::vector<size_t> edges;
+        edges.reserve(path.Size());
+        for (size_t i = 0; i < path.Size(); ++i)
+            edges.push_back(path.At(i).int_id());
+        std::sort(edges.begin(), edges.end());
+        for (size_t i = 0; i < edges.size();) {
+            size_t j = i;
+            while (j < edges.size() && edges[j] == edges[i])
+                ++j;
+            entries.push_back({edges[i], &path, j - i});
+            i = j;
+        }
+    }
+
+    void BuildIndex(const PathContainer& paths) {
+        VERIFY_MSG(edge_coverage_.empty(), "Paths cannot be added in bulk to the coverage map with subscribed paths");
+        // const PathContainer keeps mutable paths, the map stores non-const pointers as before
+        auto &mutable_paths = const_cast<PathContainer&>(paths);
+
+        std::vector<std::vector<BulkEntry>> collected(omp_get_max_threads());
+        #pragma omp parallel for schedule(guided)
+        for (size_t i = 0; i < mutable_paths.size(); ++i) {
+            auto &entries = collected[omp_get_thread_num()];
+            CollectEntries(mutable_paths.Get(i), entries);
+            CollectEntries(mutable_paths.GetConjugate(i), entries);
+        }
+
+        // Entries added earlier go to the new index as well
+        std::vector<BulkEntry> old_entries;
+        for (size_t e = 0; e + 1 < offsets_.size(); ++e) {
+            for (size_t i = offsets_[e]; i < offsets_[e + 1]; ++i)
+                old_entries.push_back({e, entries_[i].first, entries_[i].second});
+        }
+        collected.push_back(std::move(old_entries));
+
+        size_t max_id = g_.max_eid();
+        std::vector<size_t> offsets(max_id + 1, 0);
+        for (const auto &entries : collected) {
+            for (const auto &entry : entries)
+                offsets[entry.edge + 1] += 1;
+        }
+        std::partial_sum(offsets.begin(), offsets.end(), offsets.begin());
+
+        std::vector<MapDataT::value_type> index(offsets.back());
+        std::vector<size_t> pos(offsets.begin(), offsets.end() - 1);
+        for (auto &entries : collected) {
+            for (const auto &entry : entries)
+                index[pos[entry.edge]++] = {entry.path, entry.count};
+            std::vector<BulkEntry>().swap(entries);
+        }
+
+        size_t covered = 0;
+        #pragma omp parallel for schedule(guided) reduction(+:covered)
+        for (size_t e = 0; e < max_id; ++e) {
+            std::sort(index.begin() + offsets[e], index.begin() + offsets[e + 1]);
+            covered += offsets[e + 1] > offsets[e];
+        }
+
+        offsets_ = std::move(offsets);
+        entries_ = std::move(index);
+        covered_edges_ = covered;
+    }
+
+    EdgePaths BulkEntries(EdgeId e) const {
+        size_t id = e.int_id();
+        if (id + 1 >= offsets_.size())
+            return adt::make_range(entries_.end(), entries_.end());
+        return adt::make_range(entries_.begin() + offsets_[id], entries_.begin() + offsets_[id + 1]);
+    }
+
 public:
     GraphCoverageMap(const GraphCoverageMap&) = delete;
     GraphCoverageMap& operator=(const GraphCoverageMap&) = delete;
 
     GraphCoverageMap(GraphCoverageMap&&) = default;
 
-    explicit GraphCoverageMap(const Graph& g) : g_(g) {
+    explicit GraphCoverageMap(const Graph& g) : g_(g), covered_edges_(0) {
         //FIXME heavy constructor
         edge_coverage_.reserve(g_.e_size());
     }
@@ -79,19 +176,24 @@ public:
     ~GraphCoverageMap() {}
 
     void AddPaths(const PathContainer& paths, bool subscribe = false) {
+        if (!subscribe) {
+            BuildIndex(paths);
+            return;
+        }
+
         for (auto &path_pair : paths) {
-            ProcessPath(*path_pair.first, subscribe);
-            ProcessPath(*path_pair.second, subscribe);
+            ProcessPath(*path_pair.first);
+            ProcessPath(*path_pair.second);
         }
     }
 
     void Subscribe(BidirectionalPath &path) {
-        ProcessPath(path, true);
+        ProcessPath(path);
     }
 
     void Subscribe(std::pair<BidirectionalPath&, BidirectionalPath&> ppair) {
-        ProcessPath(ppair.first, true);
-        ProcessPath(ppair.second, true);
+        ProcessPath(ppair.first);
+        ProcessPath(ppair.second);
     }
 
     //Inherited from PathListener
@@ -114,26 +216,29 @@ public:
         EdgeRemoved(e, path);
     }
 
-    const MapDataT &GetEdgePaths(EdgeId e) const {
+    // Paths with their multiplicities
+    EdgePaths GetEdgePaths(EdgeId e) const {
+        if (bulk())
+            return BulkEntries(e);
+
         auto iter = edge_coverage_.find(e);
-        if (iter != edge_coverage_.end()) {
-            return iter->second;
-        }
-        return empty_;
+        const MapDataT &entries = (iter != edge_coverage_.end() ? iter->second : empty_);
+        return adt::make_range(entries.begin(), entries.end());
     }
 
     size_t Count(EdgeId e, const BidirectionalPath &path) const {
-        auto entry = edge_coverage_.find(e);
-        if (entry == edge_coverage_.end())
-            return 0;
-
-        auto cov = entry->second.find(const_cast<BidirectionalPath*>(&path));
-        return (cov == entry->second.end() ? 0 : cov->second);
+        auto entries = GetEdgePaths(e);
+        auto key = const_cast<BidirectionalPath*>(&path);
+        auto cov = std::lower_bound(entries.begin(), entries.end(), key,
+                                    [](const MapDataT::value_type &entry, BidirectionalPath *p) {
+                                        return entry.first < p;
+                                    });
+        return (cov == entries.end() || cov->first != key ? 0 : cov->second);
     }
 
     size_t GetCoverage(EdgeId e) const {
-        auto iter = edge_coverage_.find(e);
-        return (iter != edge_coverage_.end() ? iter->second.size() : 0);
+        auto entries = GetEdgePaths(e);
+        return size_t(std::distance(entries.begin(), entries.end()));
     }
 
     bool IsCovered(EdgeId e) const {
@@ -150,26 +255,15 @@ public:
 
     BidirectionalPathSet GetCoveringPaths(EdgeId e) const {
         BidirectionalPathSet res;
-        auto iter = edge_coverage_.find(e);
-        if (iter == edge_coverage_.end())
-            return res;
-
-        for (const auto &entry : iter->second)
+        for (const auto &entry : GetEdgePaths(e))
             res.insert(entry.first);
 
         return res;
     }
 
-    auto begin() const {
-        return edge_coverage_.begin();
-    }
-
-    auto end() const {
-        return edge_coverage_.end();
-    }
-
+    // Number of edges ever covered by the paths
     size_t size() const {
-        return edge_coverage_.size();
+        return bulk() ? covered_edges_ : edge_coverage_.size();
     }
 
     const Graph& graph() const {
@@ -242,7 +242,8 @@ Connections AssemblyGraphConnectionCondition::ConnectedWith(debruijn_graph::Edge
             stored_distances_[e].emplace(connected, 1);
         }
     }
-    auto dijkstra = omnigraph::DijkstraHelper<debruijn_graph::Graph>::CreateBoundedDijkstra(g_, max_connection_length_);
+    typedef omnigraph::DijkstraHelper<debruijn_graph::Graph, omnigraph::RadixHeapDijkstra> DijkstraHelperT;
+    auto dijkstra = DijkstraHelperT::CreateBoundedDijkstra(g_, max_connection_length_);
     dijkstra.Run(g_.EdgeEnd(e));
     for (auto v: dijkstra.ReachedVertices()) {
         for (auto connected: g_.OutgoingEdges(v)) {
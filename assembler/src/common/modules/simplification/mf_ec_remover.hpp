@@ -11,345 +11,303 @@
 #include "cleaner.hpp"
 #include "assembly_graph/graph_support/graph_processing_algorithm.hpp"
 
-#include <map>
+#include <limits>
+#include <numeric>
 #include <queue>
+#include <set>
+#include <unordered_map>
+#include <vector>
 
 namespace omnigraph {
 
-template<class Graph>
-class FlowGraph {
+/*
+ * Residual network in CSR form. Arcs are collected first and packed into per-vertex
+ * ranges by Build(), every arc gets a reverse twin with zero capacity there.
+ */
+class FlowNetwork {
 public:
     typedef size_t FlowVertexId;
-    typedef std::pair<FlowVertexId, FlowVertexId> FlowEdgeId;
+    typedef size_t ArcId;
 
-private:
-    typedef typename Graph::VertexId OuterVertexId;
-    std::map<OuterVertexId, FlowVertexId> vertex_mapping_;
-    std::map<FlowVertexId, std::map<FlowVertexId, int>> capacities_;
-    std::set<FlowVertexId> vertices_;
-    size_t vertex_number_;
-    FlowVertexId source_;
-    FlowVertexId sink_;
+    FlowNetwork()
+            : vertex_number_(0), built_(false) {}
 
     FlowVertexId AddVertex() {
-        vertices_.insert(vertex_number_);
-        capacities_[vertex_number_];
-        vertex_number_++;
-        return vertex_number_ - 1;
-    }
-
-    void PushFlow(FlowEdgeId edge, int capacity) {
-        VERIFY(capacities_[EdgeStart(edge)][EdgeEnd(edge)] >= capacity);
-        capacities_[EdgeStart(edge)][EdgeEnd(edge)] -= capacity;
-        capacities_[EdgeEnd(edge)][EdgeStart(edge)] += capacity;
+        VERIFY(!built_);
+        return vertex_number_++;
     }
 
-    void AddEdge(FlowVertexId first, FlowVertexId second, int capacity = 10000) {
-        capacities_[first][second] += capacity; // operator [] creates entry with default values in case argument is not in keyset
-        capacities_[second][first] += 0;
+    void AddArc(FlowVertexId from, FlowVertexId to, int capacity) {
+        VERIFY(!built_ && from < vertex_number_ && to < vertex_number_);
+        arcs_.push_back({from, to, capacity});
     }
 
-public:
-    FlowGraph() :
-            vertex_number_(0), source_(AddVertex()), sink_(AddVertex()) {
+    size_t size() const {
+        return vertex_number_;
     }
 
-    FlowVertexId GetCorrespondingVertex(OuterVertexId v) const {
-        return vertex_mapping_.find(v)->second;
-    }
-
-    bool HasCorrespondingVertex(OuterVertexId v) const {
-        return vertex_mapping_.find(v) == vertex_mapping_.end();
-    }
-
-    FlowVertexId AddVertex(OuterVertexId vertex) {
-        FlowVertexId new_vertex = AddVertex();
-        vertex_mapping_[vertex] = new_vertex;
-        return new_vertex;
-    }
-
-    void AddEdge(OuterVertexId outer_first, OuterVertexId outer_second,
-            int capacity = 10000) {
-        VERIFY(
-                vertex_mapping_.find(outer_first) != vertex_mapping_.end()
-                        && vertex_mapping_.find(outer_second)
-                                != vertex_mapping_.end());
-        FlowVertexId first = vertex_mapping_[outer_first];
-        FlowVertexId second = vertex_mapping_[outer_second];
-        AddEdge(first, second, capacity);
-    }
-
-    void AddSource(OuterVertexId vertex, int capacity) {
-        AddEdge(source_, GetCorrespondingVertex(vertex), capacity);
-    }
+    void Build() {
+        VERIFY(!built_);
+        offsets_.assign(vertex_number_ + 1, 0);
+        for (const auto &arc : arcs_) {
+            offsets_[arc.from + 1] += 1;
+            offsets_[arc.to + 1] += 1;
+        }
+        std::partial_sum(offsets_.begin(), offsets_.end(), offsets_.begin());
+
+        heads_.resize(2 * arcs_.size());
+        residual_.resize(2 * arcs_.size());
+        twins_.resize(2 * arcs_.size());
+        std::vector<ArcId> pos(offsets_.begin(), offsets_.end() - 1);
+        for (const auto &arc : arcs_) {
+            ArcId direct = pos[arc.from]++, reverse = pos[arc.to]++;
+            heads_[direct] = arc.to;
+            residual_[direct] = arc.capacity;
+            twins_[direct] = reverse;
+            heads_[reverse] = arc.from;
+            residual_[reverse] = 0;
+            twins_[reverse] = direct;
+        }
 
-    void AddSink(OuterVertexId vertex, int capacity) {
-        AddEdge(GetCorrespondingVertex(vertex), sink_, capacity);
+        arcs_.clear();
+        arcs_.shrink_to_fit();
+        built_ = true;
     }
 
-    FlowVertexId Source() const {
-        return source_;
+    // Dinic's algorithm, the flow stays in the residual capacities
+    int MaxFlow(FlowVertexId source, FlowVertexId sink) {
+        VERIFY(built_);
+        int result = 0;
+        while (BuildLevels(source, sink))
+            result += BlockingFlow(source, sink);
+        return result;
     }
 
-    FlowVertexId Sink() const {
-        return sink_;
+    bool HasOutgoingResidual(FlowVertexId v) const {
+        for (ArcId a = offsets_[v]; a < offsets_[v + 1]; ++a) {
+            if (residual_[a] > 0)
+                return true;
+        }
+        return false;
     }
 
-    bool Connected(FlowVertexId start, FlowVertexId end) const {
-        return capacities_.find(start) != capacities_.end()
-                && capacities_.find(start)->second.find(end)
-                        != capacities_.find(start)->second.end()
-                && capacities_.find(start)->second.find(end)->second > 0;
+    bool HasIncomingResidual(FlowVertexId v) const {
+        for (ArcId a = offsets_[v]; a < offsets_[v + 1]; ++a) {
+            if (residual_[twins_[a]] > 0)
+                return true;
+        }
+        return false;
     }
 
-    std::vector<FlowEdgeId> OutgoingEdges(FlowVertexId v) const {
-        std::vector<FlowEdgeId> result;
-        const auto &outgoing = capacities_.find(v)->second;
-        for (auto it = outgoing.begin(); it != outgoing.end(); ++it) {
-            if (it->second > 0) {
-                result.emplace_back(v, it->first);
-            }
+    // Strongly connected components of the arcs with positive residual capacity (Kosaraju),
+    // returns the component of every vertex
+    std::vector<size_t> ResidualComponents() const {
+        VERIFY(built_);
+        std::vector<FlowVertexId> order;
+        order.reserve(vertex_number_);
+        std::vector<bool> visited(vertex_number_, false);
+        for (FlowVertexId v = 0; v < vertex_number_; ++v) {
+            if (!visited[v])
+                PostOrder(v, visited, order);
         }
-        return result;
-    }
 
-    std::vector<FlowEdgeId> IncomingEdges(FlowVertexId v) const {
-        std::vector<FlowEdgeId> result;
-        const auto &outgoing = capacities_.find(v)->second;
-        for (auto it = outgoing.begin(); it != outgoing.end(); ++it) {
-            if (Connected(it->first, v)) {
-                result.emplace_back(it->first, v);
+        std::vector<size_t> colouring(vertex_number_, NO_COMPONENT);
+        std::vector<FlowVertexId> stack;
+        size_t cc = 0;
+        for (auto it = order.rbegin(); it != order.rend(); ++it) {
+            if (colouring[*it] != NO_COMPONENT)
+                continue;
+            colouring[*it] = cc;
+            stack.push_back(*it);
+            while (!stack.empty()) {
+                FlowVertexId v = stack.back();
+                stack.pop_back();
+                for (ArcId a = offsets_[v]; a < offsets_[v + 1]; ++a) {
+                    FlowVertexId prev = heads_[a];
+                    if (residual_[twins_[a]] > 0 && colouring[prev] == NO_COMPONENT) {
+                        colouring[prev] = cc;
+                        stack.push_back(prev);
+                    }
+                }
             }
+            cc += 1;
         }
-        return result;
+        return colouring;
     }
 
-    size_t OutgoingEdgesCount(FlowVertexId v) const {
-        return OutgoingEdges(v).size();
-    }
+private:
+    struct Arc {
+        FlowVertexId from;
+        FlowVertexId to;
+        int capacity;
+    };
 
-    size_t IncomingEdgesCount(FlowVertexId v) const {
-        return IncomingEdges(v).size();
-    }
+    enum : size_t {
+        NO_LEVEL = std::numeric_limits<size_t>::max(),
+        NO_COMPONENT = std::numeric_limits<size_t>::max()
+    };
 
-    FlowVertexId EdgeStart(FlowEdgeId edge) const {
-        return edge.first;
-    }
+    size_t vertex_number_;
+    bool built_;
+    std::vector<Arc> arcs_;
 
-    FlowVertexId EdgeEnd(FlowEdgeId edge) const {
-        return edge.second;
-    }
+    std::vector<ArcId> offsets_;
+    std::vector<FlowVertexId> heads_;
+    std::vector<int> residual_;
+    std::vector<ArcId> twins_;
 
-    std::set<FlowVertexId>::iterator begin() const {
-        return vertices_.begin();
-    }
+    std::vector<size_t> levels_;
+    std::vector<ArcId> current_;
 
-    std::set<FlowVertexId>::iterator end() const {
-        return vertices_.end();
+    bool BuildLevels(FlowVertexId source, FlowVertexId sink) {
+        levels_.assign(vertex_number_, NO_LEVEL);
+        levels_[source] = 0;
+        std::queue<FlowVertexId> q;
+        q.push(source);
+        while (!q.empty()) {
+            FlowVertexId v = q.front();
+            q.pop();
+            for (ArcId a = offsets_[v]; a < offsets_[v + 1]; ++a) {
+                FlowVertexId next = heads_[a];
+                if (residual_[a] > 0 && levels_[next] == NO_LEVEL) {
+                    levels_[next] = levels_[v] + 1;
+                    q.push(next);
+                }
+            }
+        }
+        return levels_[sink] != NO_LEVEL;
     }
 
-    int GetCapacity(FlowVertexId first, FlowVertexId second) const {
-        auto it1 = capacities_.find(first);
-        if (it1 == capacities_.end())
-            return 0;
-        auto it2 = it1->second.find(second);
-        if (it2 == it1->second.end())
-            return 0;
-        return it2->second;
+    bool Admissible(FlowVertexId v, ArcId a) const {
+        return residual_[a] > 0 && levels_[heads_[a]] == levels_[v] + 1;
     }
 
-    void PushFlow(std::vector<FlowVertexId> path, int capacity) {
-        size_t n = path.size();
-        VERIFY(path[0] == source_ && path[n - 1] == sink_);
-        for (size_t i = 0; i + 1 < n; i++) {
-            PushFlow(std::make_pair(path[i], path[i + 1]), capacity);
-        }
-    }
+    int BlockingFlow(FlowVertexId source, FlowVertexId sink) {
+        current_.assign(offsets_.begin(), offsets_.end() - 1);
+        std::vector<ArcId> path;
+        int result = 0;
+        FlowVertexId v = source;
+        while (true) {
+            if (v == sink) {
+                int pushed = std::numeric_limits<int>::max();
+                for (ArcId a : path)
+                    pushed = std::min(pushed, residual_[a]);
+                for (ArcId a : path) {
+                    residual_[a] -= pushed;
+                    residual_[twins_[a]] += pushed;
+                }
+                result += pushed;
+
+                // Continue from the tail of the first saturated arc
+                size_t saturated = 0;
+                while (residual_[path[saturated]] > 0)
+                    saturated += 1;
+                v = heads_[twins_[path[saturated]]];
+                path.resize(saturated);
+                continue;
+            }
 
-//    void Print() const {
-//        for(auto it = vertex_mapping_.begin(); it != vertex_mapping_.end(); ++it) {
-//            TRACE(it->first << " " << it->second);
-//        }
-//        for(auto it = vertices_.begin(); it != vertices_.end();) {
-//            auto out = OutgoingEdges(*it);
-//            for(auto it1 = out.begin(); it1 != out.end(); ++it1) {
-//                TRACE("edge " << (*it1) << " " << GetCapacity(*it, it1->second));
-//            }
-//            ++it;
-//            if(it == vertices_.end())
-//                break;
-//        }
-//    }
-};
+            ArcId &a = current_[v];
+            while (a < offsets_[v + 1] && !Admissible(v, a))
+                ++a;
+            if (a < offsets_[v + 1]) {
+                path.push_back(a);
+                v = heads_[a];
+                continue;
+            }
 
-template<class Graph>
-class BFS {
-private:
-    const Graph &graph_;
-    typedef typename Graph::FlowVertexId FlowVertexId;
-    typedef typename Graph::FlowEdgeId FlowEdgeId;
-
-    std::vector<FlowVertexId> RestoreAnswer(FlowVertexId start, FlowVertexId end,
-                                            const std::map<FlowVertexId, FlowVertexId> &prev) {
-        std::vector<FlowVertexId> result = {end};
-        FlowVertexId current = end;
-        while (current != start) {
-            current = prev.find(current)->second;
-            result.push_back(current);
+            // Dead end, the arc leading here is not tried again
+            if (v == source)
+                break;
+            v = heads_[twins_[path.back()]];
+            path.pop_back();
+            ++current_[v];
         }
-        return std::vector<FlowVertexId>(result.rbegin(), result.rend());
-    }
-
-public:
-    BFS(const Graph &graph) :
-            graph_(graph) {
+        return result;
     }
 
-    std::vector<FlowVertexId> Go(FlowVertexId start, FlowVertexId finish) {
-        std::queue<FlowVertexId> q;
-        q.push(start);
-        std::map<FlowVertexId, FlowVertexId> prev;
-        prev[start] = start;
-        while (!q.empty()) {
-            FlowVertexId current = q.front();
-            q.pop();
-            auto outgoing = graph_.OutgoingEdges(current);
-            for (auto it = outgoing.begin(); it != outgoing.end(); ++it) {
-                if (prev.find(it->second) == prev.end()) {
-                    q.push(it->second);
-                    prev[it->second] = current;
-                }
-                if (it->second == finish) {
-                    return RestoreAnswer(start, finish, prev);
-                }
+    void PostOrder(FlowVertexId start, std::vector<bool> &visited, std::vector<FlowVertexId> &order) const {
+        std::vector<std::pair<FlowVertexId, ArcId>> stack = {{start, offsets_[start]}};
+        visited[start] = true;
+        while (!stack.empty()) {
+            FlowVertexId v = stack.back().first;
+            ArcId &a = stack.back().second;
+            while (a < offsets_[v + 1] && (residual_[a] <= 0 || visited[heads_[a]]))
+                ++a;
+            if (a == offsets_[v + 1]) {
+                order.push_back(v);
+                stack.pop_back();
+                continue;
             }
+            FlowVertexId next = heads_[a++];
+            visited[next] = true;
+            stack.emplace_back(next, offsets_[next]);
         }
-        return {};
     }
 };
 
 template<class Graph>
-class MaxFlowFinder {
+class FlowGraph {
+public:
+    typedef FlowNetwork::FlowVertexId FlowVertexId;
+
 private:
-    FlowGraph<Graph> &graph_;
-    typedef typename FlowGraph<Graph>::FlowVertexId FlowVertexId;
-    typedef typename FlowGraph<Graph>::FlowEdgeId FlowEdgeId;
-
-    int MinCapacity(const std::vector<FlowVertexId> &path) {
-        VERIFY(path.size() >= 2);
-        int result = graph_.GetCapacity(path[0], path[1]);
-        for (size_t i = 1; i + 1 < path.size(); i++) {
-            result = std::min(result, graph_.GetCapacity(path[i], path[i + 1]));
-        }
-        return result;
-    }
+    typedef typename Graph::VertexId OuterVertexId;
+    std::unordered_map<OuterVertexId, FlowVertexId> vertex_mapping_;
+    FlowNetwork network_;
+    FlowVertexId source_;
+    FlowVertexId sink_;
 
 public:
-    MaxFlowFinder(FlowGraph<Graph> &graph) :
-            graph_(graph) {
+    FlowGraph() :
+            source_(network_.AddVertex()), sink_(network_.AddVertex()) {
     }
 
-    void Find() {
-        BFS<FlowGraph<Graph> > bfs(graph_);
-        while (true) {
-            auto path = bfs.Go(graph_.Source(), graph_.Sink());
-            if (path.size() == 0)
-                break;
-            int capacity = MinCapacity(path);
-            VERIFY(capacity > 0);
-            graph_.PushFlow(path, capacity);
-//            graph_.Print();
-        }
+    FlowVertexId GetCorrespondingVertex(OuterVertexId v) const {
+        return vertex_mapping_.find(v)->second;
     }
-};
 
-template<class Graph>
-class TopSorter {
-private:
-    typedef typename Graph::FlowVertexId FlowVertexId;
-    typedef typename Graph::FlowEdgeId FlowEdgeId;
-    const Graph &graph_;
-
-    void Find(FlowVertexId v, std::vector<FlowVertexId> &result, std::set<FlowVertexId> &visited) {
-        visited.insert(v);
-        auto outgoing = graph_.OutgoingEdges(v);
-        for (auto it = outgoing.begin(); it != outgoing.end(); ++it) {
-            FlowVertexId next = graph_.EdgeEnd(*it);
-            if (visited.count(next) == 0) {
-                Find(next, result, visited);
-            }
-        }
-        result.push_back(v);
+    FlowVertexId AddVertex(OuterVertexId vertex) {
+        FlowVertexId new_vertex = network_.AddVertex();
+        vertex_mapping_[vertex] = new_vertex;
+        return new_vertex;
     }
 
-public:
-    TopSorter(const Graph &graph) :
-            graph_(graph) {
+    void AddEdge(OuterVertexId outer_first, OuterVertexId outer_second,
+            int capacity = 10000) {
+        VERIFY(vertex_mapping_.count(outer_first) && vertex_mapping_.count(outer_second));
+        network_.AddArc(GetCorrespondingVertex(outer_first), GetCorrespondingVertex(outer_second), capacity);
     }
 
-    std::vector<FlowVertexId> Sort() {
-        std::vector<FlowVertexId> result;
-        std::set<FlowVertexId> visited;
-        for (auto it = graph_.begin(); it != graph_.end(); ++it) {
-            if (visited.count(*it) == 0) {
-                Find(*it, result, visited);
-            }
-        }
-        return result;
+    void AddSource(OuterVertexId vertex, int capacity) {
+        network_.AddArc(source_, GetCorrespondingVertex(vertex), capacity);
     }
-};
 
-template<class Graph>
-class ReverseDFSComponentFinder {
-private:
-    typedef typename Graph::FlowVertexId FlowVertexId;
-    typedef typename Graph::FlowEdgeId FlowEdgeId;
-
-    const Graph &graph_;
-
-    void Find(FlowVertexId v, std::map<FlowVertexId, size_t> &result, size_t cc) {
-        result[v] = cc;
-        auto incoming = graph_.IncomingEdges(v);
-        for (auto it = incoming.begin(); it != incoming.end(); ++it) {
-            FlowVertexId next = graph_.EdgeStart(*it);
-            if (result.count(next) == 0) {
-                Find(next, result, cc);
-            }
-        }
+    void AddSink(OuterVertexId vertex, int capacity) {
+        network_.AddArc(GetCorrespondingVertex(vertex), sink_, capacity);
     }
-public:
-    ReverseDFSComponentFinder(const Graph &graph) :
-            graph_(graph) {
+
+    FlowVertexId Source() const {
+        return source_;
     }
 
-    std::map<FlowVertexId, size_t> Find(const std::vector<FlowVertexId> &order) {
-        size_t cc = 0;
-        std::map<FlowVertexId, size_t> result;
-        for (auto it = order.rbegin(); it != order.rend(); ++it) {
-            if (result.count(*it) == 0) {
-                Find(*it, result, cc);
-                cc++;
-            }
-        }
-        return result;
+    FlowVertexId Sink() const {
+        return sink_;
     }
-};
 
-template<class Graph>
-class StroglyConnectedComponentFinder {
-private:
-    typedef typename Graph::FlowVertexId FlowVertexId;
-    const Graph &graph_;
-    bool ready_;
-public:
-    StroglyConnectedComponentFinder(const Graph &graph) :
-            graph_(graph), ready_(false) {
+    // No edges can be added after the flow is found
+    int FindMaxFlow() {
+        network_.Build();
+        return network_.MaxFlow(source_, sink_);
     }
 
-    std::map<FlowVertexId, size_t> ColourComponents() {
-        std::map<FlowVertexId, size_t> result;
-        auto order = TopSorter<Graph>(graph_).Sort();
-        return ReverseDFSComponentFinder<Graph>(graph_).Find(order);
+    // All the edges from the source and to the sink are saturated
+    bool CompleteFlow() const {
+        return !network_.HasOutgoingResidual(source_) && !network_.HasIncomingResidual(sink_);
+    }
+
+    std::vector<size_t> ColourComponents() const {
+        return network_.ResidualComponents();
     }
 };
 
@@ -381,7 +339,7 @@ private:
     }
 
     std::set<EdgeId> CollectUnusedEdges(const std::set<VertexId> &component, const FlowGraph<Graph> &fg,
-                                        const std::map<typename FlowGraph<Graph>::FlowVertexId, size_t> &colouring) {
+                                        const std::vector<size_t> &colouring) {
         std::set<EdgeId> result;
         for (auto it_start = component.begin(); it_start != component.end();
                 ++it_start) {
@@ -392,9 +350,7 @@ private:
                 EdgeId edge = *it_edge;
                 VertexId end = g_.EdgeEnd(edge);
                 if (component.count(end) == 1 && IsSuspicious(edge)
-                        && colouring.find(fg.GetCorrespondingVertex(start))->second
-                                != colouring.find(
-                                        fg.GetCorrespondingVertex(end))->second) {
+                        && colouring[fg.GetCorrespondingVertex(start)] != colouring[fg.GetCorrespondingVertex(end)]) {
                     result.insert(edge);
                 }
             }
@@ -402,11 +358,6 @@ private:
         return result;
     }
 
-    bool CheckCompleteFlow(FlowGraph<Graph> &fg) {
-        return fg.OutgoingEdges(fg.Source()).size() == 0
-                && fg.IncomingEdges(fg.Sink()).size() == 0;
-    }
-
     bool IsPlausible(EdgeId edge) {
         return g_.length(edge) >= plausibility_length_ && !IsTip(edge);
     }
@@ -477,16 +428,12 @@ public:
             auto component = splitter_ptr->Next().vertices();
             FlowGraph<Graph> fg;
             ConstructFlowGraph(fg, component);
-//            fg.Print();
-            MaxFlowFinder<Graph> mf_finder(fg);
-            mf_finder.Find();
-            if (!CheckCompleteFlow(fg)) {
+            fg.FindMaxFlow();
+            if (!fg.CompleteFlow()) {
                 TRACE("Suspicious component! No edge delition!");
                 continue;
             }
-            StroglyConnectedComponentFinder<FlowGraph<Graph>> component_finder(
-                    fg);
-            auto colouring = component_finder.ColourComponents();
+            auto colouring = fg.ColourComponents();
             auto to_remove = CollectUnusedEdges(component, fg, colouring);
             component_remover_.DeleteComponent(to_remove.begin(), to_remove.end(), false);
         }
@@ -1,10 +1,153 @@
 #include "distance_estimation.hpp"
 
+#include <deque>
+
 namespace omnigraph {
 namespace de {
 
 using namespace debruijn_graph;
 
+// Puts the bits of src shifted by shift (and truncated to max_bit) into dst,
+// returns false if nothing remains
+static bool ShiftBits(const uint64_t *src, uint64_t *dst, size_t words, size_t shift, size_t max_bit) {
+    size_t word_shift = shift / 64, bit_shift = shift % 64;
+    size_t last_bits = max_bit % 64 + 1;
+    uint64_t last_mask = last_bits < 64 ? (uint64_t(1) << last_bits) - 1 : ~uint64_t(0);
+
+    bool any = false;
+    for (size_t i = 0; i < words; ++i) {
+        uint64_t w = 0;
+        if (i >= word_shift) {
+            w = src[i - word_shift] << bit_shift;
+            if (bit_shift && i > word_shift)
+                w |= src[i - word_shift - 1] >> (64 - bit_shift);
+        }
+        if (i + 1 == words)
+            w &= last_mask;
+        dst[i] = w;
+        any |= (w != 0);
+    }
+
+    return any;
+}
+
+std::unique_ptr<BoundedPathLengths> BoundedPathLengths::Compute(const Graph &graph,
+                                                                VertexId start, size_t max_len,
+                                                                size_t max_vertices) {
+    std::unique_ptr<BoundedPathLengths> res(new BoundedPathLengths(max_len));
+    const size_t row_size = res->row_size_;
+    auto &index = res->index_;
+    auto &bits = res->bits_;
+
+    // Semi-naive propagation: only the lengths obtained since the last visit
+    // of the vertex (delta) are pushed along its outgoing edges
+    std::vector<VertexId> vertices;
+    std::vector<uint64_t> delta;
+    std::vector<bool> queued;
+    std::deque<size_t> queue;
+
+    auto get_row = [&](VertexId v) {
+        auto it = index.find(v);
+        if (it != index.end())
+            return it->second;
+
+        size_t row = vertices.size();
+        index.emplace(v, row);
+        vertices.push_back(v);
+        queued.push_back(false);
+        bits.resize(bits.size() + row_size, 0);
+        delta.resize(delta.size() + row_size, 0);
+        return row;
+    };
+
+    get_row(start);
+    bits[0] = delta[0] = 1;
+    queue.push_back(0);
+    queued[0] = true;
+
+    std::vector<uint64_t> src(row_size), shifted(row_size);
+    while (!queue.empty()) {
+        size_t row = queue.front();
+        queue.pop_front();
+        queued[row] = false;
+
+        std::copy_n(delta.begin() + row * row_size, row_size, src.begin());
+        std::fill_n(delta.begin() + row * row_size, row_size, 0);
+
+        for (EdgeId e : graph.OutgoingEdges(vertices[row])) {
+            size_t len = graph.length(e);
+            if (len > max_len || !ShiftBits(src.data(), shifted.data(), row_size, len, max_len))
+                continue;
+
+            size_t dst = get_row(graph.EdgeEnd(e));
+            if (vertices.size() > max_vertices)
+                return nullptr;
+
+            bool changed = false;
+            for (size_t i = 0; i < row_size; ++i) {
+                uint64_t fresh = shifted[i] & ~bits[dst * row_size + i];
+                bits[dst * row_size + i] |= fresh;
+                delta[dst * row_size + i] |= fresh;
+                changed |= (fresh != 0);
+            }
+
+            if (changed && !queued[dst]) {
+                queued[dst] = true;
+                queue.push_back(dst);
+            }
+        }
+    }
+
+    return res;
+}
+
+void BoundedPathLengths::Lengths(VertexId v, size_t min_len, std::vector<size_t> &result) const {
+    auto it = index_.find(v);
+    if (it == index_.end())
+        return;
+
+    const uint64_t *row = bits_.data() + it->second * row_size_;
+    for (size_t len = min_len; len <= max_len_; ++len) {
+        if ((row[len / 64] >> (len % 64)) & 1)
+            result.push_back(len);
+    }
+}
+
+bool BoundedPathLengthsCache::Find(const Key &key, Value &value) const {
+    Shard &s = shard(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    auto it = s.map.find(key);
+    if (it == s.map.end())
+        return false;
+
+    value = it->second;
+    return true;
+}
+
+void BoundedPathLengthsCache::Insert(const Key &key, Value value) {
+    size_t words = value ? value->words() : 0;
+    Shard &s = shard(key);
+    std::lock_guard<std::mutex> lock(s.lock);
+    if (s.words + words > max_shard_words_) {
+        s.map.clear();
+        s.words = 0;
+    }
+
+    if (s.map.emplace(key, std::move(value)).second)
+        s.words += words;
+}
+
+std::shared_ptr<const BoundedPathLengths> GraphDistanceFinder::PathLengths(VertexId start, size_t max_len) const {
+    std::shared_ptr<const BoundedPathLengths> res;
+    if (cache_.Find({start, max_len}, res))
+        return res;
+
+    res = BoundedPathLengths::Compute(graph_, start, max_len,
+                                      PathProcessor<Graph>::MAX_DIJKSTRA_VERTICES);
+    cache_.Insert({start, max_len}, res);
+    return res;
+}
+
 std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, EdgeId e2) const {
     LengthMap m;
     m.insert({e2, {}});
@@ -15,7 +158,31 @@ std::vector<size_t> GraphDistanceFinder::GetGraphDistancesLengths(EdgeId e1, Edg
 }
 
 void GraphDistanceFinder::FillGraphDistancesLengths(EdgeId e1, LengthMap &second_edges) const {
-    std::vector<size_t> path_lower_bounds;
+    size_t path_upper_bound = PairInfoPathLengthUpperBound(graph_.k(), insert_size_, delta_);
+    auto path_lengths = PathLengths(graph_.EdgeEnd(e1), path_upper_bound);
+    if (!path_lengths) {
+        FillGraphDistancesLengthsByPaths(e1, second_edges);
+        return;
+    }
+
+    for (auto &entry : second_edges) {
+        EdgeId e2 = entry.first;
+        size_t path_lower_bound = PairInfoPathLengthLowerBound(graph_.k(), graph_.length(e1),
+                                                               graph_.length(e2), gap_, delta_);
+
+        GraphLengths lengths;
+        path_lengths->Lengths(graph_.EdgeStart(e2), path_lower_bound, lengths);
+        for (size_t &length : lengths)
+            length += graph_.length(e1);
+
+        if (e1 == e2)
+            lengths.insert(lengths.begin(), 0);
+
+        entry.second = std::move(lengths);
+    }
+}
+
+void GraphDistanceFinder::FillGraphDistancesLengthsByPaths(EdgeId e1, LengthMap &second_edges) const {
     size_t path_upper_bound = PairInfoPathLengthUpperBound(graph_.k(), insert_size_, delta_);
     PathProcessor <Graph> paths_proc(graph_, graph_.EdgeEnd(e1), path_upper_bound);
 
@@ -80,6 +247,11 @@ void DistanceEstimator::Estimate(PairedInfoIndexT<Graph> &result, size_t nthread
     for (auto it = this->graph().ConstEdgeBegin(); !it.IsEnd(); ++it)
         edges.push_back(*it);
 
+    // Edges sharing the end vertex reuse the same path lengths sweep, keep them together
+    std::stable_sort(edges.begin(), edges.end(), [&](EdgeId e1, EdgeId e2) {
+        return this->graph().EdgeEnd(e1) < this->graph().EdgeEnd(e2);
+    });
+
     DEBUG("Processing");
     PairedInfoBuffersT<Graph> buffer(this->graph(), nthreads);
 #   pragma omp parallel for num_threads(nthreads) schedule(guided, 10)
@@ -96,7 +268,6 @@ void DistanceEstimator::Estimate(PairedInfoIndexT<Graph> &result, size_t nthread
 
 DistanceEstimator::EstimHist DistanceEstimator::EstimateEdgePairDistances(EdgePair ep, const InHistogram &histogram,
                                                                           const GraphLengths &raw_forward) const {
-    using std::abs;
     using namespace math;
     EdgeId e1 = ep.first, e2 = ep.second;
     size_t first_len = this->graph().length(e1), second_len = this->graph().length(e2);
@@ -104,46 +275,31 @@ DistanceEstimator::EstimHist DistanceEstimator::EstimateEdgePairDistances(EdgePa
 
     TRACE("Bounds are " << minD << " " << maxD);
     EstimHist result;
-    std::vector<DEDistance> forward;
+    std::vector<float> forward;
     forward.reserve(raw_forward.size());
     for (auto raw_length : raw_forward) {
         int length = int(raw_length);
         if (minD - int(max_distance_) <= length && length <= maxD + int(max_distance_))
-            forward.push_back(DEDistance(length));
+            forward.push_back(float(length));
     }
     if (forward.size() == 0)
         return result;
 
-    size_t cur_dist = 0;
-    std::vector<DEWeight> weights(forward.size(), 0);
+    static thread_local PointColumns points;
+    static thread_local NearestDistanceKernel kernel;
+    points.clear();
     for (auto point : histogram) {
         if (ls(2 * point.d + DEDistance(second_len), DEDistance(first_len)))
             continue;
-        while (cur_dist + 1 < forward.size() && forward[cur_dist + 1] < point.d)
-            ++cur_dist;
-
-        if (cur_dist + 1 < forward.size() &&
-            ls(forward[cur_dist + 1] - point.d, point.d - forward[cur_dist])) {
-            ++cur_dist;
-
-            if (le(abs(forward[cur_dist] - point.d), max_distance_))
-                weights[cur_dist] += point.weight;
-        } else if (cur_dist + 1 < forward.size() &&
-                   eq(forward[cur_dist + 1] - point.d, point.d - forward[cur_dist])) {
-            if (le(abs(forward[cur_dist] - point.d), max_distance_))
-                weights[cur_dist] += point.weight * 0.5;
-            ++cur_dist;
-            if (le(abs(forward[cur_dist] - point.d), max_distance_))
-                weights[cur_dist] += point.weight * 0.5;
-        } else {
-            if (le(abs(forward[cur_dist] - point.d), max_distance_))
-                weights[cur_dist] += point.weight;
-        }
+        points.push_back(point);
     }
 
+    std::vector<double> weights;
+    kernel(points, forward, max_distance_, weights);
+
     for (size_t i = 0; i < forward.size(); ++i)
-        if (ge(weights[i], DEWeight(0)))
-            result.emplace_back(forward[i], weights[i]);
+        if (ge(weights[i], 0.))
+            result.emplace_back(int(forward[i]), weights[i]);
 
     VERIFY(result.size() == forward.size());
     return result;
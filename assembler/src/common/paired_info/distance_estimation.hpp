@@ -15,12 +15,86 @@
 
 #include "paired_info/pair_info_bounds.hpp"
 #include "paired_info.hpp"
+#include "distance_kernels.hpp"
 #include "math/xmath.h"
 
+#include <parallel_hashmap/phmap.h>
+
+#include <array>
+#include <memory>
+#include <mutex>
+
 namespace omnigraph {
 
 namespace de {
 
+// Lengths of all the paths not longer than max_len from the start vertex to
+// every vertex within the reach. Computed in a single sweep propagating
+// per-vertex length bitsets, so any number of targets could be queried.
+class BoundedPathLengths {
+    typedef debruijn_graph::VertexId VertexId;
+
+public:
+    // Returns nullptr if more than max_vertices vertices are within the reach
+    static std::unique_ptr<BoundedPathLengths> Compute(const debruijn_graph::Graph &graph,
+                                                       VertexId start, size_t max_len,
+                                                       size_t max_vertices);
+
+    // Appends sorted lengths of the paths to v that are in [min_len, max_len]
+    void Lengths(VertexId v, size_t min_len, std::vector<size_t> &result) const;
+
+    size_t vertex_count() const { return index_.size(); }
+    size_t words() const { return bits_.size(); }
+
+private:
+    BoundedPathLengths(size_t max_len)
+            : max_len_(max_len), row_size_(max_len / 64 + 1) {}
+
+    size_t max_len_;
+    size_t row_size_;
+    phmap::flat_hash_map<VertexId, size_t> index_;
+    std::vector<uint64_t> bits_;
+};
+
+// Read-mostly cache of BoundedPathLengths keyed by (start vertex, max length)
+// shared between the threads. Shards are dropped once the total amount of
+// stored words exceeds the budget.
+class BoundedPathLengthsCache {
+    typedef std::pair<debruijn_graph::VertexId, size_t> Key;
+    typedef std::shared_ptr<const BoundedPathLengths> Value;
+
+    struct KeyHash {
+        size_t operator()(const Key &key) const {
+            return phmap::HashState().combine(0, key.first.int_id(), key.second);
+        }
+    };
+
+    struct Shard {
+        std::mutex lock;
+        phmap::flat_hash_map<Key, Value, KeyHash> map;
+        size_t words = 0;
+    };
+
+    static constexpr size_t SHARD_COUNT = 64;
+
+public:
+    BoundedPathLengthsCache(size_t max_words)
+            : max_shard_words_(max_words / SHARD_COUNT + 1) {}
+
+    // Returns true if the key is known; value could be null, if the sweep was
+    // given up for this key
+    bool Find(const Key &key, Value &value) const;
+    void Insert(const Key &key, Value value);
+
+private:
+    Shard &shard(const Key &key) const {
+        return shards_[KeyHash()(key) % SHARD_COUNT];
+    }
+
+    size_t max_shard_words_;
+    mutable std::array<Shard, SHARD_COUNT> shards_;
+};
+
 //todo move to some more common place
 class GraphDistanceFinder {
     typedef std::vector<debruijn_graph::EdgeId> Path;
@@ -28,21 +102,31 @@ class GraphDistanceFinder {
     typedef std::map<debruijn_graph::EdgeId, GraphLengths> LengthMap;
 
 public:
-    GraphDistanceFinder(const debruijn_graph::Graph &graph, size_t insert_size, size_t read_length, size_t delta) :
+    GraphDistanceFinder(const debruijn_graph::Graph &graph, size_t insert_size, size_t read_length, size_t delta,
+                        size_t cache_words = DEFAULT_CACHE_WORDS) :
             graph_(graph), insert_size_(insert_size), gap_((int) (insert_size - 2 * read_length)),
-            delta_((double) delta) { }
+            delta_((double) delta), cache_(cache_words) { }
 
     std::vector<size_t> GetGraphDistancesLengths(debruijn_graph::EdgeId e1, debruijn_graph::EdgeId e2) const;
 
     // finds all distances from a current edge to a set of edges
     void FillGraphDistancesLengths(debruijn_graph::EdgeId e1, LengthMap &second_edges) const;
 
+    // 128 Mb of length bitsets
+    static const size_t DEFAULT_CACHE_WORDS = 16 * 1024 * 1024;
+
 private:
+    std::shared_ptr<const BoundedPathLengths> PathLengths(debruijn_graph::VertexId start, size_t max_len) const;
+
+    // per-target path processor traversals, used for the regions too large for the sweep
+    void FillGraphDistancesLengthsByPaths(debruijn_graph::EdgeId e1, LengthMap &second_edges) const;
+
     DECL_LOGGER("GraphDistanceFinder");
     const debruijn_graph::Graph &graph_;
     const size_t insert_size_;
     const int gap_;
     const double delta_;
+    mutable BoundedPathLengthsCache cache_;
 };
 
 class AbstractDistanceEstimator {
@@ -0,0 +1,181 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "index_point.hpp"
+#include "math/xmath.h"
+#include "utils/verify.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace omnigraph {
+
+namespace de {
+
+/**
+ * @brief Structure-of-arrays copy of histogram points used by the kernels below.
+ */
+struct PointColumns {
+    std::vector<float> d;
+    std::vector<float> weight;
+    std::vector<int> rounded;
+
+    void clear() {
+        d.clear();
+        weight.clear();
+        rounded.clear();
+    }
+
+    void push_back(const RawPoint &point) {
+        d.push_back(point.d);
+        weight.push_back(point.weight);
+        rounded.push_back(rounded_d(point));
+    }
+
+    size_t size() const { return d.size(); }
+};
+
+/**
+ * @brief Values of the weight function tabulated on [-radius, radius].
+ */
+class DistanceWeightTable {
+public:
+    DistanceWeightTable(const std::function<double(int)> &weight_f, int radius)
+            : radius_(radius), values_(2 * radius + 1) {
+        for (int i = -radius; i <= radius; ++i)
+            values_[i + radius] = weight_f(i);
+    }
+
+    int radius() const { return radius_; }
+    const double *center() const { return values_.data() + radius_; }
+
+private:
+    int radius_;
+    std::vector<double> values_;
+};
+
+/**
+ * @brief Distributes the weights of the points over the nearest graph distances.
+ *        Every point goes to the nearest distance or is split in halves between
+ *        two equally near ones; shares farther than max_distance are dropped.
+ *        Both points and distances must be sorted. The work is done in one
+ *        linear merge assigning the shares followed by the vectorized pass
+ *        computing the contributions and their accumulation.
+ * @param weight_table if not null, the share going to distance D from point d is
+ *        additionally multiplied by the tabulated weight function at D - round(d)
+ */
+class NearestDistanceKernel {
+public:
+    void operator()(const PointColumns &points,
+                    const std::vector<float> &distances,
+                    float max_distance,
+                    std::vector<double> &weights,
+                    const DistanceWeightTable *weight_table = nullptr) {
+        weights.assign(distances.size(), 0.);
+        size_t n = points.size();
+        if (n == 0 || distances.empty())
+            return;
+
+        Assign(points.d.data(), n, distances, max_distance);
+        Contribute(points, distances, weight_table);
+
+        const uint32_t *target = target_.data();
+        const double *c0 = contrib0_.data(), *c1 = contrib1_.data();
+        for (size_t j = 0; j < n; ++j) {
+            weights[target[j]] += c0[j];
+            if (c1[j] != 0.)
+                weights[target[j] + 1] += c1[j];
+        }
+    }
+
+private:
+    void Assign(const float *d, size_t n, const std::vector<float> &dists, float max_distance) {
+        using math::ls;
+        using math::le;
+        using math::eq;
+        target_.resize(n);
+        share0_.resize(n);
+        share1_.resize(n);
+
+        size_t m = dists.size(), cur = 0;
+        for (size_t j = 0; j < n; ++j) {
+            float p = d[j];
+            while (cur + 1 < m && dists[cur + 1] < p)
+                ++cur;
+
+            float s1 = 0;
+            if (cur + 1 < m && ls(dists[cur + 1] - p, p - dists[cur])) {
+                ++cur;
+                target_[j] = uint32_t(cur);
+                share0_[j] = le(std::abs(dists[cur] - p), max_distance) ? 1.f : 0.f;
+            } else if (cur + 1 < m && eq(dists[cur + 1] - p, p - dists[cur])) {
+                target_[j] = uint32_t(cur);
+                share0_[j] = le(std::abs(dists[cur] - p), max_distance) ? .5f : 0.f;
+                s1 = le(std::abs(dists[cur + 1] - p), max_distance) ? .5f : 0.f;
+                ++cur;
+            } else {
+                target_[j] = uint32_t(cur);
+                share0_[j] = le(std::abs(dists[cur] - p), max_distance) ? 1.f : 0.f;
+            }
+            share1_[j] = s1;
+        }
+    }
+
+    void Contribute(const PointColumns &points, const std::vector<float> &dists,
+                    const DistanceWeightTable *weight_table) {
+        size_t n = points.size();
+        contrib0_.resize(n);
+        contrib1_.resize(n);
+
+        const float *w = points.weight.data();
+        const float *s0 = share0_.data(), *s1 = share1_.data();
+        double *c0 = contrib0_.data(), *c1 = contrib1_.data();
+        if (!weight_table) {
+#           pragma omp simd
+            for (size_t j = 0; j < n; ++j) {
+                c0[j] = double(w[j]) * s0[j];
+                c1[j] = double(w[j]) * s1[j];
+            }
+            return;
+        }
+
+        // Offsets of the distances from the points, zero shares are kept within the table
+        const uint32_t *target = target_.data();
+        const int *rounded = points.rounded.data();
+        offset0_.resize(n);
+        offset1_.resize(n);
+        int radius = weight_table->radius();
+        for (size_t j = 0; j < n; ++j) {
+            int o0 = int(dists[target[j]]) - rounded[j];
+            int o1 = s1[j] != 0 ? int(dists[target[j] + 1]) - rounded[j] : 0;
+            VERIFY_DEV(s0[j] == 0 || std::abs(o0) <= radius);
+            VERIFY_DEV(std::abs(o1) <= radius);
+            offset0_[j] = s0[j] != 0 ? o0 : 0;
+            offset1_[j] = o1;
+        }
+
+        const double *f = weight_table->center();
+        const int *o0 = offset0_.data(), *o1 = offset1_.data();
+#       pragma omp simd
+        for (size_t j = 0; j < n; ++j) {
+            c0[j] = double(w[j]) * s0[j] * f[o0[j]];
+            c1[j] = double(w[j]) * s1[j] * f[o1[j]];
+        }
+    }
+
+    std::vector<uint32_t> target_;
+    std::vector<float> share0_, share1_;
+    std::vector<int> offset0_, offset1_;
+    std::vector<double> contrib0_, contrib1_;
+};
+
+}
+
+}
@@ -28,7 +28,8 @@ public:
                               const GraphDistanceFinder &distance_finder,
                               std::function<double(int)> weight_f,
                               size_t linkage_distance, size_t max_distance) :
-            base(graph, histogram, distance_finder, linkage_distance, max_distance), weight_f_(weight_f) { }
+            base(graph, histogram, distance_finder, linkage_distance, max_distance), weight_f_(weight_f),
+            weight_table_(weight_f, int(max_distance) + 2) { }
 
     virtual ~WeightedDistanceEstimator() { }
 
@@ -39,6 +40,8 @@ protected:
     typedef std::vector<size_t> GraphLengths;
 
     std::function<double(int)> weight_f_;
+    // weight_f_ on the offsets that are within max_distance
+    DistanceWeightTable weight_table_;
 
     virtual EstimHist EstimateEdgePairDistances(EdgePair ep,
                                                 const InHistogram &histogram,
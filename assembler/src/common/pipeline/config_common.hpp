@@ -9,6 +9,7 @@
 
 #include "utils/stl_utils.hpp"
 #include "utils/filesystem/path_helper.hpp"
+#include "utils/logger/logger.hpp"
 #include "utils/verify.hpp"
 #include <cppformat/format.h>
 
@@ -17,6 +18,7 @@
 #include <boost/property_tree/ptree.hpp>
 #include <boost/property_tree/info_parser.hpp>
 
+#include <algorithm>
 #include <string>
 #include <vector>
 #include <iostream>
@@ -104,6 +106,20 @@ void load(T &value, boost::property_tree::ptree const &pt, std::string const &ke
     load(value, pt, key, true);
 }
 
+template<typename mode_t>
+mode_t ModeByName(const std::string& name, const std::vector<std::string>& names) {
+    auto it = std::find(names.begin(), names.end(), name);
+    CHECK_FATAL_ERROR(it != names.end(), "Unrecognized mode name: " << name);
+    return mode_t(it - names.begin());
+}
+
+template<typename mode_t>
+std::string ModeName(const mode_t& mode, const std::vector<std::string>& names) {
+    auto mode_id = static_cast<size_t>(mode);
+    CHECK_FATAL_ERROR(mode_id < names.size(), "Unrecognized mode id: " << mode_id);
+    return names[mode_id];
+}
+
 template<class T>
 void load(T &value, boost::property_tree::ptree const &pt, const char *key) {
     load(value, pt, std::string(key), true);
@@ -558,6 +558,8 @@ void load(debruijn_config::time_tracing& tt,
   using config_common::load;
   load(tt.enable, pt, "time_tracer_enabled", true);
   load(tt.granularity, pt, "granularity", 500);
+  load(tt.per_thread, pt, "per_thread_events", false);
+  load(tt.per_thread_buffer, pt, "per_thread_buffer", false);
 }
 
 void load(debruijn_config::hmm_matching& hm,
@@ -734,6 +736,8 @@ void load_launch_info(debruijn_config &cfg, boost::property_tree::ptree const &p
 
     load(cfg.max_threads, pt, "max_threads");
     cfg.max_threads = spades_set_omp_threads(cfg.max_threads);
+    cfg.numa_policy = ModeByName<utils::NumaPolicy>(pt.get("numa_policy", "none"), utils::numa_policy_names());
+    cfg.pin_threads = pt.get("pin_threads", false);
 
     load(cfg.max_memory, pt, "max_memory");
 
@@ -7,12 +7,14 @@
 #pragma once
 
 #include "config_singl.hpp"
+#include "config_common.hpp"
 #include "library.hpp"
 #include "library_data.hpp"
 #include "utils/verify.hpp"
 #include "modules/path_extend/pe_config_struct.hpp"
 #include "configs/aligner_config.hpp"
 #include "common/utils/logger/logger.hpp"
+#include "utils/parallel/numa.hpp"
 
 #include <boost/optional.hpp>
 #include "math/xmath.h"
@@ -92,19 +94,8 @@ enum class Checkpoints : char {
 
 std::vector<std::string> SingleReadResolveModeNames();
 
-template<typename mode_t>
-mode_t ModeByName(const std::string& name, const std::vector<std::string>& names) {
-    auto it = std::find(names.begin(), names.end(), name);
-    CHECK_FATAL_ERROR(it != names.end(), "Unrecognized mode name: " << name);
-    return mode_t(it - names.begin());
-}
-
-template<typename mode_t>
-std::string ModeName(const mode_t& mode, const std::vector<std::string>& names) {
-    auto mode_id = static_cast<size_t>(mode);
-    CHECK_FATAL_ERROR(mode_id < names.size(), "Unrecognized mode id: " << mode_id);
-    return names[mode_id];
-}
+using config_common::ModeByName;
+using config_common::ModeName;
 
 struct dataset {
     typedef io::DataSet<LibraryData>::Library Library;
@@ -421,6 +412,9 @@ struct debruijn_config {
     struct time_tracing {
         bool enable;
         unsigned granularity;
+        // Optional, per-thread events are recorded on request only
+        bool per_thread = false;
+        size_t per_thread_buffer = 16384;
     };
     
     typedef std::map<info_printer_pos, info_printer> info_printers_t;
@@ -507,6 +501,8 @@ struct debruijn_config {
 
     unsigned max_threads;
     size_t max_memory;
+    utils::NumaPolicy numa_policy;
+    bool pin_threads;
 
     resolving_mode rm;
     path_extend::pe_config::MainPEParamsT pe_params;
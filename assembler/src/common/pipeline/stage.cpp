@@ -5,6 +5,7 @@
 //* See file LICENSE for details.
 //***************************************************************************
 
+#include "assembly_graph/dijkstra/dijkstra_storage_pool.hpp"
 #include "io/dataset_support/read_converter.hpp"
 #include "io/binary/graph_pack.hpp"
 
@@ -93,9 +94,17 @@ void CompositeStageBase::run(debruijn_graph::GraphPack& gp,
     VERIFY(parent_);
     init(gp, started_from);
     auto start_phase = phases_.begin();
-    if (started_from &&
-        strstr(started_from, ":") &&
-        started_from == strstr(started_from, id())) {
+    std::string last_phase = LastSavedPhase(started_from);
+    if (!last_phase.empty()) {
+        // Resuming right after the last saved phase
+        auto saved_phase = std::find_if(phases_.begin(), phases_.end(), PhaseIdComparator(last_phase.c_str()));
+        VERIFY_MSG(saved_phase != phases_.end(), "Unknown phase " << last_phase);
+        TIME_TRACE_SCOPE("load phase", last_phase);
+        (*saved_phase)->load(gp, parent_->saves_policy().LoadPath(), last_phase.c_str());
+        start_phase = std::next(saved_phase);
+    } else if (started_from &&
+               strstr(started_from, ":") &&
+               started_from == strstr(started_from, id())) {
         start_phase = std::find_if(phases_.begin(), phases_.end(), PhaseIdComparator(started_from));
         if (start_phase == phases_.end()) {
             ERROR("Invalid start stage / phase combination specified: " << started_from);
@@ -120,21 +129,43 @@ void CompositeStageBase::run(debruijn_graph::GraphPack& gp,
             phase->run(gp, started_from);
         }
 
-        if (parent_->saves_policy().EnabledCheckpoints() != SavesPolicy::Checkpoints::None) {
+        // The last phase is not saved on its own, the whole stage is saved right after it
+        if (parent_->saves_policy().EnabledCheckpoints() != SavesPolicy::Checkpoints::None &&
+            std::next(start_phase) != et) {
             std::string composite_id(id());
             composite_id += ":";
             composite_id += phase->id();
 
-            TIME_TRACE_SCOPE("save phase", composite_id);
-            phase->save(gp, parent_->saves_policy().SavesPath(), composite_id.c_str());
-            //TODO: currently no phases are writing saves.
-            //When they will, erase the previous saves when SavesPolicy::Last
+            const auto &saves_policy = parent_->saves_policy();
+            auto prev_saves = saves_policy.GetLastCheckpoint();
+            {
+                TIME_TRACE_SCOPE("save phase", composite_id);
+                phase->save(gp, saves_policy.SavesPath(), composite_id.c_str());
+            }
+            saves_policy.UpdateCheckpoint(composite_id.c_str());
+            // Saves of the previous stage are kept until the whole stage is saved
+            if (IsPhaseOf(prev_saves) && saves_policy.EnabledCheckpoints() == SavesPolicy::Checkpoints::Last)
+                fs::remove_if_exists(fs::append_path(saves_policy.SavesPath(), prev_saves));
         }
     }
 
     fini(gp);
 }
 
+bool CompositeStageBase::IsPhaseOf(const std::string &checkpoint) const {
+    std::string prefix(id());
+    prefix += ":";
+    return checkpoint.compare(0, prefix.size(), prefix) == 0;
+}
+
+std::string CompositeStageBase::LastSavedPhase(const char *started_from) const {
+    if (!started_from || strcmp(started_from, "last") != 0)
+        return "";
+
+    auto last_saves = parent_->saves_policy().GetLastCheckpoint();
+    return IsPhaseOf(last_saves) ? last_saves : "";
+}
+
 void AssemblyStage::prepare(debruijn_graph::GraphPack& g,
                             const char *stage, const char*) {
     g.PrepareForStage(stage);
@@ -153,7 +184,8 @@ void StageManager::run(debruijn_graph::GraphPack& g,
                     WARN("Nothing to continue");
                     return;
                 }
-                start_stage = std::next(last_stage);
+                // The stage was interrupted after one of its phases, it resumes from the next one
+                start_stage = (strstr(last_saves.c_str(), ":") ? last_stage : std::next(last_stage));
             } else {
                 WARN("No saved checkpoint");
             }
@@ -183,21 +215,33 @@ void StageManager::run(debruijn_graph::GraphPack& g,
         AssemblyStage *stage = start_stage->get();
 
         INFO("STAGE == " << stage->name() << " (id: " << stage->id() << ")");
+        auto prev_saves = saves_policy_.GetLastCheckpoint();
+        // Resuming after a phase of the stage, the saves of the previous stage were loaded
+        if (start_stage != stages_.begin() &&
+            prev_saves.compare(0, strlen(stage->id()) + 1, std::string(stage->id()) + ":") == 0)
+            prev_saves = std::prev(start_stage)->get()->id();
         stage->prepare(g, start_from);        
         {
             TIME_TRACE_SCOPE(stage->name());
             stage->run(g, start_from);
         }
+        utils::trace::flush(stage->id());
+        // Search storages are sized by the graph of the finished stage
+        omnigraph::ReleaseDijkstraStorages();
 
         if (saves_policy_.EnabledCheckpoints() != SavesPolicy::Checkpoints::None) {
-            auto prev_saves = saves_policy_.GetLastCheckpoint();
+            // The last phase of a composite stage, if it saved any
+            auto phase_saves = saves_policy_.GetLastCheckpoint();
             {
                 TIME_TRACE_SCOPE("save", saves_policy_.SavesPath());
                 stage->save(g, saves_policy_.SavesPath());
             }
             saves_policy_.UpdateCheckpoint(stage->id());
-            if (!prev_saves.empty() && saves_policy_.EnabledCheckpoints() == SavesPolicy::Checkpoints::Last) {
-                fs::remove_if_exists(fs::append_path(saves_policy_.SavesPath(), prev_saves));
+            if (saves_policy_.EnabledCheckpoints() == SavesPolicy::Checkpoints::Last) {
+                if (!prev_saves.empty())
+                    fs::remove_if_exists(fs::append_path(saves_policy_.SavesPath(), prev_saves));
+                if (!phase_saves.empty() && phase_saves != prev_saves)
+                    fs::remove_if_exists(fs::append_path(saves_policy_.SavesPath(), phase_saves));
             }
         }
     }
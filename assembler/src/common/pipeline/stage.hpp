@@ -86,6 +86,10 @@ public:
     void run(debruijn_graph::GraphPack &gp, const char * = nullptr);
 
 private:
+    bool IsPhaseOf(const std::string &checkpoint) const;
+    // The phase to resume after when restarting from the last checkpoint
+    std::string LastSavedPhase(const char *started_from) const;
+
     std::vector<std::unique_ptr<PhaseBase> > phases_;
 };
 
@@ -19,6 +19,8 @@
 #include "io/reads/coverage_filtering_read_wrapper.hpp"
 #include "io/reads/multifile_reader.hpp"
 
+#include "utils/filesystem/copy_file.hpp"
+#include "utils/filesystem/file_opener.hpp"
 #include "utils/filesystem/temporary.hpp"
 #include "utils/ph_map/coverage_hash_map_builder.hpp"
 
@@ -35,6 +37,8 @@ struct ConstructionStorage {
 
     std::unique_ptr<qf::cqf> cqf;
     std::unique_ptr<kmers::KMerDiskStorage<RtSeq>> kmers;
+    // The latest saved (or loaded) copy of the k-mers, see save_kmers
+    mutable std::string kmers_saves;
     std::unique_ptr<CoverageMap> coverage_map;
     config::debruijn_config::construction params;
     io::ReadStreamList<io::SingleReadSeq> read_streams;
@@ -69,26 +73,6 @@ void merge_read_streams(io::ReadStreamList<io::SingleReadSeq> &streams1,
     }
 }
 
-io::ReadStreamList<io::SingleReadSeq> temp_merge_read_streams(io::ReadStreamList<io::SingleReadSeq> &streams1,
-                                                              io::ReadStreamList<io::SingleReadSeq> &streams2) {
-    io::ReadStreamList<io::SingleReadSeq> merge_stream_list;
-
-    for (size_t i = 0; i < std::max(streams1.size(), streams2.size()); ++i) {
-        if (i < streams1.size() && i < streams2.size()) {
-            merge_stream_list.push_back(io::ScopedMultifileWrap<io::SingleReadSeq>(streams1[i], streams2[i]));
-        } else if (i < streams1.size()) {
-            merge_stream_list.push_back(io::ScopedMultifileWrap<io::SingleReadSeq>(streams1[i]));
-        } else {
-            merge_stream_list.push_back(io::ScopedMultifileWrap<io::SingleReadSeq>(streams2[i]));
-        }
-    }
-
-    return merge_stream_list;
-}
-
-
-
-
 void add_additional_contigs_to_lib(std::string path_to_additional_contigs_dir, size_t max_threads,
                                    io::ReadStreamList<io::SingleReadSeq> &trusted_list) {
     io::SequencingLibraryT seq_lib;
@@ -105,6 +89,46 @@ void add_additional_contigs_to_lib(std::string path_to_additional_contigs_dir, s
     merge_read_streams(trusted_list, lib_streams);
 }
 
+// Phases save only the parts of the storage required by the subsequent ones,
+// the graph pack is saved starting from the graph condensing
+static std::string make_phase_saves_dir(const std::string &save_to, const char *prefix) {
+    auto dir = fs::append_path(save_to, prefix);
+    INFO("Saving current state to " << dir);
+    fs::remove_if_exists(dir);
+    fs::make_dir(dir);
+    return dir;
+}
+
+template<class T>
+static void save_storage_part(const std::string &dir, const char *name, const T &part) {
+    auto filename = fs::append_path(dir, name);
+    std::ofstream os(filename, std::ios::binary);
+    part.BinWrite(os);
+    CHECK_FATAL_ERROR(os, "Failed to save " << filename);
+}
+
+template<class T, typename... Args>
+static void load_storage_part(const std::string &dir, const char *name, T &part, Args&&... args) {
+    auto is = fs::open_file(fs::append_path(dir, name), std::ios::binary);
+    part.BinRead(is, std::forward<Args>(args)...);
+}
+
+// K-mers do not change after counting, so the phases after it link the latest copy
+// (hard link, falling back to copying) instead of writing the k-mers once again
+static void save_kmers(const ConstructionStorage &storage, const std::string &dir) {
+    if (!storage.kmers_saves.empty() && fs::check_existence(storage.kmers_saves))
+        fs::link_files_by_prefix({ storage.kmers_saves }, dir);
+    else
+        save_storage_part(dir, "kmers", *storage.kmers);
+    storage.kmers_saves = fs::append_path(dir, "kmers");
+}
+
+static void load_kmers(ConstructionStorage &storage, const std::string &dir) {
+    storage.kmers.reset(new kmers::KMerDiskStorage<RtSeq>());
+    load_storage_part(dir, "kmers", *storage.kmers, storage.workdir);
+    storage.kmers_saves = fs::append_path(dir, "kmers");
+}
+
 void Construction::init(debruijn_graph::GraphPack &gp, const char *) {
     init_storage(unsigned(gp.k()));
 
@@ -196,22 +220,31 @@ class CoverageFilter: public Construction::Phase {
         INFO("Building k-mer coverage histogram");
         FillCoverageHistogram(*storage().cqf, kplusone, hasher, read_streams, rthr, KmerFilter());
 
-        // Replace input streams with wrapper ones
-        storage().read_streams = io::CovFilteringWrap(std::move(read_streams), kplusone, hasher, *storage().cqf, rthr);
+        WrapReadStreams();
     }
 
     void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+              const std::string &load_from,
+              const char *prefix) override {
+        storage().cqf.reset(new qf::cqf(1));
+        load_storage_part(fs::append_path(load_from, prefix), "cqf", *storage().cqf);
+        WrapReadStreams();
     }
 
     void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
+              const std::string &save_to,
+              const char *prefix) const override {
+        save_storage_part(make_phase_saves_dir(save_to, prefix), "cqf", *storage().cqf);
     }
 
+  private:
+    // Replace input streams with wrapper ones
+    void WrapReadStreams() {
+        unsigned kplusone = storage().ext_index.k() + 1;
+        rolling_hash::SymmetricCyclicHash<rolling_hash::NDNASeqHash> hasher(kplusone);
+        storage().read_streams = io::CovFilteringWrap(std::move(storage().read_streams), kplusone, hasher,
+                                                      *storage().cqf, storage().params.read_cov_threshold);
+    }
 };
 
 
@@ -232,37 +265,63 @@ public:
 
         VERIFY_MSG(read_streams.size(), "No input streams specified");
 
-
-        io::ReadStreamList<io::SingleReadSeq> merge_streams = temp_merge_read_streams(read_streams, contigs_streams);
-
-        unsigned nthreads = (unsigned)merge_streams.size();
+        unsigned nthreads = (unsigned)std::max(read_streams.size(), contigs_streams.size());
         using Splitter =  utils::DeBruijnReadKMerSplitter<io::SingleReadSeq,
                                                           utils::StoringTypeFilter<storing_type>>;
 
-        kmers::KMerDiskCounter<RtSeq>
-                counter(storage().workdir,
-                        Splitter(storage().workdir, index.k() + 1, merge_streams, buffer_size));
+        // The coverage is counted along with the k+1-mers, so the reads are scanned only once here
+        // and PHMCoverageFiller does not need them. Trusted contigs do not add to the coverage.
+        Splitter splitter(storage().workdir, index.k() + 1, read_streams, buffer_size);
+        splitter.set_count_multiplicities(true);
+        if (contigs_streams.size())
+            splitter.set_extra_streams(contigs_streams);
+
+        kmers::KMerDiskCounter<RtSeq> counter(storage().workdir, std::move(splitter));
         auto kmers = counter.Count(10 * nthreads, nthreads);
         storage().kmers.reset(new kmers::KMerDiskStorage<RtSeq>(std::move(kmers)));
+        storage().kmers_saves.clear();
     }
 
     void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+              const std::string &load_from,
+              const char *prefix) override {
+        load_kmers(storage(), fs::append_path(load_from, prefix));
     }
 
     void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
+              const std::string &save_to,
+              const char *prefix) const override {
+        save_kmers(storage(), make_phase_saves_dir(save_to, prefix));
+    }
+};
+
+// The k+1-mers are still needed for the coverage after the extension index is built
+class ExtensionIndexPhase : public Construction::Phase {
+public:
+    ExtensionIndexPhase(const char *name, const char *id)
+            : Construction::Phase(name, id) { }
+
+    void load(debruijn_graph::GraphPack&,
+              const std::string &load_from,
+              const char *prefix) override {
+        auto dir = fs::append_path(load_from, prefix);
+        load_kmers(storage(), dir);
+        load_storage_part(dir, "extension_index", storage().ext_index, storage().workdir);
+    }
+
+    void save(const debruijn_graph::GraphPack&,
+              const std::string &save_to,
+              const char *prefix) const override {
+        auto dir = make_phase_saves_dir(save_to, prefix);
+        save_kmers(storage(), dir);
+        save_storage_part(dir, "extension_index", storage().ext_index);
     }
 };
 
-class ExtensionIndexBuilder : public Construction::Phase {
+class ExtensionIndexBuilder : public ExtensionIndexPhase {
 public:
     ExtensionIndexBuilder()
-            : Construction::Phase("Extension index construction", "extension_index_construction") { }
+            : ExtensionIndexPhase("Extension index construction", "extension_index_construction") { }
 
     virtual ~ExtensionIndexBuilder() = default;
 
@@ -274,25 +333,13 @@ public:
                                                                               unsigned(storage().read_streams.size()),
                                                                               storage().params.read_buffer_size);
     }
-
-    void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
-    }
-
-    void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
-    }
 };
 
 
-class EarlyTipClipper : public Construction::Phase {
+class EarlyTipClipper : public ExtensionIndexPhase {
 public:
     EarlyTipClipper()
-            : Construction::Phase("Early tip clipping", "early_tip_clipper") { }
+            : ExtensionIndexPhase("Early tip clipping", "early_tip_clipper") { }
 
     virtual ~EarlyTipClipper() = default;
 
@@ -303,24 +350,12 @@ public:
         }
         EarlyTipClipperProcessor(storage().ext_index, *storage().params.early_tc.length_bound).ClipTips();
     }
-
-    void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
-    }
-
-    void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
-    }
 };
 
-class EarlyATClipper : public Construction::Phase {
+class EarlyATClipper : public ExtensionIndexPhase {
 public:
     EarlyATClipper()
-            : Construction::Phase("Early A/T remover", "early_at_remover") { }
+            : ExtensionIndexPhase("Early A/T remover", "early_at_remover") { }
 
     virtual ~EarlyATClipper() = default;
 
@@ -329,18 +364,6 @@ public:
         at_processor.RemoveATEdges();
         at_processor.RemoveATTips();
     }
-
-    void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
-    }
-
-    void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
-    }
 };
 
 class GraphCondenser : public Construction::Phase {
@@ -357,17 +380,18 @@ public:
         DeBruijnGraphExtentionConstructor<Graph>(gp.get_mutable<Graph>(), storage().ext_index).ConstructGraph(storage().params.keep_perfect_loops);
     }
 
-    void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
+    void load(debruijn_graph::GraphPack &gp,
+              const std::string &load_from,
+              const char *prefix) override {
+        Construction::Phase::load(gp, load_from, prefix);
+        load_kmers(storage(), fs::append_path(load_from, prefix));
     }
 
-    void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        //FIXME why commented here and others
-        // VERIFY_MSG(false, "implement me");
+    void save(const debruijn_graph::GraphPack &gp,
+              const std::string &save_to,
+              const char *prefix) const override {
+        Construction::Phase::save(gp, save_to, prefix);
+        save_kmers(storage(), fs::append_path(save_to, prefix));
     }
 };
 
@@ -408,9 +432,9 @@ public:
         storage().coverage_map.reset(new ConstructionStorage::CoverageMap(storage().kmers->k()));
         auto &coverage_map = *storage().coverage_map;
 
-        utils::CoverageHashMapBuilder().BuildIndex(coverage_map,
-                                                   *storage().kmers,
-                                                   storage().read_streams);
+        utils::CoverageHashMapBuilder().BuildIndexFromCounts(coverage_map,
+                                                             *storage().kmers,
+                                                             unsigned(storage().read_streams.size()));
         /*
         INFO("Checking the PHM");
 
@@ -449,19 +473,6 @@ public:
 
         gp.get_mutable<GenomicInfo>().set_cov_histogram(hist);
     }
-
-    void load(debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) override {
-        VERIFY_MSG(false, "implement me");
-    }
-
-    void save(const debruijn_graph::GraphPack&,
-              const std::string &,
-              const char*) const override {
-        // VERIFY_MSG(false, "implement me");
-    }
-
 };
 
 } // namespace
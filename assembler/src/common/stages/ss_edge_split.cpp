@@ -46,7 +46,8 @@ void SSEdgeSplit::run(GraphPack& gp, const char *) {
 
         INFO("Selecting usual mapper");
         auto mapper_ptr = MapperInstance(gp);
-        auto single_streams = io::single_binary_readers(reads, /*followed_by_rc*/ false, /*map_paired*/true);
+        auto single_streams = io::single_binary_readers(reads, /*followed_by_rc*/ false, /*map_paired*/true,
+                                                        SequenceMapperNotifier::STREAM_SPLIT_FACTOR);
         notifier.ProcessLibrary(single_streams, i, *mapper_ptr);
 
         auto &index = gp.get_mutable<EdgeIndex<Graph>>();
@@ -12,6 +12,8 @@
 #include <boost/tokenizer.hpp>
 #include <boost/algorithm/string.hpp>
 
+#include <algorithm>
+#include <fstream>
 #include <string>
 #include <vector>
 
@@ -155,6 +157,39 @@ void remove_if_exists(std::string const& path) {
     }
 }
 
+void write_to_stream(std::ostream &os, std::string const& path) {
+    uint64_t size = filesize(path);
+    os.write((const char *) &size, sizeof(size));
+
+    std::ifstream is(path, std::ios::binary);
+    CHECK_FATAL_ERROR(is, "Cannot open file " << path);
+    std::vector<char> buf(1 << 20);
+    for (uint64_t left = size; left > 0; ) {
+        size_t chunk = std::min<uint64_t>(left, buf.size());
+        is.read(buf.data(), chunk);
+        CHECK_FATAL_ERROR(is, "Cannot read file " << path);
+        os.write(buf.data(), chunk);
+        left -= chunk;
+    }
+}
+
+void read_from_stream(std::istream &is, std::string const& path) {
+    uint64_t size;
+    is.read((char *) &size, sizeof(size));
+
+    std::ofstream os(path, std::ios::binary);
+    CHECK_FATAL_ERROR(os, "Cannot open file " << path);
+    std::vector<char> buf(1 << 20);
+    for (uint64_t left = size; left > 0; ) {
+        size_t chunk = std::min<uint64_t>(left, buf.size());
+        is.read(buf.data(), chunk);
+        CHECK_FATAL_ERROR(is, "Cannot restore file " << path);
+        os.write(buf.data(), chunk);
+        left -= chunk;
+    }
+    CHECK_FATAL_ERROR(os, "Cannot write file " << path);
+}
+
 //TODO do we need to screen anything but whitespaces?
 std::string screen_whitespaces(std::string const &path) {
     std::string to_search = " ";
@@ -7,6 +7,7 @@
 
 #pragma once
 
+#include <iosfwd>
 #include <string>
 #include <vector>
 
@@ -43,6 +44,12 @@ bool check_existence(std::string const &path);
 
 void remove_if_exists(std::string const &path);
 
+// Writes the size and the contents of the file into the stream
+void write_to_stream(std::ostream &os, std::string const &path);
+
+// Restores the file written with write_to_stream
+void read_from_stream(std::istream &is, std::string const &path);
+
 std::string screen_whitespaces(std::string const &path);
 
 /**
@@ -123,8 +123,16 @@ class KMerDiskStorage {
     return res;
   }
 
+  // Multiplicities of the k-mers of the bucket, see KMerSortingSplitter::set_count_multiplicities()
+  fs::DependentTmpFile create_counts(size_t idx) {
+    fs::DependentTmpFile res = kmer_prefix_->CreateDep(std::to_string(idx) + ".cnt");
+    counts_.at(idx) = res;
+    return res;
+  }
+
   void resize(size_t n) {
     buckets_.resize(n);
+    counts_.resize(n);
   }
 
   unsigned k() const { return k_; }
@@ -163,8 +171,59 @@ class KMerDiskStorage {
   }
 
   size_t num_buckets() const { return buckets_.size(); }
+
+  bool has_counts() const {
+    return !counts_.empty() && std::all_of(counts_.begin(), counts_.end(),
+                                           [](const fs::DependentTmpFile &f) { return bool(f); });
+  }
+
+  // 32-bit multiplicity for every k-mer of the bucket, in the same order
+  MMappedRecordReader<uint32_t> bucket_counts(size_t i) const {
+    VERIFY_MSG(counts_.at(i), "k-mer multiplicities were not counted");
+    return MMappedRecordReader<uint32_t>(*counts_[i], /* unlink */ false, -1ULL);
+  }
   KMerSegmentPolicy segment_policy() const { return segment_policy_; }
 
+  // Bucket files (and multiplicities, if any) are written into the stream as is
+  template<class Writer>
+  void BinWrite(Writer &writer) const {
+    VERIFY_MSG(!all_kmers_, "Merged k-mers cannot be saved");
+    size_t num_segments = segment_policy_.num_segments(), num_buckets = buckets_.size();
+    bool counts = has_counts();
+    writer.write((char*)&k_, sizeof(k_));
+    writer.write((char*)&num_segments, sizeof(num_segments));
+    writer.write((char*)&num_buckets, sizeof(num_buckets));
+    writer.write((char*)&counts, sizeof(counts));
+    for (size_t i = 0; i < num_buckets; ++i) {
+      fs::write_to_stream(writer, *buckets_[i]);
+      if (counts)
+        fs::write_to_stream(writer, *counts_[i]);
+    }
+  }
+
+  template<class Reader>
+  void BinRead(Reader &reader, fs::TmpDir work_dir) {
+    size_t num_segments, num_buckets;
+    bool counts;
+    reader.read((char*)&k_, sizeof(k_));
+    reader.read((char*)&num_segments, sizeof(num_segments));
+    reader.read((char*)&num_buckets, sizeof(num_buckets));
+    reader.read((char*)&counts, sizeof(counts));
+
+    work_dir_ = work_dir;
+    kmer_prefix_ = work_dir_->tmp_file("kmers");
+    all_kmers_.reset();
+    segment_policy_.reset(num_segments);
+    buckets_.clear();
+    counts_.clear();
+    resize(num_buckets);
+    for (size_t i = 0; i < num_buckets; ++i) {
+      fs::read_from_stream(reader, *create(i));
+      if (counts)
+        fs::read_from_stream(reader, *create_counts(i));
+    }
+  }
+
   void merge() {
     INFO("Merging final buckets.");
     TIME_TRACE_SCOPE("KMerDiskStorage::MergeFinal");
@@ -177,6 +236,8 @@ class KMerDiskStorage {
       entry.reset();
     }
     buckets_.clear();
+    // Multiplicities are kept per bucket only
+    counts_.clear();
     ofs.close();
   }
 
@@ -187,6 +248,7 @@ class KMerDiskStorage {
   fs::TmpFile all_kmers_;
   unsigned k_;
   Buckets buckets_;
+  Buckets counts_;
   KMerSegmentPolicy segment_policy_;
 };
 
@@ -253,7 +315,10 @@ public:
         TIME_TRACE_SCOPE("KMerDiskCounter::Count");
 #       pragma omp parallel for shared(raw_kmers) num_threads(num_threads) schedule(dynamic) reduction(+:kmers)
         for (size_t i = 0; i < raw_kmers.size(); ++i) {
-          kmers += MergeKMers(*raw_kmers[i], *res.create(i));
+          if (fs::FileExists(raw_kmers[i]->file() + ".cnt"))
+            kmers += MergeCountedKMers(*raw_kmers[i], *res.create(i), *res.create_counts(i));
+          else
+            kmers += MergeKMers(*raw_kmers[i], *res.create(i));
           raw_kmers[i].reset();
         }
     }
@@ -363,6 +428,70 @@ private:
       return it - ins.begin();
     }
   }
+
+  // Same as MergeKMers, but the multiplicities of the equal k-mers of the runs are summed up
+  size_t MergeCountedKMers(const std::string &ifname, const std::string &ofname, const std::string &cnt_ofname) {
+    MMappedRecordArrayReader<typename Seq::DataType> ins(ifname, Seq::GetDataSize(this->k()), /* unlink */ true);
+    MMappedRecordReader<size_t> index(ifname + ".idx", /* unlink */ true, -1ULL);
+    MMappedRecordReader<uint32_t> counts(ifname + ".cnt", /* unlink */ true, -1ULL);
+    VERIFY(counts.size() == ins.size());
+
+    // Prepare runs, the positions of their top entries give the multiplicities
+    std::vector<adt::iterator_range<decltype(ins.begin())>> ranges;
+    std::vector<size_t> positions;
+    auto beg = ins.begin();
+    size_t start = 0;
+    for (size_t sz : index) {
+      auto end = std::next(beg, sz);
+      ranges.push_back(adt::make_range(beg, end));
+      positions.push_back(start);
+      beg = end;
+      start += sz;
+    }
+
+    adt::loser_tree<decltype(beg),
+            adt::array_less<typename Seq::DataType>> tree(ranges);
+
+    FILE *g = fopen(ofname.c_str(), "ab");
+    FILE *h = fopen(cnt_ofname.c_str(), "ab");
+    if (!g || !h)
+      FATAL_ERROR("Cannot open temporary file " << ofname << " for writing");
+
+    adt::KMerVector<Seq> buf(this->k(), 1024*1024);
+    std::vector<uint32_t> buf_counts;
+    size_t total = 0;
+    auto flush = [&]() {
+      size_t res = fwrite(buf.data(), buf.el_data_size(), buf.size(), g);
+      if (res != buf.size())
+        FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+      res = fwrite(buf_counts.data(), sizeof(uint32_t), buf_counts.size(), h);
+      if (res != buf_counts.size())
+        FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+      total += buf.size();
+      buf.clear();
+      buf_counts.clear();
+    };
+
+    while (!tree.empty()) {
+      uint64_t cnt = counts[positions[tree.top_run()]++];
+      if (buf.size() && adt::array_equal_to<typename Seq::DataType>()(buf.back(), tree.top())) {
+        cnt += buf_counts.back();
+        buf_counts.back() = uint32_t(std::min<uint64_t>(cnt, std::numeric_limits<uint32_t>::max()));
+      } else {
+        if (buf.size() == buf.capacity())
+          flush();
+        buf.push_back(tree.top());
+        buf_counts.push_back(uint32_t(cnt));
+      }
+      tree.replay();
+    }
+    flush();
+
+    fclose(g);
+    fclose(h);
+
+    return total;
+  }
 };
 
 template<class Index>
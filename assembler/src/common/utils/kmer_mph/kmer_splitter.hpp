@@ -15,8 +15,10 @@
 #include "utils/logger/logger.hpp"
 
 #include <libcxx/sort.hpp>
+#include <limits>
 #include <string>
 #include <cstdio>
+#include <vector>
 
 namespace kmers {
 
@@ -57,10 +59,16 @@ public:
     using typename KMerSplitter<Seq>::RawKMers;
 
     KMerSortingSplitter(const std::string &work_dir, unsigned K)
-            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0) {}
+            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0), count_multiplicities_(false) {}
 
     KMerSortingSplitter(fs::TmpDir work_dir, unsigned K)
-            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0) {}
+            : KMerSplitter<Seq>(work_dir, K), cell_size_(0), num_files_(0), count_multiplicities_(false) {}
+
+    // Besides the k-mers, every run gets a ".cnt" file with the numbers of their instances
+    // (as 32-bit saturating counters), so KMerDiskCounter could count the multiplicities
+    void set_count_multiplicities(bool count) {
+        count_multiplicities_ = count;
+    }
 
 protected:
     using SeqKMerVector = adt::KMerVector<Seq>;
@@ -69,6 +77,7 @@ protected:
     std::vector<KMerBuffer> kmer_buffers_;
     size_t cell_size_;
     size_t num_files_;
+    bool count_multiplicities_;
 
     RawKMers PrepareBuffers(size_t num_files, unsigned nthreads, size_t reads_buffer_size) {
         num_files_ = num_files;
@@ -117,7 +126,8 @@ protected:
         return entry[idx].size() > cell_size_;
     }
 
-    void DumpBuffers(const RawKMers &ostreams) {
+    // weight: the multiplicity of every k-mer instance, 0 for the k-mers which should not be counted
+    void DumpBuffers(const RawKMers &ostreams, uint32_t weight = 1) {
         VERIFY(ostreams.size() == num_files_ && kmer_buffers_[0].size() == num_files_);
 
 #   pragma omp parallel for
@@ -135,7 +145,10 @@ protected:
                     SortBuffer.push_back(buffer[j]);
             }
             libcxx::sort(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::less2_fast());
-            auto it = std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
+            std::vector<uint32_t> counts;
+            auto it = count_multiplicities_ ?
+                      UniqueCount(SortBuffer.begin(), SortBuffer.end(), weight, counts) :
+                      std::unique(SortBuffer.begin(), SortBuffer.end(), typename adt::KMerVector<Seq>::equal_to());
 
 #     pragma omp critical
             {
@@ -158,6 +171,17 @@ protected:
                 if (res != 1)
                     FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
                 fclose(f);
+
+                // Write multiplicities
+                if (count_multiplicities_) {
+                    f = fopen((ostreams[k]->file() + ".cnt").c_str(), "ab");
+                    if (!f)
+                        FATAL_ERROR("Cannot open temporary file " << ostreams[k]->file() << " for writing");
+                    res = fwrite(counts.data(), sizeof(uint32_t), cnt, f);
+                    if (res != cnt)
+                        FATAL_ERROR("I/O error! Incomplete write! Reason: " << strerror(errno) << ". Error code: " << errno);
+                    fclose(f);
+                }
             }
         }
 
@@ -166,6 +190,26 @@ protected:
                 eentry.clear();
     }
 
+    // std::unique, which also collects the multiplicities of the remaining k-mers
+    template<class It>
+    static It UniqueCount(It first, It last, uint32_t weight, std::vector<uint32_t> &counts) {
+        typename adt::KMerVector<Seq>::equal_to equal;
+        counts.clear();
+        It res = first;
+        while (first != last) {
+            uint64_t cnt = 0;
+            It next = first;
+            for (; next != last && equal(*first, *next); ++next)
+                cnt += weight;
+            if (res != first)
+                *res = *first;
+            ++res;
+            counts.push_back(uint32_t(std::min<uint64_t>(cnt, std::numeric_limits<uint32_t>::max())));
+            first = next;
+        }
+        return res;
+    }
+
     void ClearBuffers() {
         for (auto & entry : kmer_buffers_)
             for (auto & eentry : entry) {
@@ -10,6 +10,7 @@
 #include "kmer_splitter.hpp"
 #include "io/reads/io_helper.hpp"
 #include "adt/iterator_range.hpp"
+#include "utils/perf/timetracer.hpp"
 
 namespace utils {
 
@@ -26,6 +27,7 @@ class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
                               unsigned thread_id) {
       if (seq.size() < this->K_)
         return false;
+      TIME_TRACE_COUNTER(KMersProcessed, seq.size() - this->K_ + 1);
 
       RtSeq kmer = seq.start<RtSeq>(this->K_) >> 'A';
       bool stop = false;
@@ -44,6 +46,7 @@ class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
                                 unsigned thread_id) {
       if (seq.size() < this->K_)
         return false;
+      TIME_TRACE_COUNTER(KMersProcessed, seq.size() - this->K_ + 1);
 
       RtSeq kmer = seq.start(this->K_) >> 'A';
       bool stop = false;
@@ -70,11 +73,15 @@ class DeBruijnKMerSplitter : public RtSeqKMerSplitter {
 template<class Read, class KmerFilter>
 class DeBruijnReadKMerSplitter : public DeBruijnKMerSplitter<KmerFilter> {
   io::ReadStreamList<Read>& streams_;
+  io::ReadStreamList<Read>* extra_streams_;
 
   template<class ReadStream>
   size_t
   FillBufferFromStream(ReadStream& stream, unsigned thread_id);
 
+  size_t SplitStreams(io::ReadStreamList<Read> &streams, const typename DeBruijnKMerSplitter<KmerFilter>::RawKMers &out,
+                      unsigned nthreads, uint32_t weight);
+
  public:
   using typename DeBruijnKMerSplitter<KmerFilter>::RawKMers;
   DeBruijnReadKMerSplitter(fs::TmpDir work_dir,
@@ -83,7 +90,13 @@ class DeBruijnReadKMerSplitter : public DeBruijnKMerSplitter<KmerFilter> {
                            size_t read_buffer_size = 0,
                            KmerFilter filter = KmerFilter())
       : DeBruijnKMerSplitter<KmerFilter>(work_dir, K, filter, read_buffer_size),
-      streams_(streams) {}
+      streams_(streams), extra_streams_(nullptr) {}
+
+  // K-mers of the extra streams (e.g. trusted contigs) are split after the reads.
+  // When the multiplicities are counted, they are added with zero multiplicity.
+  void set_extra_streams(io::ReadStreamList<Read> &streams) {
+    extra_streams_ = &streams;
+  }
 
   RawKMers Split(size_t num_files, unsigned nthreads) override;
 };
@@ -92,6 +105,7 @@ template<class Read, class KmerFilter> template<class ReadStream>
 size_t
 DeBruijnReadKMerSplitter< Read, KmerFilter>::FillBufferFromStream(ReadStream &stream,
                                                                   unsigned thread_id) {
+  TIME_TRACE_THREAD_SCOPE("DeBruijnReadKMerSplitter::FillBufferFromStream");
   typename ReadStream::ReadT r;
   size_t reads = 0;
 
@@ -107,19 +121,18 @@ DeBruijnReadKMerSplitter< Read, KmerFilter>::FillBufferFromStream(ReadStream &st
 }
 
 template<class Read, class KmerFilter>
-typename DeBruijnReadKMerSplitter<Read, KmerFilter>::RawKMers
-DeBruijnReadKMerSplitter<Read, KmerFilter>::Split(size_t num_files, unsigned nthreads) {
-  auto out = this->PrepareBuffers(num_files, nthreads, this->read_buffer_size_);
-
+size_t DeBruijnReadKMerSplitter<Read, KmerFilter>::SplitStreams(io::ReadStreamList<Read> &streams,
+                                                                const RawKMers &out,
+                                                                unsigned nthreads, uint32_t weight) {
   size_t counter = 0, n = 15;
-  streams_.reset();
-  while (!streams_.eof()) {
+  streams.reset();
+  while (!streams.eof()) {
 #   pragma omp parallel for num_threads(nthreads) reduction(+ : counter)
-    for (unsigned i = 0; i < (unsigned)streams_.size(); ++i) {
-      counter += FillBufferFromStream(streams_[i], omp_get_thread_num());
+    for (unsigned i = 0; i < (unsigned)streams.size(); ++i) {
+      counter += FillBufferFromStream(streams[i], omp_get_thread_num());
     }
 
-    this->DumpBuffers(out);
+    this->DumpBuffers(out, weight);
 
     if (counter >> n) {
       INFO("Processed " << counter << " reads");
@@ -127,6 +140,18 @@ DeBruijnReadKMerSplitter<Read, KmerFilter>::Split(size_t num_files, unsigned nth
     }
   }
 
+  return counter;
+}
+
+template<class Read, class KmerFilter>
+typename DeBruijnReadKMerSplitter<Read, KmerFilter>::RawKMers
+DeBruijnReadKMerSplitter<Read, KmerFilter>::Split(size_t num_files, unsigned nthreads) {
+  auto out = this->PrepareBuffers(num_files, nthreads, this->read_buffer_size_);
+
+  size_t counter = SplitStreams(streams_, out, nthreads, 1);
+  if (extra_streams_)
+    counter += SplitStreams(*extra_streams_, out, nthreads, 0);
+
   this->ClearBuffers();
   INFO("Used " << counter << " reads");
   return out;
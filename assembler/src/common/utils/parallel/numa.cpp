@@ -0,0 +1,218 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "numa.hpp"
+
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/logger/logger.hpp"
+
+#ifdef __linux__
+# include <sched.h>
+# include <sys/syscall.h>
+#endif
+#include <unistd.h>
+
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+namespace {
+
+// Arrays smaller than this are left alone, placing them costs more than it saves
+const size_t MIN_PLACED_SIZE = 64 << 20;
+
+std::atomic<NumaPolicy> current_policy(NumaPolicy::None);
+std::atomic<bool> threads_pinned(false);
+
+// Online nodes as a bit mask, in the format of mbind(2)
+std::vector<unsigned long> OnlineNodes() {
+    std::vector<unsigned long> mask;
+    std::ifstream is("/sys/devices/system/node/online");
+    std::string ranges;
+    if (!(is >> ranges))
+        return mask;
+
+    // The list looks like "0-1,3"
+    std::stringstream ss(ranges);
+    std::string range;
+    while (std::getline(ss, range, ',')) {
+        size_t dash = range.find('-');
+        size_t first = std::stoul(range.substr(0, dash));
+        size_t last = (dash == std::string::npos ? first : std::stoul(range.substr(dash + 1)));
+        for (size_t node = first; node <= last; ++node) {
+            size_t word = node / (sizeof(unsigned long) * CHAR_BIT);
+            if (mask.size() <= word)
+                mask.resize(word + 1, 0);
+            mask[word] |= 1UL << (node % (sizeof(unsigned long) * CHAR_BIT));
+        }
+    }
+
+    return mask;
+}
+
+const std::vector<unsigned long> &NodeMask() {
+    static const std::vector<unsigned long> mask = OnlineNodes();
+    return mask;
+}
+
+#ifdef __linux__
+// The constants of <numaif.h>, the syscall is used directly to avoid the dependency on libnuma
+enum : int { MPOL_PREFERRED_ = 1, MPOL_INTERLEAVE_ = 3 };
+enum : unsigned { MPOL_MF_MOVE_ = 1 << 1 };
+
+bool Bind(void *data, size_t size, int mode, const std::vector<unsigned long> &mask) {
+    // The pages could be allocated already (the allocator recycles memory, the values are constructed
+    // before the placement), MPOL_MF_MOVE migrates the ones not matching the policy
+    long res = syscall(SYS_mbind, data, size, mode, mask.data(),
+                       mask.size() * sizeof(unsigned long) * CHAR_BIT + 1, MPOL_MF_MOVE_);
+    if (res == 0)
+        return true;
+
+    // Most likely mbind(2) is not permitted, e.g. in a container
+    WARN("NUMA memory placement failed: " << strerror(errno) << ", disabling it");
+    current_policy = NumaPolicy::None;
+    return false;
+}
+
+// Node of the CPU the calling thread runs on, only meaningful for a pinned thread
+bool CurrentNode(unsigned &node) {
+    unsigned cpu;
+    return syscall(SYS_getcpu, &cpu, &node, nullptr) == 0;
+}
+#endif
+
+}
+
+std::vector<std::string> numa_policy_names() {
+    return { "none", "interleave", "partition" };
+}
+
+void set_numa_policy(NumaPolicy policy) {
+    if (policy != NumaPolicy::None && numa_nodes() < 2) {
+        INFO("Single NUMA node, memory placement policy is not used");
+        policy = NumaPolicy::None;
+    }
+    if (policy == NumaPolicy::Partition && !threads_pinned) {
+        WARN("NUMA partition policy requires pinned threads, using interleave policy instead");
+        policy = NumaPolicy::Interleave;
+    }
+    current_policy = policy;
+}
+
+NumaPolicy numa_policy() {
+    return current_policy;
+}
+
+size_t numa_nodes() {
+    size_t res = 0;
+    for (unsigned long word : NodeMask())
+        res += __builtin_popcountl(word);
+    return res ? res : 1;
+}
+
+void numa_place(void *data, size_t size, unsigned nthreads) {
+#ifdef __linux__
+    NumaPolicy policy = current_policy;
+    if (policy == NumaPolicy::None || size < MIN_PLACED_SIZE)
+        return;
+
+    // Only whole pages can be placed
+    uintptr_t page = (uintptr_t) getpagesize();
+    uintptr_t begin = ((uintptr_t) data + page - 1) / page * page;
+    uintptr_t end = ((uintptr_t) data + size) / page * page;
+    size_t pages = (end - begin) / page;
+
+    if (policy == NumaPolicy::Interleave) {
+        Bind((void *) begin, pages * page, MPOL_INTERLEAVE_, NodeMask());
+        return;
+    }
+
+    // Every thread moves its chunk to its own node. The master thread is not pinned by
+    // pin_omp_threads(), so it is pinned to its current CPU until its chunk is moved.
+#   pragma omp parallel num_threads(nthreads)
+    {
+        size_t tid = omp_get_thread_num(), total = omp_get_num_threads();
+        size_t first = pages * tid / total, last = pages * (tid + 1) / total;
+
+        cpu_set_t saved;
+        bool repin = (tid == 0 && sched_getaffinity(0, sizeof(saved), &saved) == 0);
+        if (repin) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(sched_getcpu(), &set);
+            repin = (sched_setaffinity(0, sizeof(set), &set) == 0);
+        }
+
+        unsigned node;
+        if ((tid != 0 || repin) && CurrentNode(node)) {
+            std::vector<unsigned long> mask(node / (sizeof(unsigned long) * CHAR_BIT) + 1, 0);
+            mask.back() = 1UL << (node % (sizeof(unsigned long) * CHAR_BIT));
+            if (first < last)
+                Bind((void *) (begin + first * page), (last - first) * page, MPOL_PREFERRED_, mask);
+        }
+
+        if (repin)
+            sched_setaffinity(0, sizeof(saved), &saved);
+    }
+#else
+    (void) data;
+    (void) size;
+    (void) nthreads;
+#endif
+}
+
+void pin_omp_threads(unsigned nthreads) {
+#ifdef __linux__
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+    if (sched_getaffinity(0, sizeof(allowed), &allowed) != 0) {
+        WARN("Cannot get CPU affinity: " << strerror(errno) << ", threads are not pinned");
+        return;
+    }
+
+    std::vector<int> cpus;
+    for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+        if (CPU_ISSET(cpu, &allowed))
+            cpus.push_back(cpu);
+    }
+    if (cpus.size() < nthreads)
+        WARN("Only " << cpus.size() << " CPUs are available for " << nthreads << " threads");
+
+    std::atomic<size_t> pinned(0);
+    size_t team = 1;
+#   pragma omp parallel num_threads(nthreads)
+    {
+#       pragma omp master
+        team = omp_get_num_threads();
+
+        // The master thread keeps its mask, otherwise every thread spawned by it later would
+        // be restricted to its single CPU
+        if (omp_get_thread_num() != 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[omp_get_thread_num() % cpus.size()], &set);
+            // pid 0 stands for the calling thread here
+            if (sched_setaffinity(0, sizeof(set), &set) == 0)
+                pinned += 1;
+        }
+    }
+    threads_pinned = (pinned + 1 == team);
+    INFO("Pinned " << pinned << " of " << team << " threads to CPUs, the master thread is not pinned");
+#else
+    (void) nthreads;
+    INFO("Thread pinning is not supported on this platform");
+#endif
+}
+
+}
@@ -0,0 +1,51 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+namespace utils {
+
+/*
+ * Placement of large arrays on NUMA machines. Without a policy the pages of an array go to the
+ * node of the thread touching them first, which is usually the single thread filling it with
+ * zeros right after the allocation. The arrays are then accessed by the threads of all nodes.
+ */
+enum class NumaPolicy {
+    // Leave the placement to the kernel
+    None,
+    // Spread the pages over all nodes round-robin, suits random access (e.g. via hash)
+    Interleave,
+    // Place every chunk of the static OpenMP schedule on the node of the thread processing it
+    Partition
+};
+
+// Names of the policies in the configs, in the order of NumaPolicy
+std::vector<std::string> numa_policy_names();
+
+// Partition requires the threads to be pinned by pin_omp_threads() beforehand,
+// otherwise Interleave is used instead
+void set_numa_policy(NumaPolicy policy);
+NumaPolicy numa_policy();
+
+// Number of nodes available, 1 when the topology is unknown
+size_t numa_nodes();
+
+// Places the pages of an array according to the current policy, moving the ones allocated already:
+// Interleave spreads them over all nodes, Partition moves every chunk to the node of the thread
+// processing it when nthreads threads share the array statically. Does nothing on single node
+// machines and for small arrays.
+void numa_place(void *data, size_t size, unsigned nthreads);
+
+// Pins every thread of the OpenMP team but the master one to its own CPU of the ones available
+// to the process, so that the threads (and the pages placed by them) do not migrate between
+// nodes. The master thread is left unpinned: the threads it spawns later inherit its CPU mask.
+void pin_omp_threads(unsigned nthreads);
+
+}
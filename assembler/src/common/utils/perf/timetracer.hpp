@@ -7,20 +7,23 @@
 #pragma once
 
 #if 1
+#include "trace_events.hpp"
+
 #include <llvm/Support/TimeProfiler.h>
 
 namespace {
 struct time_trace_scope {
     time_trace_scope()
-            : trace(__PRETTY_FUNCTION__) {}
+            : time_trace_scope(__PRETTY_FUNCTION__) {}
 
     time_trace_scope(llvm::StringRef comment)
-            : trace(comment) {}
+            : trace(comment), thread_trace(comment.data(), comment.size()) {}
 
     time_trace_scope(llvm::StringRef comment, llvm::StringRef detail)
-            : trace(comment, detail) {}
+            : trace(comment, detail), thread_trace(comment.data(), comment.size()) {}
 
     llvm::TimeTraceScope trace;
+    utils::trace::scope thread_trace;
 };
 };
 
@@ -35,14 +38,24 @@ struct time_trace_scope {
 #define TIME_TRACE_SCOPE(...)  TIME_TRACE_SCOPE_IMPL(__LINE__, ##__VA_ARGS__)
 #define TIME_TRACE_BEGIN(comment) do {                              \
         llvm::timeTraceProfilerBegin(comment, llvm::StringRef("")); \
+        utils::trace::begin(comment);                               \
     } while(0);
 #define TIME_TRACE_END do {                                         \
         llvm::timeTraceProfilerEnd();                               \
+        utils::trace::end();                                        \
     } while(0);
-    
+
+// Scopes of the worker threads, e.g. of the chunks of a parallel loop. They are recorded
+// by the per-thread tracer only and do not clutter the time trace of the main thread.
+#define TIME_TRACE_THREAD_SCOPE_IMPL(suf, comment)  utils::trace::scope thread_trace ## suf(comment)
+#define TIME_TRACE_THREAD_SCOPE(comment)  TIME_TRACE_THREAD_SCOPE_IMPL(__LINE__, comment)
+#define TIME_TRACE_COUNTER(counter, value)  utils::trace::add(utils::trace::Counter::counter, value)
+
 #else
 #define TIME_TRACE_SCOPE
 #define TIME_TRACE_BEGIN
 #define TIME_TRACE_END
+#define TIME_TRACE_THREAD_SCOPE(comment)
+#define TIME_TRACE_COUNTER(counter, value)
 #endif
 
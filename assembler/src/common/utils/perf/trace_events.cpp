@@ -0,0 +1,386 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "trace_events.hpp"
+
+#include "utils/logger/logger.hpp"
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+namespace utils {
+namespace trace {
+
+namespace {
+
+const size_t MAX_NAME = 63;
+const size_t MAX_NAMES = 4096;
+const size_t MAX_DEPTH = 64;
+// Threads beyond that many alive at the same time are not recorded
+const size_t MAX_BUFFERS = 256;
+const size_t COUNTERS = size_t(Counter::Total);
+const char *const COUNTER_NAMES[COUNTERS] = { "bytes read", "k-mers processed", "reads mapped" };
+
+typedef std::chrono::steady_clock clock_type;
+
+// Scope names are interned, scopes refer to them by index
+struct Span {
+    uint64_t ts, dur;
+    uint32_t name;
+};
+
+struct Sample {
+    uint64_t ts, value;
+    uint32_t counter;
+};
+
+struct Open {
+    uint64_t start;
+    uint32_t name;
+};
+
+// Names of all the scopes recorded, the ones beyond MAX_NAMES share the first entry
+std::mutex names_lock;
+std::vector<std::string> names;
+std::unordered_map<std::string, uint32_t> name_ids;
+
+uint32_t Intern(const std::string &name) {
+    std::lock_guard<std::mutex> lock(names_lock);
+    auto it = name_ids.find(name);
+    if (it != name_ids.end())
+        return it->second;
+    if (names.size() >= MAX_NAMES)
+        return 0;
+
+    uint32_t id = uint32_t(names.size());
+    names.push_back(name);
+    name_ids.emplace(name, id);
+    return id;
+}
+
+// Ring buffer written by the owner thread only. The exporter reads the records up to head_
+// and skips the ones that could have been overwritten while it was reading them.
+template<class Record>
+class Ring {
+public:
+    explicit Ring(size_t capacity)
+            : records_(capacity), head_(0), exported_(0) {}
+
+    Record &Next() {
+        return records_[head_.load(std::memory_order_relaxed) % records_.size()];
+    }
+
+    void Publish() {
+        head_.store(head_.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Records written since the previous call, the oldest ones are lost if the ring wrapped around
+    std::vector<Record> Take(size_t &lost) {
+        uint64_t head = head_.load(std::memory_order_acquire);
+        uint64_t first = std::max(exported_, head > records_.size() ? head - records_.size() : 0);
+        std::vector<Record> res;
+        for (uint64_t i = first; i < head; ++i)
+            res.push_back(records_[i % records_.size()]);
+
+        // The owner could have overwritten the beginning meanwhile
+        uint64_t after = head_.load(std::memory_order_acquire);
+        size_t overwritten = after > records_.size() ? size_t(after - records_.size()) : 0;
+        size_t skip = overwritten > first ? std::min(res.size(), size_t(overwritten - first)) : 0;
+        res.erase(res.begin(), res.begin() + skip);
+        lost += size_t(first - exported_) + skip;
+        exported_ = head;
+        return res;
+    }
+
+private:
+    std::vector<Record> records_;
+    std::atomic<uint64_t> head_;
+    // Exporter state
+    uint64_t exported_;
+};
+
+class ThreadBuffer {
+public:
+    ThreadBuffer(size_t id, size_t capacity)
+            : id_(id), spans_(capacity), samples_(capacity), depth_(0) {
+        std::fill(counters_, counters_ + COUNTERS, 0);
+        std::fill(sampled_, sampled_ + COUNTERS, 0);
+        for (auto &counter : published_)
+            counter.store(0, std::memory_order_relaxed);
+    }
+
+    void Begin(uint64_t now, const char *name, size_t length) {
+        if (depth_ < MAX_DEPTH) {
+            Open &open = stack_[depth_];
+            open.start = now;
+            open.name = NameId(std::string(name, std::min(length, MAX_NAME)));
+        }
+        depth_ += 1;
+    }
+
+    void End(uint64_t now) {
+        // The scope was open before the recording started
+        if (depth_ == 0)
+            return;
+
+        depth_ -= 1;
+        if (depth_ >= MAX_DEPTH)
+            return;
+
+        Span &span = spans_.Next();
+        span.ts = stack_[depth_].start;
+        span.dur = now - stack_[depth_].start;
+        span.name = stack_[depth_].name;
+        spans_.Publish();
+
+        SampleCounters(now);
+    }
+
+    void Add(Counter counter, uint64_t value) {
+        counters_[size_t(counter)] += value;
+        published_[size_t(counter)].store(counters_[size_t(counter)], std::memory_order_relaxed);
+    }
+
+    std::vector<Span> TakeSpans(size_t &lost) {
+        return spans_.Take(lost);
+    }
+
+    // Counter samples since the previous call followed by the final values of the counters
+    std::vector<Sample> TakeSamples(uint64_t now, size_t &lost) {
+        auto res = samples_.Take(lost);
+        for (size_t i = 0; i < COUNTERS; ++i) {
+            uint64_t value = published_[i].load(std::memory_order_relaxed);
+            if (value)
+                res.push_back({ now, value, uint32_t(i) });
+        }
+        return res;
+    }
+
+    size_t id() const {
+        return id_;
+    }
+
+    // The buffer of an exited thread is taken by another one, which starts with no scopes open
+    void Reuse() {
+        depth_ = 0;
+    }
+
+private:
+    uint32_t NameId(const std::string &name) {
+        auto it = name_cache_.find(name);
+        if (it == name_cache_.end())
+            it = name_cache_.emplace(name, Intern(name)).first;
+        return it->second;
+    }
+
+    // Only the counters changed since the previous sample are written
+    void SampleCounters(uint64_t now) {
+        for (size_t i = 0; i < COUNTERS; ++i) {
+            if (counters_[i] == sampled_[i])
+                continue;
+
+            Sample &sample = samples_.Next();
+            sample.ts = now;
+            sample.value = counters_[i];
+            sample.counter = uint32_t(i);
+            samples_.Publish();
+            sampled_[i] = counters_[i];
+        }
+    }
+
+    const size_t id_;
+    Ring<Span> spans_;
+    Ring<Sample> samples_;
+
+    // Owner state
+    Open stack_[MAX_DEPTH];
+    size_t depth_;
+    std::unordered_map<std::string, uint32_t> name_cache_;
+    uint64_t counters_[COUNTERS];
+    uint64_t sampled_[COUNTERS];
+    std::atomic<uint64_t> published_[COUNTERS];
+};
+
+std::mutex buffers_lock;
+std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+// Buffers of the exited threads, the new threads take them first
+std::vector<ThreadBuffer*> free_buffers;
+size_t untraced_threads = 0;
+std::string trace_prefix;
+size_t buffer_events = 0;
+clock_type::time_point start_time;
+
+// Buffers of the previous recordings are freed by disable()
+std::atomic<unsigned> generation(0);
+
+// Returns the buffer to the pool when the thread exits, so that short-lived threads
+// (e.g. of the OpenMP pools created over and over) do not allocate buffers without bound
+struct BufferHolder {
+    ThreadBuffer *buffer = nullptr;
+    unsigned generation = 0;
+    bool untraced = false;
+
+    ~BufferHolder() {
+        std::lock_guard<std::mutex> lock(buffers_lock);
+        if (buffer && generation == trace::generation.load(std::memory_order_relaxed))
+            free_buffers.push_back(buffer);
+    }
+};
+thread_local BufferHolder thread_buffer;
+
+uint64_t Now() {
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now() - start_time).count());
+}
+
+ThreadBuffer *Buffer() {
+    unsigned current = generation.load(std::memory_order_relaxed);
+    if (thread_buffer.generation != current) {
+        thread_buffer.buffer = nullptr;
+        thread_buffer.untraced = false;
+        thread_buffer.generation = current;
+    }
+    if (thread_buffer.buffer || thread_buffer.untraced)
+        return thread_buffer.buffer;
+
+    std::lock_guard<std::mutex> lock(buffers_lock);
+    if (!free_buffers.empty()) {
+        thread_buffer.buffer = free_buffers.back();
+        thread_buffer.buffer->Reuse();
+        free_buffers.pop_back();
+    } else if (buffers.size() < MAX_BUFFERS) {
+        buffers.push_back(std::make_unique<ThreadBuffer>(buffers.size(), buffer_events));
+        thread_buffer.buffer = buffers.back().get();
+    } else {
+        thread_buffer.untraced = true;
+        untraced_threads += 1;
+    }
+    return thread_buffer.buffer;
+}
+
+void WriteEscaped(std::ostream &os, const char *s) {
+    for (; *s; ++s) {
+        if (*s == '"' || *s == '\\')
+            os << '\\' << *s;
+        else if ((unsigned char) *s >= 0x20)
+            os << *s;
+    }
+}
+
+}
+
+std::atomic<bool> impl::enabled(false);
+
+void impl::begin(const char *name, size_t length) {
+    if (ThreadBuffer *buffer = Buffer())
+        buffer->Begin(Now(), name, length);
+}
+
+void impl::end() {
+    if (ThreadBuffer *buffer = Buffer())
+        buffer->End(Now());
+}
+
+void impl::add(Counter counter, uint64_t value) {
+    if (ThreadBuffer *buffer = Buffer())
+        buffer->Add(counter, value);
+}
+
+void enable(const std::string &prefix, size_t events_per_thread) {
+    VERIFY(events_per_thread > 0);
+    VERIFY_MSG(!enabled(), "Per-thread tracing is already enabled");
+    trace_prefix = prefix;
+    buffer_events = events_per_thread;
+    start_time = clock_type::now();
+    Intern("other");
+    impl::enabled = true;
+    // The calling thread goes first
+    Buffer();
+}
+
+void disable() {
+    impl::enabled = false;
+
+    std::lock_guard<std::mutex> lock(buffers_lock);
+    buffers.clear();
+    free_buffers.clear();
+    untraced_threads = 0;
+    generation += 1;
+
+    std::lock_guard<std::mutex> names_guard(names_lock);
+    names.clear();
+    name_ids.clear();
+}
+
+void flush(const std::string &name) {
+    if (!enabled())
+        return;
+
+    std::string filename = trace_prefix + name + ".json";
+    std::ofstream os(filename);
+    if (!os) {
+        WARN("Cannot write per-thread trace to " << filename);
+        return;
+    }
+
+    uint64_t now = Now();
+    size_t lost = 0;
+    os << "{\"traceEvents\":[";
+    bool first = true;
+    auto separate = [&]() {
+        os << (first ? "\n" : ",\n");
+        first = false;
+    };
+
+    std::vector<std::string> span_names;
+    {
+        std::lock_guard<std::mutex> names_guard(names_lock);
+        span_names = names;
+    }
+
+    std::lock_guard<std::mutex> lock(buffers_lock);
+    for (const auto &buffer : buffers) {
+        size_t tid = buffer->id();
+        separate();
+        os << "{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":" << tid
+           << ",\"args\":{\"name\":\"" << (tid ? "thread " + std::to_string(tid) : std::string("main")) << "\"}}";
+
+        os << std::fixed;
+        os.precision(3);
+        for (const Span &span : buffer->TakeSpans(lost)) {
+            separate();
+            os << "{\"ph\":\"X\",\"name\":\"";
+            // The name could be interned after the copy was taken
+            WriteEscaped(os, span.name < span_names.size() ? span_names[span.name].c_str() : "other");
+            os << "\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << double(span.ts) / 1e3
+               << ",\"dur\":" << double(span.dur) / 1e3 << "}";
+        }
+
+        // Counters are shown per process, so every counter of every thread gets its own track
+        for (const Sample &sample : buffer->TakeSamples(now, lost)) {
+            separate();
+            os << "{\"ph\":\"C\",\"name\":\"" << COUNTER_NAMES[sample.counter] << " (thread " << tid
+               << ")\",\"pid\":1,\"tid\":" << tid << ",\"ts\":" << double(sample.ts) / 1e3
+               << ",\"args\":{\"value\":" << sample.value << "}}";
+        }
+    }
+    os << "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    if (lost)
+        WARN(lost << " per-thread trace events were overwritten, consider a larger buffer");
+    if (untraced_threads)
+        WARN(untraced_threads << " threads were not traced, more than " << MAX_BUFFERS << " threads were alive");
+    INFO("Per-thread trace is written to: " << filename);
+}
+
+}
+}
@@ -0,0 +1,89 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace utils {
+namespace trace {
+
+/*
+ * Per-thread event recorder complementing the time tracer, which only sees the main thread.
+ * Every thread writes the scopes it completes and the samples of its counters into its own
+ * ring buffers without locks; the oldest records are overwritten when a buffer is full.
+ * The buffers of exited threads are taken over by new ones, so their number is bounded by
+ * the threads alive at the same time.
+ * Scope names are interned (and truncated), so a record takes a couple dozen bytes.
+ * flush() exports the events recorded since the previous flush in Chrome trace-event JSON,
+ * to be opened in chrome://tracing or Perfetto.
+ */
+enum class Counter : unsigned {
+    BytesRead,
+    KMersProcessed,
+    ReadsMapped,
+    Total
+};
+
+namespace impl {
+extern std::atomic<bool> enabled;
+
+void begin(const char *name, size_t length);
+void end();
+void add(Counter counter, uint64_t value);
+}
+
+// Starts recording, events are written to <prefix><name>.json on flush
+void enable(const std::string &prefix, size_t events_per_thread);
+
+// Stops recording and frees the buffers, the events not flushed yet are dropped.
+// Should be called when the worker threads are idle, as flush().
+void disable();
+
+inline bool enabled() {
+    return impl::enabled.load(std::memory_order_relaxed);
+}
+
+inline void begin(const char *name, size_t length) {
+    if (enabled())
+        impl::begin(name, length);
+}
+
+inline void begin(const std::string &name) {
+    begin(name.data(), name.size());
+}
+
+inline void end() {
+    if (enabled())
+        impl::end();
+}
+
+inline void add(Counter counter, uint64_t value) {
+    if (enabled())
+        impl::add(counter, value);
+}
+
+// Should be called when the worker threads are idle, e.g. between the stages
+void flush(const std::string &name);
+
+struct scope {
+    scope(const char *name, size_t length) {
+        begin(name, length);
+    }
+
+    explicit scope(const std::string &name)
+            : scope(name.data(), name.size()) {}
+
+    ~scope() {
+        end();
+    }
+};
+
+}
+}
@@ -7,11 +7,21 @@
 
 #include "perfect_hash_map_builder.hpp"
 #include "utils/parallel/openmp_wrapper.h"
+#include <algorithm>
 #include <cstdlib>
+#include <vector>
 
 namespace utils {
 
 struct CoverageHashMapBuilder : public utils::PerfectHashMapBuilder {
+    static const size_t DefaultBatchSize = 1 << 20;
+
+    // Bucketed mode collects the k-mer indices of every stream into buckets by index range
+    // and applies each bucket in a single thread, so no atomics are needed. Otherwise every
+    // k-mer is counted with an atomic increment right away.
+    explicit CoverageHashMapBuilder(bool bucketed = true, size_t batch_size = DefaultBatchSize)
+            : bucketed_(bucketed), batch_size_(batch_size) {}
+
     template<class ReadStream, class Index>
     void FillCoverageFromStream(ReadStream &stream, Index &index) const {
         typedef typename Index::KeyType Kmer;
@@ -37,6 +47,70 @@ struct CoverageHashMapBuilder : public utils::PerfectHashMapBuilder {
         }
     }
 
+    // Appends the indices of the k-mers of the stream to the buckets until batch_size_ of them
+    // are collected. Returns true when the stream is exhausted.
+    template<class ReadStream, class Index>
+    bool CollectCoverageUpdates(ReadStream &stream, const Index &index,
+                                std::vector<std::vector<typename Index::IdxType>> &buckets,
+                                size_t bucket_size) const {
+        typedef typename Index::KeyType Kmer;
+        unsigned k = index.k();
+
+        size_t collected = 0;
+        while (collected < batch_size_ && !stream.eof()) {
+            typename ReadStream::ReadT r;
+            stream >> r;
+
+            const Sequence &seq = r.sequence();
+            if (seq.size() < k)
+                continue;
+
+            typename Index::KeyWithHash kwh = index.ConstructKWH(seq.start<Kmer>(k) >> 'A');
+            for (size_t j = k - 1; j < seq.size(); ++j) {
+                kwh <<= seq[j];
+                if (!kwh.is_minimal() || !index.valid(kwh))
+                    continue;
+
+                buckets[kwh.idx() / bucket_size].push_back(kwh.idx());
+                collected += 1;
+            }
+        }
+
+        return stream.eof();
+    }
+
+    template<class Streams, class Index>
+    void FillCoverageBucketed(Streams &streams, Index &index, unsigned nthreads) const {
+        typedef typename Index::IdxType IdxType;
+
+        // Many more buckets than threads to balance the hot index ranges
+        size_t num_buckets = 16 * nthreads;
+        size_t bucket_size = std::max<size_t>((index.size() + num_buckets - 1) / num_buckets, 1);
+        std::vector<std::vector<std::vector<IdxType>>> updates(streams.size(),
+                                                               std::vector<std::vector<IdxType>>(num_buckets));
+        std::vector<uint8_t> done(streams.size(), false);
+
+        size_t active = streams.size();
+        while (active) {
+#           pragma omp parallel for num_threads(nthreads)
+            for (size_t i = 0; i < streams.size(); ++i) {
+                if (!done[i])
+                    done[i] = CollectCoverageUpdates(streams[i], index, updates[i], bucket_size);
+            }
+
+#           pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+            for (size_t b = 0; b < num_buckets; ++b) {
+                for (auto &buckets : updates) {
+                    for (IdxType idx : buckets[b])
+                        index.get_raw_value_reference(idx) += 1;
+                    buckets[b].clear();
+                }
+            }
+
+            active = size_t(std::count(done.begin(), done.end(), false));
+        }
+    }
+
     template<class Index, class KMerStorage, class Streams>
     void BuildIndex(Index &index,
                     const KMerStorage& storage,
@@ -47,10 +121,47 @@ struct CoverageHashMapBuilder : public utils::PerfectHashMapBuilder {
         INFO("Collecting k-mer coverage information from reads, this takes a while.");
 
         streams.reset();
+        if (bucketed_) {
+            FillCoverageBucketed(streams, index, nthreads);
+            return;
+        }
+
 #       pragma omp parallel for num_threads(nthreads)
         for (size_t i = 0; i < streams.size(); ++i) {
             FillCoverageFromStream(streams[i], index);
         }
     }
+
+    // Takes the coverage from the multiplicities counted along with the k-mers
+    // (see KMerSortingSplitter::set_count_multiplicities()) instead of scanning the reads again
+    template<class Index, class KMerStorage>
+    void BuildIndexFromCounts(Index &index,
+                              const KMerStorage& storage,
+                              unsigned nthreads) const {
+        typedef typename Index::KeyType Kmer;
+        VERIFY_MSG(storage.has_counts(), "k-mer multiplicities were not counted");
+
+        utils::PerfectHashMapBuilder::BuildIndex(index, storage, nthreads);
+        INFO("Collecting k-mer coverage information from k-mer multiplicities");
+
+        unsigned k = index.k();
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic)
+        for (size_t i = 0; i < storage.num_buckets(); ++i) {
+            auto counts = storage.bucket_counts(i);
+            size_t j = 0;
+            for (auto kmer : storage.bucket(i)) {
+                typename Index::KeyWithHash kwh = index.ConstructKWH(Kmer(k, kmer.first));
+                // Every k-mer is unique, so no synchronization is needed
+                if (kwh.is_minimal() && index.valid(kwh))
+                    index.get_raw_value_reference(kwh) = counts[j];
+                j += 1;
+            }
+            VERIFY(j == counts.size());
+        }
+    }
+
+private:
+    bool bucketed_;
+    size_t batch_size_;
 };
 }
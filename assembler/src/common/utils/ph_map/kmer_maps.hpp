@@ -8,6 +8,7 @@
 #include "perfect_hash_map.hpp"
 #include "io/kmers/kmer_iterator.hpp"
 #include "utils/filesystem/path_helper.hpp"
+#include "utils/filesystem/temporary.hpp"
 #include "utils/logger/logger.hpp"
 
 namespace utils {
@@ -184,7 +185,7 @@ public:
 
     kmer_iterator kmer_begin() const {
         VERIFY(kmers_ && "Index should be built");
-        return raw_kmer_iterator(*this->kmers_, KMer::GetDataSize(base::k()));
+        return io::make_raw_kmer_iterator<KMer>(*this->kmers_, base::k());
     }
 
     std::vector<kmer_iterator> kmer_begin(size_t parts) const {
@@ -192,6 +193,21 @@ public:
         return io::make_raw_kmer_iterator<KMer>(*this->kmers_, base::k(), parts);
     }
 
+    template<class Writer>
+    void BinWrite(Writer &writer) const {
+        VERIFY(kmers_ && "Index should be built");
+        base::BinWrite(writer);
+        fs::write_to_stream(writer, *kmers_);
+    }
+
+    // The k-mers are restored into the working directory, since they are iterated from a file
+    template<class Reader>
+    void BinRead(Reader &reader, fs::TmpDir work_dir) {
+        base::BinRead(reader);
+        kmers_ = work_dir->tmp_file("final_kmers");
+        fs::read_from_stream(reader, *kmers_);
+    }
+
     friend struct KeyIteratingIndexBuilder;
 };
 
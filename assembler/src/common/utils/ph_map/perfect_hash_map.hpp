@@ -14,6 +14,7 @@
 #include "io/binary/binary.hpp"
 
 #include "utils/kmer_mph/kmer_index.hpp"
+#include "utils/parallel/numa.hpp"
 #include "utils/verify.hpp"
 
 #include <vector>
@@ -92,7 +93,7 @@ public:
 
     PerfectHashMap(unsigned k, std::shared_ptr<KMerIndexT> index_ptr)
             : KeyBase(k, index_ptr) {
-        data_.resize(index_ptr_->size());
+        resize(index_ptr_->size());
     }
 
     KeyWithHash ConstructKWH(const KeyType &key) const {
@@ -121,6 +122,10 @@ public:
         return data_[kwh.idx()];
     }
 
+    V &get_raw_value_reference(IdxType idx) {
+        return data_[idx];
+    }
+
     void put_value(const KeyWithHash &kwh, const V &value) {
         StoringType::set_value(data_, kwh, value);
     }
@@ -143,7 +148,13 @@ public:
 
     template<class Reader>
     void BinRead(Reader &reader) {
-        io::binary::BinRead(reader, data_);
+        // The format of std::vector, the values are read into the memory placed by resize()
+        size_t sz;
+        io::binary::BinRead(reader, sz);
+        data_.clear();
+        resize(sz);
+        for (auto &value : data_)
+            io::binary::BinRead(reader, value);
         KeyBase::BinRead(reader);
     }
 
@@ -158,11 +169,15 @@ public:
 
     friend struct PerfectHashMapBuilder;
 
-  private:
+  protected:
     void resize(size_t sz) {
         data_.resize(sz);
+        // Values are accessed by all threads, so they are placed according to the NUMA policy
+        utils::numa_place(data_.data(), sz * sizeof(V), unsigned(omp_get_max_threads()));
     }
 
+  private:
+
     Container data_;
 };
 
@@ -25,6 +25,7 @@ struct corrector_config {
     unsigned max_nthreads;
     Strategy strat;
     std::string bwa;
+    bool inprocess_bwa;
     std::string log_filename;
 };
 
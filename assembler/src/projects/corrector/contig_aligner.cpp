@@ -0,0 +1,176 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "contig_aligner.hpp"
+
+#include "io/reads/file_reader.hpp"
+
+#include "bwa/bwa.h"
+#include "bwa/bwamem.h"
+
+#include <cstring>
+
+namespace corrector {
+
+// Alignments of the reads of the current batch. BWA finalizes every read (or pair) in a single thread,
+// so the slots are filled without synchronization.
+static std::vector<std::vector<AlignmentRecord>> *batch_records = nullptr;
+
+// Replaces mem_fmt_sam: the same fields are stored into the record instead of the SAM line
+static void StoreAlignment(const mem_opt_t *opt, const bntseq_t *, struct __kstring_t *, bseq1_t *s, int,
+                           const mem_aln_t *, int which, const mem_aln_t *p, const mem_aln_t *) {
+    // BWA operations MIDSH to BAM ones
+    static const uint32_t BAM_OPS[] = { BAM_CMATCH, BAM_CINS, BAM_CDEL, BAM_CSOFT_CLIP, BAM_CHARD_CLIP };
+    static const uint8_t NT16[] = { 1, 2, 4, 8, 15 };
+    static const uint8_t NT16_RC[] = { 8, 4, 2, 1, 15 };
+
+    AlignmentRecord record;
+    bam1_core_t &core = record.core;
+    memset(&core, 0, sizeof(core));
+    core.tid = core.pos = core.mtid = core.mpos = -1;
+    core.flag = uint32_t((p->flag & 0xFFFF) | (p->flag & 0x10000 ? 0x100 : 0)) & 0xFFFF;
+    AddName(record, s->name, strlen(s->name));
+
+    bool clip = !(opt->flag & MEM_F_SOFTCLIP) && !p->is_alt;
+    if (p->rid >= 0) {
+        core.tid = p->rid;
+        core.pos = int32_t(p->pos);
+        core.qual = p->mapq;
+        for (int i = 0; i < p->n_cigar; ++i) {
+            uint32_t op = p->cigar[i] & 0xf;
+            // Supplementary alignments are hard clipped
+            if (clip && (op == 3 || op == 4))
+                op = which ? 4 : 3;
+            AddCigarOperation(record, p->cigar[i] >> 4, BAM_OPS[op]);
+        }
+    }
+
+    // Secondary alignments go without the sequence
+    if (!(p->flag & 0x100)) {
+        int qb = 0, qe = s->l_seq;
+        if (p->n_cigar && which && clip) {
+            uint32_t first = p->cigar[0], last = p->cigar[p->n_cigar - 1];
+            int first_clip = ((first & 0xf) == 4 || (first & 0xf) == 3) ? int(first >> 4) : 0;
+            int last_clip = ((last & 0xf) == 4 || (last & 0xf) == 3) ? int(last >> 4) : 0;
+            qb += p->is_rev ? last_clip : first_clip;
+            qe -= p->is_rev ? first_clip : last_clip;
+        }
+        std::vector<uint8_t> nt16(qe - qb);
+        for (int i = qb; i < qe; ++i) {
+            if (!p->is_rev)
+                nt16[i - qb] = NT16[int(s->seq[i])];
+            else
+                nt16[qe - 1 - i] = NT16_RC[int(s->seq[i])];
+        }
+        AddSequence(record, nt16.data(), nt16.size());
+    }
+
+    (*batch_records)[s->id].push_back(std::move(record));
+}
+
+// Strips /1 and /2 suffixes, BWA requires mates to have the same names
+static std::string ReadName(const io::SingleRead &read) {
+    const std::string &name = read.name();
+    size_t len = name.size();
+    if (len > 2 && name[len - 2] == '/' && (name[len - 1] == '1' || name[len - 1] == '2'))
+        return name.substr(0, len - 2);
+    return name;
+}
+
+ContigAligner::ContigAligner(const std::vector<std::string> &contigs, size_t nthreads)
+        : idx_(nullptr, bwa_idx_destroy), nthreads_(nthreads) {
+    bwa_verbose = 1;
+    INFO("Building BWA index of " << contigs.size() << " contigs");
+    idx_ = alignment::BuildBWAIndex(contigs.size(),
+                                    [](size_t i) { return std::to_string(i); },
+                                    [&contigs](size_t i) { return contigs[i]; });
+}
+
+ContigAligner::~ContigAligner() {}
+
+void ContigAligner::AlignLibrary(const std::string &left_file, const std::string &right_file, bool paired,
+                                 ContigAlignmentsBuilder &builder) const {
+    std::unique_ptr<mem_opt_t, void(*)(void*)> opt(mem_opt_init(), free);
+    opt->n_threads = int(nthreads_);
+    if (paired)
+        opt->flag |= MEM_F_PE;
+    size_t chunk_size = size_t(opt->chunk_size) * nthreads_;
+
+    io::FileReadStream left(left_file);
+    std::unique_ptr<io::FileReadStream> right;
+    if (!right_file.empty())
+        right.reset(new io::FileReadStream(right_file));
+    // The mate comes either from the right file or next from the left one for interlaced reads
+    io::FileReadStream &mates = right ? *right : left;
+
+    std::vector<std::string> names, seqs;
+    std::vector<std::vector<AlignmentRecord>> records;
+    std::vector<AlignmentRecord> batch;
+    size_t processed = 0;
+    while (!left.eof()) {
+        names.clear();
+        seqs.clear();
+        size_t bases = 0;
+        io::SingleRead read;
+        while (bases < chunk_size && !left.eof()) {
+            left >> read;
+            names.push_back(ReadName(read));
+            seqs.push_back(read.GetSequenceString());
+            bases += seqs.back().size();
+            if (!paired)
+                continue;
+            if (mates.eof()) {
+                WARN("Odd number of reads in the paired library " << left_file << ", the last read is dropped");
+                names.pop_back();
+                seqs.pop_back();
+                break;
+            }
+            mates >> read;
+            names.push_back(ReadName(read));
+            seqs.push_back(read.GetSequenceString());
+            bases += seqs.back().size();
+        }
+        if (seqs.empty())
+            break;
+
+        std::vector<bseq1_t> bseqs(seqs.size());
+        for (size_t i = 0; i < seqs.size(); ++i) {
+            bseq1_t &s = bseqs[i];
+            memset(&s, 0, sizeof(s));
+            s.l_seq = int(seqs[i].size());
+            s.id = int(i);
+            s.name = &names[i][0];
+            s.seq = &seqs[i][0];
+        }
+
+        records.assign(seqs.size(), {});
+        auto fmt = mem_fmt_fnc;
+        mem_fmt_fnc = StoreAlignment;
+        batch_records = &records;
+        mem_process_seqs(opt.get(), idx_->bwt, idx_->bns, idx_->pac, int64_t(processed), int(bseqs.size()),
+                         bseqs.data(), nullptr);
+        batch_records = nullptr;
+        mem_fmt_fnc = fmt;
+        for (auto &s : bseqs)
+            free(s.sam);
+
+        // Pairs are kept as two consecutive primary alignments, single reads keep the supplementary ones too
+        batch.clear();
+        for (auto &read_records : records) {
+            for (auto &record : read_records) {
+                if (!paired || (record.core.flag & 0x900) == 0)
+                    batch.push_back(std::move(record));
+            }
+        }
+        VERIFY(!paired || batch.size() == records.size());
+        builder.AddBatch(batch, paired ? 2 : 1);
+
+        processed += seqs.size();
+        INFO("processed " << processed << " reads");
+    }
+}
+
+}
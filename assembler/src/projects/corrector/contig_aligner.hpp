@@ -0,0 +1,39 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "contig_alignments.hpp"
+
+#include "modules/alignment/bwa_index.hpp"
+#include "utils/logger/logger.hpp"
+
+#include <string>
+#include <vector>
+
+namespace corrector {
+
+/*
+ * Aligns reads to the contigs with BWA-MEM in-process. The alignments are the same as
+ * "bwa mem" would output, but they go straight into ContigAlignmentsBuilder instead of a SAM file.
+ */
+class ContigAligner {
+public:
+    ContigAligner(const std::vector<std::string> &contigs, size_t nthreads);
+    ~ContigAligner();
+
+    // Single reads or interlaced pairs when right_file is empty
+    void AlignLibrary(const std::string &left_file, const std::string &right_file, bool paired,
+                      ContigAlignmentsBuilder &builder) const;
+
+private:
+    alignment::BWAIdxPtr idx_;
+    size_t nthreads_;
+
+    DECL_LOGGER("ContigAligner");
+};
+
+}
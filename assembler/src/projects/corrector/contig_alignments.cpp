@@ -0,0 +1,151 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "contig_alignments.hpp"
+
+#include "utils/verify.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace corrector {
+
+void AddName(AlignmentRecord &record, const char *name, size_t len) {
+    // l_qname includes the terminating zero and has to fit into 8 bits
+    len = std::min<size_t>(len, 254);
+    record.data.assign(name, len);
+    record.data.push_back('\0');
+    record.core.l_qname = uint32_t(len + 1) & 0xFF;
+}
+
+void AddCigarOperation(AlignmentRecord &record, uint32_t len, uint32_t op) {
+    uint32_t cigar = bam_cigar_gen(len, op);
+    record.data.append((const char *) &cigar, sizeof(cigar));
+    record.core.n_cigar = (record.core.n_cigar + 1) & 0xFFFF;
+}
+
+void AddSequence(AlignmentRecord &record, const uint8_t *nt16, size_t len) {
+    record.core.l_qseq = int32_t(len);
+    size_t start = record.data.size();
+    record.data.resize(start + (len + 1) / 2, '\0');
+    uint8_t *seq = (uint8_t *) &record.data[start];
+    for (size_t i = 0; i < len; ++i)
+        seq[i / 2] = uint8_t(seq[i / 2] | nt16[i] << ((~i & 1) << 2));
+}
+
+AlignmentBlockStream &AlignmentBlockStream::operator>>(sam_reader::SingleSamRead &read) {
+    VERIFY(pos_ + sizeof(bam1_core_t) + sizeof(uint32_t) <= end_);
+    bam1_t b;
+    memcpy(&b.core, pos_, sizeof(bam1_core_t));
+    pos_ += sizeof(bam1_core_t);
+    uint32_t data_len;
+    memcpy(&data_len, pos_, sizeof(data_len));
+    pos_ += sizeof(data_len);
+    VERIFY(pos_ + data_len <= end_);
+    b.l_aux = 0;
+    b.data_len = b.m_data = int(data_len);
+    b.data = const_cast<uint8_t *>(pos_);
+    read.set_data(&b);
+    pos_ += data_len;
+    return *this;
+}
+
+AlignmentBlockStream &AlignmentBlockStream::operator>>(sam_reader::PairedSamRead &read) {
+    sam_reader::SingleSamRead r1, r2;
+    *this >> r1;
+    if (!eof())
+        *this >> r2;
+    read = sam_reader::PairedSamRead(r1, r2);
+    return *this;
+}
+
+static void WriteRecord(std::ofstream &os, const AlignmentRecord &record, int32_t tid) {
+    bam1_core_t core = record.core;
+    core.tid = tid;
+    uint32_t data_len = uint32_t(record.data.size());
+    os.write((const char *) &core, sizeof(core));
+    os.write((const char *) &data_len, sizeof(data_len));
+    os.write(record.data.data(), record.data.size());
+}
+
+void ContigAlignmentsBuilder::AddBatch(const std::vector<AlignmentRecord> &records, size_t group_size) {
+    VERIFY(records.size() % group_size == 0);
+
+    // (contig, group) pairs, the order of the groups within a contig is preserved
+    std::vector<std::pair<uint32_t, uint32_t>> entries;
+    for (size_t g = 0; g < records.size() / group_size; ++g) {
+        for (size_t i = 0; i < group_size; ++i) {
+            const bam1_core_t &core = records[g * group_size + i].core;
+            if (core.tid < 0 || core.qual == 0)
+                continue;
+            std::pair<uint32_t, uint32_t> entry(uint32_t(core.tid), uint32_t(g));
+            if (entries.empty() || entries.back() != entry)
+                entries.push_back(entry);
+        }
+    }
+    std::sort(entries.begin(), entries.end());
+    entries.erase(std::unique(entries.begin(), entries.end()), entries.end());
+
+    Run run;
+    run.filename = prefix_ + ".run" + std::to_string(runs_.size());
+    std::ofstream os(run.filename, std::ios_base::binary);
+    for (const auto &entry : entries) {
+        VERIFY(entry.first < contig_cnt_);
+        for (size_t i = 0; i < group_size; ++i) {
+            const AlignmentRecord &record = records[entry.second * group_size + i];
+            WriteRecord(os, record, record.core.tid == int32_t(entry.first) ? 0 : -1);
+        }
+        uint64_t end = uint64_t(os.tellp());
+        if (!run.ends.empty() && run.ends.back().first == entry.first)
+            run.ends.back().second = end;
+        else
+            run.ends.emplace_back(entry.first, end);
+    }
+    CHECK_FATAL_ERROR(os.good(), "Failed to write alignments to " << run.filename);
+    DEBUG("Run " << run.filename << ": " << entries.size() << " read groups for " << run.ends.size() << " contigs");
+    runs_.push_back(std::move(run));
+}
+
+std::unique_ptr<ContigAlignments> ContigAlignmentsBuilder::Finalize() {
+    std::string filename = prefix_ + ".bin";
+    std::ofstream os(filename, std::ios_base::binary);
+    std::vector<uint64_t> offsets(contig_cnt_ + 1, 0);
+
+    // Runs are mapped rather than opened as streams to keep the number of open files low.
+    // Every run is still read sequentially, since both the runs and the output are ordered by contigs.
+    std::vector<MMappedReader> inputs;
+    inputs.reserve(runs_.size());
+    std::vector<size_t> cursors(runs_.size(), 0);
+    std::vector<uint64_t> starts(runs_.size(), 0);
+    for (const auto &run : runs_)
+        inputs.emplace_back(run.filename, /* unlink */ true, -1ULL);
+
+    for (size_t contig = 0; contig < contig_cnt_; ++contig) {
+        for (size_t r = 0; r < runs_.size(); ++r) {
+            const auto &ends = runs_[r].ends;
+            size_t &cursor = cursors[r];
+            if (cursor == ends.size() || ends[cursor].first != contig)
+                continue;
+            const char *data = (const char *) inputs[r].data();
+            os.write(data + starts[r], ends[cursor].second - starts[r]);
+            starts[r] = ends[cursor].second;
+            ++cursor;
+        }
+        offsets[contig + 1] = uint64_t(os.tellp());
+    }
+    CHECK_FATAL_ERROR(os.good(), "Failed to write alignments to " << filename);
+    os.close();
+
+    for (size_t r = 0; r < runs_.size(); ++r)
+        VERIFY(cursors[r] == runs_[r].ends.size());
+    runs_.clear();
+
+    INFO("Alignments stored: " << offsets.back() / 1024 / 1024 << " Mb");
+    return std::unique_ptr<ContigAlignments>(new ContigAlignments(filename, std::move(offsets)));
+}
+
+}
@@ -0,0 +1,104 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#pragma once
+
+#include "io/sam/read.hpp"
+#include "io/kmers/mmapped_reader.hpp"
+#include "utils/logger/logger.hpp"
+
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace corrector {
+
+/*
+ * Alignments of a library are split by contigs into a single binary file. Every alignment is
+ * stored as a BAM record without qualities and tags: bam1_core_t, the data length and the data
+ * (query name, CIGAR and packed sequence). The reference id of a record is 0 when it is aligned
+ * to the contig of its block and -1 otherwise (e.g. a mate aligned elsewhere). Records of one
+ * contig form a contiguous block located via the offset index.
+ */
+
+struct AlignmentRecord {
+    // Reference id is the index of the contig or -1
+    bam1_core_t core;
+    std::string data;
+};
+
+// The record data is filled in the BAM order: name, CIGAR operations, sequence of 4-bit codes
+void AddName(AlignmentRecord &record, const char *name, size_t len);
+void AddCigarOperation(AlignmentRecord &record, uint32_t len, uint32_t op);
+void AddSequence(AlignmentRecord &record, const uint8_t *nt16, size_t len);
+
+struct AlignmentBlock {
+    const uint8_t *begin = nullptr;
+    const uint8_t *end = nullptr;
+};
+
+// Reads the records of a block, mimics sam_reader::MappedSamStream
+class AlignmentBlockStream {
+public:
+    explicit AlignmentBlockStream(const AlignmentBlock &block)
+            : pos_(block.begin), end_(block.end) {}
+
+    bool eof() const {
+        return pos_ == end_;
+    }
+
+    AlignmentBlockStream &operator>>(sam_reader::SingleSamRead &read);
+    AlignmentBlockStream &operator>>(sam_reader::PairedSamRead &read);
+
+private:
+    const uint8_t *pos_;
+    const uint8_t *end_;
+};
+
+class ContigAlignments {
+public:
+    ContigAlignments(const std::string &filename, std::vector<uint64_t> offsets)
+            : data_(filename, /* unlink */ true, -1ULL), offsets_(std::move(offsets)) {}
+
+    AlignmentBlock block(size_t contig) const {
+        const uint8_t *data = (const uint8_t *) data_.data();
+        return { data + offsets_[contig], data + offsets_[contig + 1] };
+    }
+
+private:
+    MMappedReader data_;
+    std::vector<uint64_t> offsets_;
+};
+
+/*
+ * Collects the alignments of a library. Alignments come in batches of read groups (single reads
+ * or pairs); a group goes to every contig one of its reads is aligned to with non-zero mapping
+ * quality. Every batch is written as a separate run grouped by contigs, the runs are merged
+ * contig by contig in the end.
+ */
+class ContigAlignmentsBuilder {
+public:
+    ContigAlignmentsBuilder(const std::string &prefix, size_t contig_cnt)
+            : prefix_(prefix), contig_cnt_(contig_cnt) {}
+
+    void AddBatch(const std::vector<AlignmentRecord> &records, size_t group_size);
+    std::unique_ptr<ContigAlignments> Finalize();
+
+private:
+    struct Run {
+        std::string filename;
+        // Non-empty contigs and the ends of their blocks
+        std::vector<std::pair<uint32_t, uint64_t>> ends;
+    };
+
+    std::string prefix_;
+    size_t contig_cnt_;
+    std::vector<Run> runs_;
+
+    DECL_LOGGER("ContigAlignmentsBuilder");
+};
+
+}
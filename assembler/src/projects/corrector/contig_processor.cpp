@@ -37,24 +37,20 @@ void ContigProcessor::ReadContig() {
     charts_.resize(contig_.length());
 }
 
-void ContigProcessor::UpdateOneRead(const SingleSamRead &tmp, MappedSamStream &sm) {
-    unordered_map<size_t, position_description> all_positions;
+void ContigProcessor::UpdateOneRead(const SingleSamRead &tmp) {
+    // Alignments to other contigs have negative reference id
     if (tmp.contig_id() < 0) {
         return;
     }
-    auto cur_s = sm.get_contig_name(tmp.contig_id());
-    if (contig_name_.compare(cur_s) != 0) {
-        return;
-    }
-    CountPositions(tmp, all_positions);
+    CountPositions(tmp, read_positions_);
+    charts_.Add(read_positions_);
     size_t error_num = 0;
 
-    for (auto &pos : all_positions) {
-        charts_[pos.first].update(pos.second);
-        if (pos.second.FoundOptimal(contig_[pos.first]) != var_to_pos[(int) contig_[pos.first]]) {
+    read_positions_.ForEach([&](size_t pos, const position_description &desc) {
+        if (desc.FoundOptimal(contig_[pos]) != var_to_pos[(int) contig_[pos]]) {
             error_num++;
         }
-    }
+    });
 
     if (error_num >= error_counts_.size())
         error_counts_[error_counts_.size() - 1]++;
@@ -63,10 +59,10 @@ void ContigProcessor::UpdateOneRead(const SingleSamRead &tmp, MappedSamStream &s
 }
 
 //returns: number of changed nucleotides;
-size_t ContigProcessor::UpdateOneBase(size_t i, stringstream &ss, const unordered_map<size_t, position_description> &interesting_positions) const{
+//maxi: the majority variant, charts_ consensus at the position
+size_t ContigProcessor::UpdateOneBase(size_t i, size_t maxi, stringstream &ss, const unordered_map<size_t, position_description> &interesting_positions) const{
     char old = (char) toupper(contig_[i]);
     auto strat = corr_cfg::get().strat;
-    size_t maxi = charts_[i].FoundOptimal(contig_[i]);
     auto i_position = interesting_positions.find(i);
     if (i_position != interesting_positions.end()) {
         size_t maxj = i_position->second.FoundOptimal(contig_[i]);
@@ -74,17 +70,17 @@ size_t ContigProcessor::UpdateOneBase(size_t i, stringstream &ss, const unordere
             DEBUG("Interesting positions differ with majority!");
             DEBUG("On position " << i << "  old: " << old << " majority: " << pos_to_var[maxi] << "interesting: " << pos_to_var[maxj]);
             if (strat != Strategy::MajorityOnly) {
-                if (charts_[i].votes[maxj] > interesting_weight_cutoff)
+                if (charts_.votes(i, maxj) > interesting_weight_cutoff)
                     maxi = maxj;
                 else
-                    DEBUG(" alternative interesting position with weight " << charts_[i].votes[maxj] <<
+                    DEBUG(" alternative interesting position with weight " << charts_.votes(i, maxj) <<
                           " fails weight cutoff");
             }
         }
     }
     if (old != pos_to_var[maxi]) {
         DEBUG("On position " << i << " changing " << old << " to " << pos_to_var[maxi]);
-        DEBUG(charts_[i].str());
+        DEBUG(charts_.at(i).str());
         if (maxi < Variants::Deletion) {
             ss << pos_to_var[maxi];
             return 1;
@@ -94,19 +90,21 @@ size_t ContigProcessor::UpdateOneBase(size_t i, stringstream &ss, const unordere
             string maxj = "";
             //first base before insertion;
             size_t new_maxi = var_to_pos[(int) contig_[i]];
-            int new_maxx = charts_[i].votes[new_maxi];
+            int new_maxx = charts_.votes(i, new_maxi);
             for (size_t k = 0; k < MAX_VARIANTS; k++) {
-                if (new_maxx < charts_[i].votes[k] && (k != Variants::Insertion) && (k != Variants::Deletion)) {
-                    new_maxx = charts_[i].votes[k];
+                if (new_maxx < charts_.votes(i, k) && (k != Variants::Insertion) && (k != Variants::Deletion)) {
+                    new_maxx = charts_.votes(i, k);
                     new_maxi = k;
                 }
             }
             ss << pos_to_var[new_maxi];
             int max_ins = 0;
-            for (const auto &ic : charts_[i].insertions) {
-                if (ic.second > max_ins) {
-                    max_ins = ic.second;
-                    maxj = ic.first;
+            if (const InsertionVariants *insertions = charts_.insertions(i)) {
+                for (const auto &ic : *insertions) {
+                    if (ic.second > max_ins) {
+                        max_ins = ic.second;
+                        maxj = ic.first;
+                    }
                 }
             }
             DEBUG("most popular insertion: " << maxj);
@@ -128,8 +126,8 @@ size_t ContigProcessor::UpdateOneBase(size_t i, stringstream &ss, const unordere
 }
 
 
-bool ContigProcessor::CountPositions(const SingleSamRead &read, unordered_map<size_t, position_description> &ps) const {
-
+bool ContigProcessor::CountPositions(const SingleSamRead &read, ReadPositions &ps) const {
+    ps.clear();
     if (read.contig_id() < 0) {
         DEBUG("not this contig");
         return false;
@@ -181,7 +179,7 @@ bool ContigProcessor::CountPositions(const SingleSamRead &read, unordered_map<si
             size_t ind = i + position - skipped - 1;
             if (ind >= contig_.length())
                 break;
-            ps[ind].insertions[insertion_string] += 1;
+            ps.AddInsertion(ind, insertion_string);
             insertion_string = "";
         }
         char cur_state = bam_cigar_opchr(cigar[state_pos]);
@@ -223,7 +221,7 @@ bool ContigProcessor::CountPositions(const SingleSamRead &read, unordered_map<si
         VERIFY(l_read + position >= skipped + 1);
         size_t ind = l_read + position - skipped - 1;
         if (ind < contig_.length()) {
-            ps[ind].insertions[insertion_string] += 1;
+            ps.AddInsertion(ind, insertion_string);
         }
         insertion_string = "";
     }
@@ -231,43 +229,43 @@ bool ContigProcessor::CountPositions(const SingleSamRead &read, unordered_map<si
 }
 
 
-bool ContigProcessor::CountPositions(const PairedSamRead &read, unordered_map<size_t, position_description> &ps) const {
+bool ContigProcessor::CountPositions(const PairedSamRead &read, ReadPositions &ps, ReadPositions &mate_ps) const {
 
     TRACE("starting pairing");
     bool t1 = CountPositions(read.Left(), ps );
-    unordered_map<size_t, position_description> tmp;
-    bool t2 = CountPositions(read.Right(), tmp);
+    bool t2 = CountPositions(read.Right(), mate_ps);
     //overlaps.. multimap? Look on qual?
-    if (ps.size() == 0 || tmp.size() == 0) {
+    if (ps.empty() || mate_ps.empty()) {
         //We do not need paired reads which are not really paired
         ps.clear();
         return false;
     }
-    TRACE("counted, uniting maps of " << tmp.size() << " and " << ps.size());
-    ps.insert(tmp.begin(), tmp.end());
+    TRACE("counted, uniting maps of " << mate_ps.size() << " and " << ps.size());
+    //positions of the left mate win on the overlap
+    ps.Merge(mate_ps);
     TRACE("united");
     return (t1 && t2);
 }
 
 size_t ContigProcessor::ProcessMultipleSamFiles() {
     error_counts_.resize(kMaxErrorNum);
-    for (const auto &sf : sam_files_) {
-        MappedSamStream sm(sf.first);
+    for (const auto &sf : alignments_) {
+        AlignmentBlockStream sm(sf.first);
         while (!sm.eof()) {
             SingleSamRead tmp;
             sm >> tmp;
 
-            UpdateOneRead(tmp, sm);
+            UpdateOneRead(tmp);
         }
-        sm.close();
     }
+    vector<size_t> coverage = charts_.TotalMapped();
     size_t total_coverage = 0;
-    for (const auto &pos: charts_)
-        total_coverage += pos.TotalMapped();
+    for (size_t cov : coverage)
+        total_coverage += cov;
     size_t average_coverage = total_coverage / contig_.length();
     size_t different_cov = 0;
-    for (const auto &pos: charts_)
-        if ((pos.TotalMapped() < average_coverage / 2) || (pos.TotalMapped() > (average_coverage * 3) / 2))
+    for (size_t cov : coverage)
+        if ((cov < average_coverage / 2) || (cov > (average_coverage * 3) / 2))
             different_cov++;
     if (different_cov < contig_.length() * 3/ 10) {
         interesting_weight_cutoff = int (average_coverage / 2);
@@ -275,14 +273,14 @@ size_t ContigProcessor::ProcessMultipleSamFiles() {
                << " setting interesting positions heuristics to " << interesting_weight_cutoff);
     }
     ipp_.FillInterestingPositions(charts_);
-    for (const auto &sf : sam_files_) {
-        MappedSamStream sm(sf.first);
+    ReadPositions ps, mate_ps;
+    for (const auto &sf : alignments_) {
+        AlignmentBlockStream sm(sf.first);
         while (!sm.eof()) {
-            unordered_map<size_t, position_description> ps;
             if (sf.second == io::LibraryType::PairedEnd ) {
                 PairedSamRead tmp;
                 sm >> tmp;
-                CountPositions(tmp, ps);
+                CountPositions(tmp, ps, mate_ps);
             } else {
                 SingleSamRead tmp;
                 sm >> tmp;
@@ -290,14 +288,14 @@ size_t ContigProcessor::ProcessMultipleSamFiles() {
             }
             ipp_.UpdateInterestingRead(ps);
         }
-        sm.close();
     }
     ipp_.UpdateInterestingPositions();
-    unordered_map<size_t, position_description> interesting_positions = ipp_.get_weights();
+    const auto &interesting_positions = ipp_.get_weights();
+    vector<uint8_t> majority = charts_.FoundOptimal(contig_);
     stringstream s_new_contig;
     size_t total_changes = 0;
     for (size_t i = 0; i < contig_.length(); i++) {
-        total_changes += UpdateOneBase(i, s_new_contig, interesting_positions);
+        total_changes += UpdateOneBase(i, majority[i], s_new_contig, interesting_positions);
     }
     vector<string> contig_name_splitted;
     boost::split(contig_name_splitted, contig_name_, boost::is_any_of("_"));
@@ -6,11 +6,11 @@
 //***************************************************************************
 
 #pragma once
+#include "contig_alignments.hpp"
 #include "interesting_pos_processor.hpp"
 #include "positional_read.hpp"
 #include "utils/parallel/openmp_wrapper.h"
 
-#include <io/sam/sam_reader.hpp>
 #include <io/sam/read.hpp>
 #include "pipeline/library_fwd.hpp"
 
@@ -22,14 +22,15 @@ namespace corrector {
 
 using namespace sam_reader;
 
-typedef std::vector<std::pair<std::string, io::LibraryType> > sam_files_type;
+typedef std::vector<std::pair<AlignmentBlock, io::LibraryType> > AlignmentBlocks;
 class ContigProcessor {
-    sam_files_type sam_files_;
+    AlignmentBlocks alignments_;
     std::string contig_file_;
     std::string contig_name_;
     std::string output_contig_file_;
     std::string contig_;
-    std::vector<position_description> charts_;
+    PositionCharts charts_;
+    ReadPositions read_positions_;
     InterestingPositionProcessor ipp_;
     std::vector<int> error_counts_;
 
@@ -38,8 +39,8 @@ class ContigProcessor {
 protected:
     DECL_LOGGER("ContigProcessor")
 public:
-    ContigProcessor(const sam_files_type &sam_files, const std::string &contig_file)
-            : sam_files_(sam_files), contig_file_(contig_file) {
+    ContigProcessor(const AlignmentBlocks &alignments, const std::string &contig_file)
+            : alignments_(alignments), contig_file_(contig_file) {
         ReadContig();
         ipp_.set_contig(contig_);
 //At least three reads to believe in inexact repeats heuristics.
@@ -49,13 +50,13 @@ public:
 private:
     void ReadContig();
 //Moved from read.hpp
-    bool CountPositions(const SingleSamRead &read, std::unordered_map<size_t, position_description> &ps) const;
-    bool CountPositions(const PairedSamRead &read, std::unordered_map<size_t, position_description> &ps) const;
+    bool CountPositions(const SingleSamRead &read, ReadPositions &ps) const;
+    bool CountPositions(const PairedSamRead &read, ReadPositions &ps, ReadPositions &mate_ps) const;
 
-    void UpdateOneRead(const SingleSamRead &tmp, MappedSamStream &sm);
+    void UpdateOneRead(const SingleSamRead &tmp);
     //returns: number of changed nucleotides;
 
-    size_t UpdateOneBase(size_t i, std::stringstream &ss, const std::unordered_map<size_t, position_description> &interesting_positions) const ;
+    size_t UpdateOneBase(size_t i, size_t maxi, std::stringstream &ss, const std::unordered_map<size_t, position_description> &interesting_positions) const ;
 
 };
 }
@@ -8,6 +8,7 @@
 #include "dataset_processor.hpp"
 #include "variants_table.hpp"
 #include "contig_processor.hpp"
+#include "contig_aligner.hpp"
 #include "config_struct.hpp"
 
 #include "io/reads/file_reader.hpp"
@@ -17,6 +18,7 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <cstring>
 #include <iostream>
 #include <unistd.h>
 
@@ -33,7 +35,7 @@ std::string DatasetProcessor::GetLibDir(const size_t lib_count) {
 
 void DatasetProcessor::SplitGenome(const string &genome_splitted_dir) {
     io::FileReadStream frs(genome_file_);
-    size_t cur_id = 0;
+    size_t &cur_id = contig_cnt_;
     while (!frs.eof()) {
         io::SingleRead cur_read;
         frs >> cur_read;
@@ -44,83 +46,119 @@ void DatasetProcessor::SplitGenome(const string &genome_splitted_dir) {
         }
         string full_path = fs::append_path(genome_splitted_dir, contig_name + ".fasta");
         string out_full_path = fs::append_path(genome_splitted_dir, contig_name + ".ref.fasta");
-        string sam_filename = fs::append_path(genome_splitted_dir, contig_name + ".pair.sam");
-        all_contigs_[contig_name] = {full_path, out_full_path, contig_seq.length(), sam_files_type(), sam_filename, cur_id};
+        all_contigs_[contig_name] = {full_path, out_full_path, contig_seq.length(), cur_id};
         cur_id ++;
-        buffered_reads_[contig_name].clear();
+        if (corr_cfg::get().inprocess_bwa)
+            contig_seqs_.push_back(contig_seq);
         io::OFastaReadStream oss(full_path);
         oss << io::SingleRead(contig_name, contig_seq);
         DEBUG("full_path " + full_path)
     }
 }
 
-//contigs - set of aligned contig names
-void DatasetProcessor::GetAlignedContigs(const string &read, set<string> &contigs) const {
-    vector<string> arr;
-    boost::split(arr, read, boost::is_any_of("\t"));
-    if (arr.size() > 5) {
-        if (arr[2] != "*" && stoi(arr[4]) > 0) {
-// here can be multuple aligned parsing if neeeded;
-            contigs.insert(arr[2]);
+static void UnmappedRecord(AlignmentRecord &record) {
+    bam1_core_t &core = record.core;
+    memset(&core, 0, sizeof(core));
+    core.tid = core.pos = core.mtid = core.mpos = -1;
+}
+
+// Converts a SAM line into the record with the index of the contig as the reference id
+void DatasetProcessor::ParseSamLine(const string &line, AlignmentRecord &record) const {
+    const size_t kFields = 10;
+    const char *fields[kFields + 1];
+    size_t n = 0;
+    fields[n++] = line.c_str();
+    for (size_t i = 0; i < line.size() && n <= kFields; ++i)
+        if (line[i] == '\t')
+            fields[n++] = line.c_str() + i + 1;
+    auto field_len = [&](size_t i) {
+        const char *end = (i + 1 < n) ? fields[i + 1] - 1 : line.c_str() + line.size();
+        return size_t(end - fields[i]);
+    };
+
+    UnmappedRecord(record);
+    AddName(record, fields[0], field_len(0));
+    if (n < kFields + 1) {
+        WARN("Malformed SAM line: " << line);
+        return;
+    }
+
+    bam1_core_t &core = record.core;
+    core.flag = uint32_t(strtol(fields[1], nullptr, 0)) & 0xFFFF;
+    string contig(fields[2], field_len(2));
+    if (contig != "*") {
+        auto it = all_contigs_.find(contig);
+        CHECK_FATAL_ERROR(it != all_contigs_.end(), "wrong contig name in SAM file header: " + contig);
+        core.tid = int32_t(it->second.id);
+    }
+    core.pos = atoi(fields[3]) - 1;
+    core.qual = uint32_t(atoi(fields[4])) & 0xFF;
+
+    const char *s = fields[5];
+    if (*s != '*') {
+        while (*s != '\t') {
+            char *t;
+            uint32_t len = uint32_t(strtoul(s, &t, 10));
+            const char *op = strchr(BAM_CIGAR_STR, toupper(*t));
+            CHECK_FATAL_ERROR(op && *t, "Invalid CIGAR in SAM line: " << line);
+            AddCigarOperation(record, len, uint32_t(op - BAM_CIGAR_STR));
+            s = t + 1;
         }
     }
 
+    size_t l_qseq = field_len(9);
+    if (l_qseq == 1 && fields[9][0] == '*')
+        l_qseq = 0;
+    std::vector<uint8_t> nt16(l_qseq);
+    for (size_t i = 0; i < l_qseq; ++i)
+        nt16[i] = bam_nt16_table[(uint8_t) fields[9][i]];
+    AddSequence(record, nt16.data(), l_qseq);
 }
 
+// Reads are parsed in parallel in batches, every batch goes into a separate run of the alignment storage
 void DatasetProcessor::SplitLibrary(const string &all_reads_filename, const size_t lib_count, bool is_paired = false) {
-    int reads_cnt = is_paired ? 2 : 1;
+    size_t reads_cnt = is_paired ? 2 : 1;
+    ContigAlignmentsBuilder builder(fs::append_path(GetLibDir(lib_count), "alignments"), contig_cnt_);
     ifstream fs(all_reads_filename);
-    while (!fs.eof()) {
-        set<string> contigs;
-        std::vector<std::string> reads(reads_cnt);
-        getline(fs, reads[0]);
-        if (reads[0][0] == '@')
-            continue;
-
-        if (is_paired) {
-            getline(fs, reads[1]);
+    std::vector<std::string> lines;
+    std::vector<AlignmentRecord> records;
+    size_t total = 0;
+    while (fs) {
+        lines.clear();
+        std::string line;
+        while (lines.size() < kBuffSize && getline(fs, line)) {
+            if (line.empty() || line[0] == '@')
+                continue;
+            lines.push_back(std::move(line));
         }
-
-        for (int i = 0; i < reads_cnt; ++i) {
-            GetAlignedContigs(reads[i], contigs);
+        if (lines.empty())
+            break;
+
+        records.resize((lines.size() + reads_cnt - 1) / reads_cnt * reads_cnt);
+#       pragma omp parallel for num_threads(nthreads_)
+        for (size_t i = 0; i < lines.size(); ++i)
+            ParseSamLine(lines[i], records[i]);
+        // The mate of the last read is missing in a truncated file, it is kept as unmapped
+        for (size_t i = lines.size(); i < records.size(); ++i) {
+            UnmappedRecord(records[i]);
+            AddName(records[i], "*", 1);
         }
 
-        for (auto &contig : contigs) {
-            CHECK_FATAL_ERROR(all_contigs_.find(contig) != all_contigs_.end(),
-                              "wrong contig name in SAM file header: " + contig);
-
-            for (int i = 0; i < reads_cnt; ++i) {
-                BufferedOutputRead(reads[i], contig, lib_count);
-            }
-        }
+        builder.AddBatch(records, reads_cnt);
+        total += lines.size();
+        INFO("processed " << total << " reads");
     }
-    FlushAll(lib_count);
+    libs_.back().first = builder.Finalize();
+    fs::remove_if_exists(all_reads_filename);
 }
 
-void DatasetProcessor::FlushAll(const size_t lib_count) {
-    for (const auto &ac : all_contigs_) {
-        if (buffered_reads_[ac.first].size() > 0) {
-            ofstream stream(ac.second.sam_filenames[lib_count].first.c_str(), std::ios_base::app | std::ios_base::out);
-            for (const string &read : buffered_reads_[ac.first]) {
-                stream << read;
-                stream << '\n';
-            }
-            buffered_reads_[ac.first].clear();
-        }
-    }
-}
-
-void DatasetProcessor::BufferedOutputRead(const string &read, const string &contig_name, const size_t lib_count) {
-    buffered_reads_[contig_name].push_back(read);
-    buffered_count_++;
-    if (buffered_count_ % kBuffSize == 0) {
-        if (buffered_count_ % (10 * kBuffSize) == 0)
-            INFO("processed " << buffered_count_ << "reads, flushing");
-        FlushAll(lib_count);
-    }
+void DatasetProcessor::AlignLibrary(const ContigAligner &aligner, const std::vector<std::string> &reads,
+                                    const size_t lib_count, bool is_paired) {
+    ContigAlignmentsBuilder builder(fs::append_path(GetLibDir(lib_count), "alignments"), contig_cnt_);
+    aligner.AlignLibrary(reads[0], reads.size() > 1 ? reads[1] : "", is_paired, builder);
+    libs_.back().first = builder.Finalize();
 }
 
-
 int DatasetProcessor::RunBwaIndex() {
     string bwa_string = fs::screen_whitespaces(fs::screen_whitespaces(corr_cfg::get().bwa));
     string genome_screened = fs::screen_whitespaces(genome_file_);
@@ -159,28 +197,21 @@ std::string DatasetProcessor::RunBwaMem(const std::vector<std::string> &reads, c
     return tmp_sam_filename;
 }
 
-void DatasetProcessor::PrepareContigDirs(const size_t lib_count) {
-    string out_dir = GetLibDir(lib_count);
-    for (auto &ac : all_contigs_) {
-        auto contig_name = ac.first;
-        string out_name = fs::append_path(out_dir, contig_name + ".sam");
-        ac.second.sam_filenames.push_back(make_pair(out_name, unsplitted_sam_files_[lib_count].second));
-        BufferedOutputRead("@SQ\tSN:" + contig_name + "\tLN:" + to_string(all_contigs_[contig_name].contig_length), contig_name, lib_count);
-    }
-    FlushAll(lib_count);
-}
-
 void DatasetProcessor::ProcessDataset() {
     size_t lib_num = 0;
     INFO("Splitting assembly...");
     INFO("Assembly file: " + genome_file_);
     SplitGenome(work_dir_);
 
-    if (RunBwaIndex() != 0) {
+    std::unique_ptr<ContigAligner> aligner;
+    if (corr_cfg::get().inprocess_bwa) {
+        aligner.reset(new ContigAligner(contig_seqs_, nthreads_));
+        std::vector<std::string>().swap(contig_seqs_);
+    } else if (RunBwaIndex() != 0) {
         FATAL_ERROR("Failed to build bwa index for " << genome_file_);
     }
 
-    auto handle_one_lib = [this, &lib_num](const std::vector<std::string>& reads,
+    auto handle_one_lib = [this, &lib_num, &aligner](const std::vector<std::string>& reads,
         const std::string& type, const auto& lib_type){
         std::string reads_files_str = "";
         for (const auto& filename : reads) {
@@ -189,6 +220,15 @@ void DatasetProcessor::ProcessDataset() {
 
         INFO("Processing " + type + " sublib of number " << lib_num);
         INFO(reads_files_str);
+        if (aligner) {
+            // Unpaired reads of paired libraries are aligned and processed as single ones
+            bool is_paired = type != "single";
+            libs_.emplace_back(nullptr, is_paired ? lib_type : io::LibraryType::SingleReads);
+            AlignLibrary(*aligner, reads, lib_num, is_paired);
+            lib_num++;
+            return;
+        }
+
         std::string param = "";
         if (type == "interlaced") {
             param = "-p";
@@ -197,8 +237,7 @@ void DatasetProcessor::ProcessDataset() {
         string samf = RunBwaMem(reads, lib_num, param);
         if (samf != "") {
             INFO("Adding samfile " << samf);
-            unsplitted_sam_files_.push_back(make_pair(samf, lib_type));
-            PrepareContigDirs(lib_num);
+            libs_.emplace_back(nullptr, lib_type);
             SplitLibrary(samf, lib_num,lib_type !=  io::LibraryType::SingleReads);
             lib_num++;
         } else {
@@ -234,8 +273,12 @@ void DatasetProcessor::ProcessDataset() {
     auto all_contigs_ptr = &all_contigs_;
 # pragma omp parallel for shared(all_contigs_ptr, ordered_contigs) num_threads(nthreads_) schedule(dynamic,1)
     for (size_t i = 0; i < cont_num; i++) {
-        bool long_enough = (*all_contigs_ptr)[ordered_contigs[i].second].contig_length > kMinContigLengthForInfo;
-        ContigProcessor pc((*all_contigs_ptr)[ordered_contigs[i].second].sam_filenames, (*all_contigs_ptr)[ordered_contigs[i].second].input_contig_filename);
+        const OneContigDescription &contig = (*all_contigs_ptr)[ordered_contigs[i].second];
+        bool long_enough = contig.contig_length > kMinContigLengthForInfo;
+        AlignmentBlocks blocks;
+        for (const auto &lib : libs_)
+            blocks.emplace_back(lib.first->block(contig.id), lib.second);
+        ContigProcessor pc(blocks, contig.input_contig_filename);
         size_t changes = pc.ProcessMultipleSamFiles();
         if (long_enough) {
 #pragma omp critical
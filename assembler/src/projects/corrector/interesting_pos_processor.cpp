@@ -13,24 +13,24 @@
 using namespace std;
 
 namespace corrector {
-bool InterestingPositionProcessor::FillInterestingPositions(const vector<position_description> &charts) {
+bool InterestingPositionProcessor::FillInterestingPositions(const PositionCharts &charts) {
     bool any_interesting = false;
     for (size_t i = 0; i < contig_.length(); i++) {
         int sum_total = 0;
         for (size_t j = 0; j < MAX_VARIANTS; j++) {
             if (j != Variants::Insertion && j != Variants::Deletion) {
-                sum_total += charts[i].votes[j];
+                sum_total += charts.votes(i, j);
             }
         }
         int variants = 0;
         for (size_t j = 0; j < MAX_VARIANTS; j++) {
             //TODO::For IT reconsider this condition
-            if (j != Variants::Insertion && j != Variants::Deletion && (charts[i].votes[j] > 0.1 * sum_total) && (charts[i].votes[j] < 0.9 * sum_total) && (sum_total > 20)) {
+            if (j != Variants::Insertion && j != Variants::Deletion && (charts.votes(i, j) > 0.1 * sum_total) && (charts.votes(i, j) < 0.9 * sum_total) && (sum_total > 20)) {
                 variants++;
             }
         }
         if (variants > 1 || contig_[i] == Variants::Undefined) {
-            DEBUG("Adding interesting position: " << i << " " << charts[i].str());
+            DEBUG("Adding interesting position: " << i << " " << charts.at(i).str());
             any_interesting = true;
             is_interesting_[i] = true;
             for (int j = -kAnchorNum; j <= kAnchorNum; j++) {
@@ -44,17 +44,17 @@ bool InterestingPositionProcessor::FillInterestingPositions(const vector<positio
     return any_interesting;
 }
 
-void InterestingPositionProcessor::UpdateInterestingRead(const PositionDescriptionMap &ps) {
+void InterestingPositionProcessor::UpdateInterestingRead(const ReadPositions &ps) {
     vector<size_t> interesting_in_read;
-    for (const auto &pos : ps) {
-        if (is_interesting(pos.first)) {
-            interesting_in_read.push_back(pos.first);
+    ps.ForEach([&](size_t pos, const position_description &) {
+        if (is_interesting(pos)) {
+            interesting_in_read.push_back(pos);
         }
-    }
+    });
     if (interesting_in_read.size() >= 2) {
         WeightedPositionalRead wr(interesting_in_read, ps, contig_);
         size_t cur_id = wr_storage_.size();
-        wr_storage_.push_back(wr);
+        wr_storage_.push_back(std::move(wr));
         for (size_t i = 0; i < interesting_in_read.size(); i++) {
             TRACE(interesting_in_read[i] << " " << contig_.length());
             read_ids_[interesting_in_read[i]].push_back(cur_id);
@@ -71,6 +71,8 @@ void InterestingPositionProcessor::set_contig(const string &ctg) {
 
 void InterestingPositionProcessor::UpdateInterestingPositions() {
     auto strat = corr_cfg::get().strat;
+    //weights of the current position only
+    position_description interesting_weights;
     for (int dir = 1; dir >= -1; dir -= 2) {
         int start_pos;
         dir == 1 ? start_pos = 0 : start_pos = (int) contig_.length() - 1;
@@ -80,7 +82,7 @@ void InterestingPositionProcessor::UpdateInterestingPositions() {
                 DEBUG("reads on position: " << read_ids_[current_pos].size());
                 for (size_t i = 0; i < read_ids_[current_pos].size(); i++) {
                     size_t current_read_id = read_ids_[current_pos][i];
-                    size_t current_variant = wr_storage_[current_read_id].positions[current_pos];
+                    size_t current_variant = wr_storage_[current_read_id].variant(current_pos);
                     {
                         int coef = 1;
                         if (strat == Strategy::AllReads)
@@ -89,14 +91,14 @@ void InterestingPositionProcessor::UpdateInterestingPositions() {
                             coef = wr_storage_[current_read_id].processed_positions * wr_storage_[current_read_id].processed_positions;
                         else if (strat == Strategy::AllExceptJustStarted)
                             coef = wr_storage_[current_read_id].is_first(current_pos, dir);
-                        interesting_weights[current_pos].votes[current_variant] += get_error_weight(
+                        interesting_weights.votes[current_variant] += get_error_weight(
                                 wr_storage_[current_read_id].error_num ) * coef;
                     }
                 }
-                size_t maxi = interesting_weights[current_pos].FoundOptimal(contig_[current_pos]);
+                size_t maxi = interesting_weights.FoundOptimal(contig_[current_pos]);
                 for (size_t i = 0; i < read_ids_[current_pos].size(); i++) {
                     size_t current_read_id = read_ids_[current_pos][i];
-                    size_t current_variant = wr_storage_[current_read_id].positions[current_pos];
+                    size_t current_variant = wr_storage_[current_read_id].variant(current_pos);
                     if (current_variant != maxi) {
                         wr_storage_[current_read_id].error_num++;
                     } else {
@@ -108,11 +110,11 @@ void InterestingPositionProcessor::UpdateInterestingPositions() {
                 if ((char) toupper(contig_[current_pos]) != pos_to_var[maxi]) {
                     DEBUG("Interesting positions differ at position " << current_pos);
                     DEBUG("Was " << (char) toupper(contig_[current_pos]) << "new " << pos_to_var[maxi]);
-                    DEBUG("weights" << interesting_weights[current_pos].str());
-                    changed_weights_[current_pos] = interesting_weights[current_pos];
+                    DEBUG("weights" << interesting_weights.str());
+                    changed_weights_[current_pos] = interesting_weights;
                 }
                 //for backward pass
-                interesting_weights[current_pos].clear();
+                interesting_weights.clear();
             }
         }
         if (dir == 1)
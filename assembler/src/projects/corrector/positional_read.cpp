@@ -24,7 +24,100 @@ string position_description::str() const {
 void position_description::clear() {
     for (size_t i = 0; i < MAX_VARIANTS; i++) {
         votes[i] = 0;
-        insertions.clear();
     }
 }
+
+position_description &ReadPositions::operator[](size_t pos) {
+    if (votes_.empty()) {
+        start_ = pos;
+    } else if (pos < start_) {
+        //reads are counted from left to right, so it is rare
+        size_t shift = start_ - pos;
+        votes_.insert(votes_.begin(), shift, position_description());
+        touched_.insert(touched_.begin(), shift, 0);
+        start_ = pos;
+    }
+    size_t i = pos - start_;
+    if (i >= votes_.size()) {
+        votes_.resize(i + 1);
+        touched_.resize(i + 1, 0);
+    }
+    if (!touched_[i]) {
+        touched_[i] = 1;
+        count_ += 1;
+    }
+    return votes_[i];
+}
+
+void ReadPositions::Merge(const ReadPositions &other) {
+    for (const auto &ins : other.insertions_) {
+        if (!contains(ins.first))
+            insertions_.push_back(ins);
+    }
+    other.ForEach([this](size_t pos, const position_description &desc) {
+        if (!contains(pos))
+            (*this)[pos] = desc;
+    });
+}
+
+void ReadPositions::clear() {
+    start_ = 0;
+    count_ = 0;
+    votes_.clear();
+    touched_.clear();
+    insertions_.clear();
+}
+
+void PositionCharts::Add(const ReadPositions &ps) {
+    ps.ForEach([this](size_t pos, const position_description &desc) {
+        for (size_t j = 0; j < MAX_VARIANTS; j++)
+            votes_[j][pos] += desc.votes[j];
+    });
+    for (const auto &ins : ps.insertions()) {
+        auto &variants = insertions_[ins.first];
+        auto it = find_if(variants.begin(), variants.end(),
+                          [&ins](const pair<string, int> &v) { return v.first == ins.second; });
+        if (it == variants.end())
+            variants.emplace_back(ins.second, 1);
+        else
+            it->second += 1;
+    }
+}
+
+vector<size_t> PositionCharts::TotalMapped() const {
+    size_t len = size();
+    vector<size_t> res(len, 0);
+    size_t *r = res.data();
+    for (size_t j = 0; j < MAX_VARIANTS; j++) {
+        const int *v = votes_[j].data();
+#       pragma omp simd
+        for (size_t i = 0; i < len; i++)
+            r[i] += size_t(v[i]);
+    }
+    return res;
+}
+
+vector<uint8_t> PositionCharts::FoundOptimal(const string &contig) const {
+    size_t len = size();
+    vector<uint8_t> res(len);
+    vector<int> best(len);
+    for (size_t i = 0; i < len; i++) {
+        res[i] = uint8_t(var_to_pos[(size_t) contig[i]]);
+        best[i] = votes_[res[i]][i];
+    }
+    //the same order of variants as in position_description::FoundOptimal, one variant for all positions at once
+    uint8_t *r = res.data();
+    int *b = best.data();
+    for (size_t j = 0; j < MAX_VARIANTS; j++) {
+        const int *v = votes_[j].data();
+        bool insertion = (j == Variants::Insertion);
+#       pragma omp simd
+        for (size_t i = 0; i < len; i++) {
+            bool better = b[i] < v[i] || (insertion && b[i] * 2 < v[i] * 3);
+            b[i] = better ? v[i] : b[i];
+            r[i] = better ? uint8_t(j) : r[i];
+        }
+    }
+    return res;
+}
 };
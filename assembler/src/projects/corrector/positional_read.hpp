@@ -9,6 +9,8 @@
 
 #include "variants_table.hpp"
 
+#include "utils/verify.hpp"
+
 #include <string>
 #include <unordered_map>
 #include <vector>
@@ -19,14 +21,12 @@ namespace corrector {
 
 
 struct position_description {
-    int votes[MAX_VARIANTS];
     //'A', 'C', 'G', 'T', 'N', 'D', 'I'
-    std::unordered_map<std::string, int > insertions;
+    int votes[MAX_VARIANTS] = {};
+
     void update(const position_description &another) {
         for (size_t i = 0; i < MAX_VARIANTS; i++)
             votes[i] += another.votes[i];
-        for (auto &ins : another.insertions)
-            insertions[ins.first] += ins.second;
     }
 
     size_t FoundOptimal(char current) const {
@@ -51,44 +51,161 @@ struct position_description {
     std::string str() const;
     void clear() ;
 };
-typedef std::unordered_map <size_t, position_description> PositionDescriptionMap;
+
+// Inserted strings and their votes
+typedef std::vector<std::pair<std::string, int>> InsertionVariants;
+
+/*
+ * Votes of a read (or of a read pair) for the contig positions it covers. These positions form
+ * a window of the contig, so the votes are kept in a dense array, which is reused from read to read.
+ * Only the positions touched by the read are reported, as if they were the keys of a map.
+ */
+class ReadPositions {
+public:
+    bool empty() const {
+        return count_ == 0;
+    }
+
+    size_t size() const {
+        return count_;
+    }
+
+    bool contains(size_t pos) const {
+        return pos >= start_ && pos - start_ < touched_.size() && touched_[pos - start_];
+    }
+
+    const position_description &at(size_t pos) const {
+        return votes_[pos - start_];
+    }
+
+    position_description &operator[](size_t pos);
+
+    void AddInsertion(size_t pos, const std::string &insertion) {
+        (*this)[pos];
+        insertions_.emplace_back(pos, insertion);
+    }
+
+    const std::vector<std::pair<size_t, std::string>> &insertions() const {
+        return insertions_;
+    }
+
+    // Adds the positions of another read which are not covered by this one
+    void Merge(const ReadPositions &other);
+
+    void clear();
+
+    // Calls f(pos, description) for the touched positions in increasing order
+    template<class F>
+    void ForEach(F f) const {
+        for (size_t i = 0; i < touched_.size(); ++i) {
+            if (touched_[i])
+                f(start_ + i, votes_[i]);
+        }
+    }
+
+private:
+    size_t start_ = 0;
+    size_t count_ = 0;
+    std::vector<position_description> votes_;
+    std::vector<uint8_t> touched_;
+    std::vector<std::pair<size_t, std::string>> insertions_;
+};
+
+/*
+ * Votes for all positions of a contig. Every variant has its own dense array, so that
+ * the consensus of the whole contig is called by a few vectorized passes. Insertions are
+ * rare and go to a side pool of the positions having them.
+ */
+class PositionCharts {
+public:
+    void resize(size_t len) {
+        for (auto &v : votes_)
+            v.resize(len, 0);
+    }
+
+    size_t size() const {
+        return votes_[0].size();
+    }
+
+    int votes(size_t pos, size_t variant) const {
+        return votes_[variant][pos];
+    }
+
+    position_description at(size_t pos) const {
+        position_description res;
+        for (size_t j = 0; j < MAX_VARIANTS; ++j)
+            res.votes[j] = votes_[j][pos];
+        return res;
+    }
+
+    // Insertion variants in the order of their first appearance, nullptr if there are none
+    const InsertionVariants *insertions(size_t pos) const {
+        auto it = insertions_.find(pos);
+        return it == insertions_.end() ? nullptr : &it->second;
+    }
+
+    void Add(const ReadPositions &ps);
+
+    // position_description::TotalMapped() of all positions
+    std::vector<size_t> TotalMapped() const;
+
+    // position_description::FoundOptimal() of all positions
+    std::vector<uint8_t> FoundOptimal(const std::string &contig) const;
+
+private:
+    std::vector<int> votes_[MAX_VARIANTS];
+    std::unordered_map<size_t, InsertionVariants> insertions_;
+};
 
 struct WeightedPositionalRead {
-    std::unordered_map<size_t, size_t> positions;
+    // Interesting positions and the variants of the read there, sorted by positions
+    std::vector<std::pair<size_t, size_t>> positions;
     int error_num;
     int non_interesting_error_num;
     int processed_positions;
     double weight;
     size_t first_pos;
     size_t last_pos;
-    WeightedPositionalRead(const std::vector<size_t> &int_pos, const PositionDescriptionMap &ps,const std::string &contig){
+    WeightedPositionalRead(const std::vector<size_t> &int_pos, const ReadPositions &ps, const std::string &contig){
         first_pos = std::numeric_limits<size_t>::max();
         last_pos = 0;
         non_interesting_error_num = 0;
         for (size_t i = 0; i < int_pos.size(); i++ ) {
+            first_pos = std::min(first_pos, int_pos[i]);
+            last_pos = std::max(last_pos, int_pos[i]);
+            if (!ps.contains(int_pos[i]))
+                continue;
             for (size_t j = 0; j < MAX_VARIANTS; j++) {
-                PositionDescriptionMap::const_iterator tmp = ps.find(int_pos[i]);
-                first_pos = std::min(first_pos, int_pos[i]);
-                last_pos = std::max(last_pos, int_pos[i]);
-                if (tmp != ps.end()) {
-                    if (tmp->second.votes[j] !=0) {
-                        positions[int_pos[i]] = j;
-                        break;
-                    }
+                if (ps.at(int_pos[i]).votes[j] != 0) {
+                    positions.emplace_back(int_pos[i], j);
+                    break;
                 }
             }
         }
+        VERIFY(std::is_sorted(positions.begin(), positions.end()));
         non_interesting_error_num = 0;
-        for (const auto &position: ps) {
-            if (positions.find(position.first) == positions.end()) {
-                if (position.second.FoundOptimal(contig[position.first]) != (size_t)var_to_pos[(size_t)contig[position.first]]) {
+        ps.ForEach([&](size_t pos, const position_description &desc) {
+            if (!has_variant(pos)) {
+                if (desc.FoundOptimal(contig[pos]) != (size_t)var_to_pos[(size_t)contig[pos]]) {
                     non_interesting_error_num++;
                 }
             }
-        }
+        });
         error_num = 0;
         processed_positions = 0;
     }
+
+    bool has_variant(size_t pos) const {
+        auto it = std::lower_bound(positions.begin(), positions.end(), std::make_pair(pos, size_t(0)));
+        return it != positions.end() && it->first == pos;
+    }
+
+    // Variant of the read at the interesting position, 0 if the read does not vote there
+    size_t variant(size_t pos) const {
+        auto it = std::lower_bound(positions.begin(), positions.end(), std::make_pair(pos, size_t(0)));
+        return it != positions.end() && it->first == pos ? it->second : 0;
+    }
+
     inline bool is_first(size_t i, int dir) const{
         if ((dir == 1 && i == first_pos) || (dir == -1 && i == last_pos))
             return true;
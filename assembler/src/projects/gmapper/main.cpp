@@ -121,7 +121,8 @@ static void ProcessSingleReads(GraphPack &gp, DataSet &dataset,
 
     auto mapper_ptr = ChooseProperMapper(gp, lib);
     if (use_binary) {
-        auto single_streams = single_binary_readers(lib, false, map_paired);
+        auto single_streams = single_binary_readers(lib, false, map_paired,
+                                                    SequenceMapperNotifier::STREAM_SPLIT_FACTOR);
         notifier.ProcessLibrary(single_streams, ilib, *mapper_ptr);
     } else {
         auto single_streams = single_easy_readers(lib, false,
@@ -15,6 +15,7 @@
 #include "config_struct_hammer.hpp"
 #include "pipeline/config_common.hpp"
 #include "utils/parallel/openmp_wrapper.h"
+#include "utils/logger/logger.hpp"
 
 #include <boost/property_tree/ptree.hpp>
 #include <string>
@@ -34,6 +35,9 @@ void load(hammer_config& cfg, boost::property_tree::ptree const& pt) {
   load(cfg.general_tau, pt, "general_tau");
   load(cfg.general_max_iterations, pt, "general_max_iterations");
   load(cfg.general_debug, pt, "general_debug");
+  cfg.general_numa_policy = config_common::ModeByName<utils::NumaPolicy>(pt.get("general_numa_policy", "none"),
+                                                                        utils::numa_policy_names());
+  cfg.general_pin_threads = pt.get("general_pin_threads", false);
 
   load(cfg.count_do, pt, "count_do");
   load(cfg.count_numfiles, pt, "count_numfiles");
@@ -18,6 +18,7 @@
 #include "pipeline/config_singl.hpp"
 
 #include "pipeline/library.hpp"
+#include "utils/parallel/numa.hpp"
 
 #include <boost/optional.hpp>
 #include <boost/property_tree/ptree_fwd.hpp>
@@ -42,6 +43,8 @@ struct hammer_config {
   int general_tau;
   unsigned general_max_iterations;
   bool general_debug;
+  utils::NumaPolicy general_numa_policy;
+  bool general_pin_threads;
 
   bool count_do;
   unsigned count_numfiles;
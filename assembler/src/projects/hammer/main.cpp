@@ -80,6 +80,9 @@ int main(int argc, char * argv[]) {
     // hard memory limit
     const size_t GB = 1 << 30;
     utils::limit_memory(cfg::get().general_hard_memory_limit * GB);
+    if (cfg::get().general_pin_threads)
+      utils::pin_omp_threads(cfg::get().general_max_nthreads);
+    utils::set_numa_policy(cfg::get().general_numa_policy);
 
     // determine quality offset if not specified
     if (!cfg::get().input_qvoffset_opt) {
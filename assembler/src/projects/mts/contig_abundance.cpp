@@ -2,16 +2,62 @@
 #include "utils/kmer_mph/kmer_splitters.hpp"
 #include "common/math/xmath.h"
 
+#include <sys/mman.h>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <new>
+
 namespace debruijn_graph {
 
-MplVector SampleMpls(const KmerProfiles& kmer_mpls, size_t sample) {
-    MplVector answer;
-    answer.reserve(kmer_mpls.size());
-    for (const auto& kmer_mpl : kmer_mpls) {
-        answer.push_back(kmer_mpl[sample]);
+// Profiles of the k-mers transposed into a dense matrix with a contiguous column per sample.
+// Columns start at cache line boundaries, so that a column never shares a line with its
+// neighbours. K-mers are processed in blocks, so that the profiles of the block stay in cache
+// while being spread over the columns.
+class SampleColumns {
+    static const size_t CACHE_LINE = 64;
+
+    struct Deleter {
+        void operator()(Mpl *data) const {
+            free(data);
+        }
+    };
+
+    static Mpl *Allocate(size_t size) {
+        void *data = nullptr;
+        if (posix_memalign(&data, CACHE_LINE, std::max<size_t>(size, 1) * sizeof(Mpl)))
+            throw std::bad_alloc();
+        return static_cast<Mpl*>(data);
     }
-    return answer;
-}
+
+public:
+    SampleColumns(const KmerProfiles& kmer_mpls, size_t sample_cnt)
+            : rows_(kmer_mpls.size()),
+              stride_((rows_ * sizeof(Mpl) + CACHE_LINE - 1) / CACHE_LINE * CACHE_LINE / sizeof(Mpl)),
+              data_(Allocate(stride_ * sample_cnt)) {
+        const size_t BLOCK_SIZE = 64;
+        for (size_t block = 0; block < rows_; block += BLOCK_SIZE) {
+            size_t block_end = std::min(rows_, block + BLOCK_SIZE);
+            for (size_t i = 0; i < sample_cnt; ++i) {
+                Mpl *column = data_.get() + i * stride_;
+                for (size_t j = block; j < block_end; ++j)
+                    column[j] = kmer_mpls[j].begin()[i];
+            }
+        }
+    }
+
+    MplVector column(size_t i) const {
+        const Mpl *begin = data_.get() + i * stride_;
+        return MplVector(begin, begin + rows_);
+    }
+
+private:
+    size_t rows_;
+    // Column length rounded up to whole cache lines
+    size_t stride_;
+    std::unique_ptr<Mpl, Deleter> data_;
+};
 
 //------------------------------------------------------------------------------
 
@@ -53,8 +99,10 @@ Abundance WinsoredMeanImpl(MplVector &v) {
         v[v.size() - i - 1] = v[v.size() - offset - 1];
     }
     size_t sum = 0;
-    for (Mpl i: v)
-        sum += i;
+    const Mpl *data = v.data();
+#   pragma omp simd reduction(+:sum)
+    for (size_t i = 0; i < v.size(); ++i)
+        sum += data[i];
     return (Abundance)sum / (Abundance)v.size();
 }
 
@@ -65,8 +113,10 @@ Abundance WinsoredMean(MplVector &&v) {
 
 Var Variance(const MplVector &v, Abundance mean) {
     size_t sum = 0;
-    for (Mpl i: v)
-        sum += (i * i);
+    const Mpl *data = v.data();
+#   pragma omp simd reduction(+:sum)
+    for (size_t i = 0; i < v.size(); ++i)
+        sum += size_t(data[i]) * data[i];
     return (Abundance)sum / (Abundance)v.size() - mean * mean;
 }
 
@@ -89,12 +139,13 @@ template<typename T> using PointEstimator = std::function<T(MplVector &&)>;
 template<typename T>
 Profile<T> CountProfile(const KmerProfiles& kmer_mpls, PointEstimator<T> point_estimator) {
     VERIFY(kmer_mpls.size() != 0);
+    size_t sample_cnt = KmerProfileIndex::SampleCount();
+    SampleColumns columns(kmer_mpls, sample_cnt);
     std::vector<T> res;
-    res.reserve(KmerProfileIndex::SampleCount());
-    for (size_t i = 0; i < KmerProfileIndex::SampleCount(); ++i) {
-        auto sample_mpls = SampleMpls(kmer_mpls, i);
-        res.push_back(point_estimator(std::move(sample_mpls)));
-        TRACE(sample_mpls << ": " << res.back());
+    res.reserve(sample_cnt);
+    for (size_t i = 0; i < sample_cnt; ++i) {
+        res.push_back(point_estimator(columns.column(i)));
+        TRACE("Sample " << i << ": " << res.back());
     }
     return res;
 }
@@ -198,11 +249,16 @@ KmerProfileIndex::KmerProfileIndex(unsigned k,
     std::string profiles_file = index_prefix + ".bpr";
     INFO("Loading profiles data of " << data_size << " elements from " << profiles_file);
     profiles_ = ProfilesT(profiles_file, data_size, false);
-    //Prefetch mmapped data by force
-    Mpl checksum = 0;
-    for (const Mpl* ptr = profiles_->data(); ptr < profiles_->data() + data_size; ptr += 4096 / sizeof(Mpl))
-        checksum = Mpl(checksum + *ptr);
-    INFO("Kmer index loaded; checksum: " << checksum);
+    // Profiles are only mapped: the pages come from the page cache, which is shared by all the processes
+    // using the same index. The kernel is asked to read them ahead instead of touching every page here.
+    // The accesses are hash-ordered, so no sequential readahead is wanted later on.
+    if (data_size) {
+        void *data = (void *) profiles_->data();
+        size_t bytes = profiles_->data_size();
+        if (madvise(data, bytes, MADV_WILLNEED) || madvise(data, bytes, MADV_RANDOM))
+            WARN("madvise(2) failed for " << profiles_file << ": " << strerror(errno));
+    }
+    INFO("Kmer index loaded");
 }
 
 KmerProfileIndex::KmerProfileIndex(KmerProfileIndex&& other):
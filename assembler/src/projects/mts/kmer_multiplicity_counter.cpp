@@ -6,14 +6,17 @@
 #include <iostream>
 #include <memory>
 #include <algorithm>
+#include <mutex>
+#include <condition_variable>
 #include <libcxx/sort.hpp>
-#include <boost/optional/optional.hpp>
 #include "getopt_pp/getopt_pp.h"
 #include "kmc_api/kmc_file.h"
-//#include "omp.h"
+#include "adt/loser_tree.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 #include "io/kmers/mmapped_reader.hpp"
 #include "utils/filesystem/path_helper.hpp"
 #include "utils/stl_utils.hpp"
+#include "utils/memory_limit.hpp"
 #include "utils/ph_map/perfect_hash_map_builder.hpp"
 #include "utils/ph_map/storing_traits.hpp"
 #include "utils/kmer_mph/kmer_splitters.hpp"
@@ -25,20 +28,63 @@ using std::vector;
 const string KMER_PARSED_EXTENSION = ".bin";
 const string KMER_SORTED_EXTENSION = ".sorted";
 
+// Sorting a sample maps its whole parsed file into memory. The gate lets several samples be sorted
+// at the same time only while their files fit into the memory budget together; a sample larger
+// than the budget is sorted alone.
+class SortMemoryGate {
+    std::mutex lock_;
+    std::condition_variable released_;
+    size_t budget_;
+    size_t in_use_ = 0;
+
+public:
+    explicit SortMemoryGate(size_t budget) : budget_(budget) {}
+
+    void Acquire(size_t size) {
+        std::unique_lock<std::mutex> lock(lock_);
+        released_.wait(lock, [&] { return in_use_ == 0 || in_use_ + size <= budget_; });
+        in_use_ += size;
+    }
+
+    void Release(size_t size) {
+        {
+            std::lock_guard<std::mutex> lock(lock_);
+            in_use_ -= size;
+        }
+        released_.notify_all();
+    }
+};
+
 class KmerMultiplicityCounter {
+    typedef uint16_t Mpl;
+    typedef MMappedRecordArrayReader<seq_element_type> RecordReader;
+    typedef RecordReader::iterator RecordIterator;
+
     size_t k_ ;
     std::string file_prefix_;
 
+    // Random access to the symbols of the KMC k-mer as digits, so that RtSeq is built without strings
+    class KmcSymbols {
+        CKmerAPI &kmer_;
+        size_t k_;
+
+    public:
+        KmcSymbols(CKmerAPI &kmer, size_t k) : kmer_(kmer), k_(k) {}
+        char operator[](size_t i) const { return (char) kmer_.get_num_symbol((unsigned) i); }
+        size_t size() const { return k_; }
+    };
+
     //TODO: get rid of intermediate .bin file
     string ParseKmc(const string& filename) {
         CKMCFile kmcFile;
         kmcFile.OpenForListing(filename);
         CKmerAPI kmer((unsigned int) k_);
+        KmcSymbols symbols(kmer, k_);
         uint32 count;
         std::string parsed_filename = filename + KMER_PARSED_EXTENSION;
         std::ofstream output(parsed_filename, std::ios::binary);
         while (kmcFile.ReadNextKmer(kmer, count)) {
-            RtSeq seq(k_, kmer.to_string());
+            RtSeq seq(k_, symbols);
             seq.BinWrite(output);
             seq_element_type tmp = count;
             output.write((char*) &(tmp), sizeof(seq_element_type));
@@ -58,82 +104,105 @@ class KmerMultiplicityCounter {
         return sorted_filename;
     }
 
-    bool ReadKmerWithCount(std::ifstream& infile, std::pair<RtSeq, uint32>& res) {
-        RtSeq seq(res.first.size());
-        if (!seq.BinRead(infile)) {
-            return false;
+    // Writes the k-mers present in enough samples together with their profiles
+    void MergeKmers(const std::vector<adt::iterator_range<RecordIterator>> &runs,
+                    std::ostream &kmers_out, std::ostream &mpls_out,
+                    size_t all_min, size_t min_mult) const {
+        size_t n = runs.size(), data_size = RtSeq::GetDataSize(k_);
+        adt::loser_tree<RecordIterator, adt::array_less<seq_element_type>> tree(runs);
+        std::vector<seq_element_type> kmer(data_size);
+        std::vector<Mpl> mpls(n);
+        while (!tree.empty()) {
+            std::copy_n(tree.top().data(), data_size, kmer.begin());
+            std::fill(mpls.begin(), mpls.end(), 0);
+            size_t cnt_min = 0, total_cnt = 0;
+            // Records of the same k-mer from different samples are adjacent in the merged order
+            do {
+                uint32 cnt = (uint32) tree.top().data()[data_size];
+                mpls[tree.top_run()] = Mpl(cnt);
+                total_cnt += cnt;
+                ++cnt_min;
+                tree.replay();
+            } while (!tree.empty() && std::equal(kmer.begin(), kmer.end(), tree.top().data()));
+
+            if (cnt_min >= all_min && (cnt_min > 1 || total_cnt > min_mult)) {
+                kmers_out.write((const char *) kmer.data(), data_size * sizeof(seq_element_type));
+                mpls_out.write((const char *) mpls.data(), n * sizeof(Mpl));
+            }
         }
-        seq_element_type tmp;
-        infile.read((char*) &tmp, sizeof(seq_element_type));
-        res = {seq, (uint32) tmp};
-        return true;
     }
 
     fs::TmpFile FilterCombinedKmers(fs::TmpDir workdir, const std::vector<string>& files,
-                                    size_t all_min, size_t min_mult) {
+                                    size_t all_min, size_t min_mult, size_t nthreads) {
         size_t n = files.size();
-        vector<std::unique_ptr<ifstream>> infiles;
-        infiles.reserve(n);
-        for (auto fn : files) {
-            INFO("Processing " << fn);
-            auto parsed = ParseKmc(fn);
-            auto sorted = SortKmersCountFile(parsed);
-            infiles.emplace_back(new std::ifstream(sorted));
+        vector<string> sorted(n);
+        // Peak memory here is the total size of the parsed files being sorted at the same time:
+        // up to nthreads of them, but no more than the free memory unless a single file exceeds it
+        SortMemoryGate sort_gate(utils::get_free_memory());
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic, 1)
+        for (size_t i = 0; i < n; ++i) {
+            INFO("Processing " << files[i]);
+            string parsed = ParseKmc(files[i]);
+            size_t parsed_size = fs::filesize(parsed);
+            sort_gate.Acquire(parsed_size);
+            sorted[i] = SortKmersCountFile(parsed);
+            sort_gate.Release(parsed_size);
         }
-        vector<std::pair<RtSeq, uint32>> top_kmer(n, {RtSeq(k_), 0});
-        vector<bool> alive(n, false);
 
-        for (size_t i = 0; i < n; i++) {
-            alive[i] = ReadKmerWithCount(*infiles[i], top_kmer[i]);
+        size_t record_size = RtSeq::GetDataSize(k_) + 1;
+        vector<std::unique_ptr<RecordReader>> readers;
+        size_t largest = 0;
+        for (size_t i = 0; i < n; ++i) {
+            readers.emplace_back(new RecordReader(sorted[i], record_size, false));
+            if (readers[i]->size() > readers[largest]->size())
+                largest = i;
         }
 
-        auto kmer_file = fs::tmp::make_temp_file("kmer", workdir);
+        // K-mers are split into ranges by the first word of their data, the ranges are merged
+        // independently and the results are concatenated. Range bounds are the quantiles of the
+        // largest sample.
+        size_t largest_size = readers[largest]->size();
+        size_t parts = largest_size ? nthreads * 4 : 1;
+        std::vector<seq_element_type> bounds;
+        for (size_t p = 1; p < parts; ++p)
+            bounds.push_back((*std::next(readers[largest]->begin(), largest_size * p / parts)).data()[0]);
 
-        typedef uint16_t Mpl;
+        auto first_word_less = [](const auto &r, seq_element_type w) {
+            return r.data()[0] < w;
+        };
+        std::vector<std::vector<adt::iterator_range<RecordIterator>>> part_runs(parts);
+        for (const auto &reader : readers) {
+            RecordIterator begin = reader->begin();
+            for (size_t p = 0; p < parts; ++p) {
+                RecordIterator end = p + 1 < parts ?
+                                     std::lower_bound(begin, reader->end(), bounds[p], first_word_less) :
+                                     reader->end();
+                part_runs[p].push_back(adt::make_range(begin, end));
+                begin = end;
+            }
+        }
+
+        std::vector<fs::TmpFile> part_kmers(parts), part_mpls(parts);
+        for (size_t p = 0; p < parts; ++p) {
+            part_kmers[p] = fs::tmp::make_temp_file("kmer_part", workdir);
+            part_mpls[p] = fs::tmp::make_temp_file("mpl_part", workdir);
+        }
+#       pragma omp parallel for num_threads(nthreads) schedule(dynamic, 1)
+        for (size_t p = 0; p < parts; ++p) {
+            std::ofstream kmers_out(*part_kmers[p], std::ios::binary);
+            std::ofstream mpls_out(*part_mpls[p], std::ios::binary);
+            MergeKmers(part_runs[p], kmers_out, mpls_out, all_min, min_mult);
+        }
+
+        auto kmer_file = fs::tmp::make_temp_file("kmer", workdir);
         std::ofstream output_kmer(*kmer_file, std::ios::binary);
         std::ofstream mpl_file(file_prefix_ + ".bpr", std::ios_base::binary);
-
-        RtSeq::less3 kmer_less;
-        while (true) {
-            boost::optional<RtSeq> min_kmer;
-            size_t cnt_min = 0, num_samples = 0;
-            for (size_t i = 0; i < n; ++i) {
-                if (alive[i]) {
-                    RtSeq& cur_kmer = top_kmer[i].first;
-                    if (!min_kmer || kmer_less(cur_kmer, *min_kmer)) {
-                        min_kmer = cur_kmer;
-                        cnt_min = 0;
-                    }
-                    if (cur_kmer == *min_kmer) {
-                        ++cnt_min;
-                    }
-                }
-            }
-            if (!min_kmer) {
-                break;
-            }
-            if (cnt_min >= all_min) {
-                std::vector<uint32> cnt_vector(n, 0);
-                size_t total_cnt = 0;
-                for (size_t i = 0; i < n; ++i) {
-                    if (alive[i] && top_kmer[i].first == *min_kmer) {
-                        auto cnt = top_kmer[i].second;
-                        cnt_vector[i] = cnt;
-                        total_cnt += cnt;
-                    }
-                }
-                if (cnt_min > 1 || total_cnt > min_mult) {
-                    min_kmer.get().BinWrite(output_kmer);
-                    for (size_t mpl : cnt_vector) {
-                        mpl_file.write(reinterpret_cast<char *>(&mpl), sizeof(Mpl));
-                    }
-                }
-            }
-            for (size_t i = 0; i < n; ++i) {
-                if (alive[i] && top_kmer[i].first == *min_kmer) {
-                    alive[i] = ReadKmerWithCount(*infiles[i], top_kmer[i]);
-                }
-            }
+        for (size_t p = 0; p < parts; ++p) {
+            std::ifstream kmers_in(*part_kmers[p], std::ios::binary), mpls_in(*part_mpls[p], std::ios::binary);
+            if (kmers_in.peek() == std::ifstream::traits_type::eof())
+                continue;
+            output_kmer << kmers_in.rdbuf();
+            mpl_file << mpls_in.rdbuf();
         }
         return kmer_file;
     }
@@ -188,7 +257,7 @@ public:
     void CombineMultiplicities(const vector<string>& input_files, size_t min_samples,
                                size_t min_mult, const string& tmpdir, size_t nthreads = 1) {
         auto workdir = fs::tmp::make_temp_dir(tmpdir, "kmidx");
-        auto kmer_file = FilterCombinedKmers(workdir, input_files, min_samples, min_mult);
+        auto kmer_file = FilterCombinedKmers(workdir, input_files, min_samples, min_mult, nthreads);
         BuildKmerIndex(workdir, kmer_file, input_files.size(), nthreads);
     }
 private:
@@ -202,6 +271,7 @@ void PrintUsageInfo() {
     std::cout << "-n - sample count" << std::endl;
     std::cout << "-o - output file prefix" << std::endl;
     std::cout << "-t - number of threads (default: 1)" << std::endl;
+    std::cout << "-M - memory limit in Gb (default: not limited)" << std::endl;
     std::cout << "-s - minimal number of samples to contain kmer" << std::endl;
     std::cout << "-m - minimal multiplicity of single-sample kmers" << std::endl;
     std::cout << "files_dir must contain two files (.kmc_pre and .kmc_suf) with kmer multiplicities for each sample from 1 to n" << std::endl;
@@ -211,7 +281,7 @@ int main(int argc, char *argv[]) {
     using namespace GetOpt;
     create_console_logger();
 
-    size_t k, sample_cnt, min_samples, min_mult, nthreads;
+    size_t k, sample_cnt, min_samples, min_mult, nthreads, memory;
     string output, work_dir;
 
     try {
@@ -223,6 +293,7 @@ int main(int argc, char *argv[]) {
             >> Option('s', min_samples)
             >> Option('o', output)
             >> Option('t', "threads", nthreads, size_t(1))
+            >> Option('M', "memory", memory, size_t(0))
             >> Option('f', work_dir)
         ;
     } catch(GetOptEx &ex) {
@@ -235,6 +306,9 @@ int main(int argc, char *argv[]) {
         input_files.push_back(work_dir + "/sample" + std::to_string(i));
     }
 
+    if (memory)
+        utils::limit_memory(memory << 30);
+
     KmerMultiplicityCounter kmcounter(k, output);
     kmcounter.CombineMultiplicities(input_files, min_samples, min_mult, work_dir, nthreads);
     return 0;
@@ -22,6 +22,7 @@
 
 #include <boost/algorithm/string.hpp>
 
+#include <memory>
 #include <string>
 #include <vector>
 
@@ -32,14 +33,33 @@ extern "C" {
 
 namespace nrps {
 
-static void match_contigs_internal(hmmer::HMMMatcher &matcher, const path_extend::BidirectionalPath &path,
-                                   const std::string &path_string,
+// Scaffold sequence together with its translations in three frames
+struct TranslatedScaffold {
+    const path_extend::BidirectionalPath *path;
+    std::string seq;
+    std::string frames[3];
+
+    TranslatedScaffold(const path_extend::BidirectionalPath &p, std::string s)
+            : path(&p), seq(std::move(s)) {
+        for (size_t shift = 0; shift < 3; ++shift)
+            frames[shift] = aa::translate(seq.c_str() + shift);
+    }
+};
+
+// Matches of a single HMM within a block of scaffolds
+struct MatchResult {
+    ContigAlnInfo alns;
+    std::vector<std::pair<std::string, const std::string*>> contigs;
+};
+
+static void match_contigs_internal(hmmer::HMMMatcher &matcher, const TranslatedScaffold &scaffold,
                                    const std::string &type, const std::string &desc,
-                                   ContigAlnInfo &res, io::OFastaReadStream &oss_contig, size_t model_length) {
+                                   MatchResult &res, size_t model_length) {
+    const path_extend::BidirectionalPath &path = *scaffold.path;
+    const std::string &path_string = scaffold.seq;
     for (size_t shift = 0; shift < 3; ++shift) {
         std::string ref_shift = std::to_string(path.GetId()) + "_" + std::to_string(shift);
-        std::string seq_aas = aa::translate(path_string.c_str() + shift);
-        matcher.match(ref_shift.c_str(), seq_aas.c_str());
+        matcher.match(ref_shift.c_str(), scaffold.frames[shift].c_str());
     }
     matcher.summarize();
 
@@ -61,48 +81,69 @@ static void match_contigs_internal(hmmer::HMMMatcher &matcher, const path_extend
             seqpos.second = seqpos.second * 3  + shift;
 
             std::string name(hit.name());
-#pragma omp critical
-            {
-                oss_contig << io::SingleRead(name, path_string);
-            }
+            res.contigs.emplace_back(name, &path_string);
             DEBUG(name);
             DEBUG("First - " << seqpos.first << ", second - " << seqpos.second);
-            res.push_back({name, type, desc,
-                           unsigned(seqpos.first), unsigned(seqpos.second),
-                           path_string.substr(seqpos.first, std::max(seqpos.second - seqpos.first, (int)path.g().k() + 1))});
+            res.alns.push_back({name, type, desc,
+                                unsigned(seqpos.first), unsigned(seqpos.second),
+                                path_string.substr(seqpos.first, std::max(seqpos.second - seqpos.first, (int)path.g().k() + 1))});
         }
     }
     matcher.reset_top_hits();
 }
 
-static void match_contigs(const path_extend::PathContainer &contig_paths, const path_extend::ScaffoldSequenceMaker &scaffold_maker,
+static void match_contigs(const std::vector<TranslatedScaffold> &scaffolds, size_t begin, size_t end,
                           const hmmer::HMM &hmm, const hmmer::hmmer_cfg &cfg,
-                          ContigAlnInfo &res, io::OFastaReadStream &oss_contig) {
-    DEBUG("Total contigs: " << contig_paths.size());
+                          MatchResult &res) {
+    DEBUG("Total contigs: " << end - begin);
     DEBUG("Model length - " << hmm.length());
     hmmer::HMMMatcher matcher(hmm, cfg);
+    for (size_t i = begin; i < end; ++i)
+        match_contigs_internal(matcher, scaffolds[i],
+                               hmm.name(), hmm.desc() ? hmm.desc() : "",
+                               res, hmm.length());
+}
+
+// Sequences of the scaffolds and their conjugates in the order they are matched
+static std::vector<TranslatedScaffold> TranslateScaffolds(const path_extend::PathContainer &contig_paths,
+                                                          const path_extend::ScaffoldSequenceMaker &scaffold_maker) {
+    std::vector<const path_extend::BidirectionalPath*> paths;
     for (auto iter = contig_paths.begin(); iter != contig_paths.end(); ++iter) {
-        const path_extend::BidirectionalPath &path = iter.get();
-        if (path.Length() <= 0)
+        if (iter.get().Length() <= 0)
             continue;
+        paths.push_back(&iter.get());
+        if (iter.getConjugate().Length() > 0)
+            paths.push_back(&iter.getConjugate());
+    }
 
-        std::string path_string = scaffold_maker.MakeSequence(path);
-        match_contigs_internal(matcher, path, path_string,
-                               hmm.name(), hmm.desc() ? hmm.desc() : "",
-                               res, oss_contig, hmm.length());
+    std::vector<std::unique_ptr<TranslatedScaffold>> translated(paths.size());
+#   pragma omp parallel for schedule(dynamic)
+    for (size_t i = 0; i < paths.size(); ++i)
+        translated[i].reset(new TranslatedScaffold(*paths[i], scaffold_maker.MakeSequence(*paths[i])));
 
-        const path_extend::BidirectionalPath& conj_path = iter.getConjugate();
-        if (conj_path.Length() <= 0)
-            continue;
+    std::vector<TranslatedScaffold> res;
+    res.reserve(paths.size());
+    for (auto &scaffold : translated)
+        res.push_back(std::move(*scaffold));
+    return res;
+}
 
-        std::string path_string_conj = scaffold_maker.MakeSequence(conj_path);
-        match_contigs_internal(matcher, conj_path, path_string_conj,
-                               hmm.name(), hmm.desc() ? hmm.desc() : "",
-                               res, oss_contig, hmm.length());
+// Splits scaffolds into consecutive blocks of roughly the same total length.
+// Blocks do not depend on the number of threads, so the matches do not either.
+static std::vector<size_t> ScaffoldBlocks(const std::vector<TranslatedScaffold> &scaffolds) {
+    const size_t BLOCK_LENGTH = 256 * 1024;
+    std::vector<size_t> bounds = { 0 };
+    size_t length = 0;
+    for (size_t i = 0; i < scaffolds.size(); ++i) {
+        length += scaffolds[i].seq.size();
+        if (length >= BLOCK_LENGTH || i + 1 == scaffolds.size()) {
+            bounds.push_back(i + 1);
+            length = 0;
+        }
     }
+    return bounds;
 }
 
-
 static void ParseHMMFile(std::vector<hmmer::HMM> &hmms, const std::string &filename) {
     auto hmmfile = hmmer::open_file(filename);
     if (std::error_code ec = hmmfile.getError()) {
@@ -184,24 +225,31 @@ ContigAlnInfo DomainMatcher::MatchDomains(debruijn_graph::GraphPack &gp,
     // Setup E-value search space size
     hcfg.Z = 3 * broken_scaffolds.size();
 
-#   pragma omp parallel for
-    for (size_t i = 0; i < hmms.size(); ++i) {
-        ContigAlnInfo local_res;
-        std::string name = hmms[i].name();
-#       pragma omp critical
-        {
-            INFO("Matching contigs with " << name);
-        }
-
-        match_contigs(broken_scaffolds, scaffold_maker,
-                      hmms[i], hcfg,
-                      local_res, oss_contig);
+    std::vector<TranslatedScaffold> scaffolds = TranslateScaffolds(broken_scaffolds, scaffold_maker);
+    std::vector<size_t> blocks = ScaffoldBlocks(scaffolds);
+    size_t nblocks = blocks.size() - 1;
+    INFO("Matching " << hmms.size() << " HMMs against " << scaffolds.size() << " scaffolds in " << nblocks << " blocks");
+
+    // Every (HMM, scaffold block) pair is a separate task, the results are merged in the task order
+    std::vector<MatchResult> results(hmms.size() * nblocks);
+#   pragma omp parallel for schedule(dynamic)
+    for (size_t task = 0; task < results.size(); ++task) {
+        size_t i = task / nblocks, block = task % nblocks;
+        match_contigs(scaffolds, blocks[block], blocks[block + 1],
+                      hmms[i], hcfg, results[task]);
+    }
 
-#       pragma omp critical
-        {
-            INFO("Matches for '" << name << "': " << local_res.size());
-            res.insert(res.end(), std::make_move_iterator(local_res.begin()), std::make_move_iterator(local_res.end()));
+    for (size_t i = 0; i < hmms.size(); ++i) {
+        size_t matches = 0;
+        for (size_t block = 0; block < nblocks; ++block) {
+            MatchResult &local_res = results[i * nblocks + block];
+            for (const auto &contig : local_res.contigs)
+                oss_contig << io::SingleRead(contig.first, *contig.second);
+            matches += local_res.alns.size();
+            res.insert(res.end(), std::make_move_iterator(local_res.alns.begin()), std::make_move_iterator(local_res.alns.end()));
+            local_res = MatchResult();
         }
+        INFO("Matches for '" << hmms[i].name() << "': " << matches);
     }
 
     INFO("Total domain matches: " << res.size());
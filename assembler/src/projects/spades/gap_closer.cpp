@@ -446,7 +446,8 @@ void GapClosing::run(GraphPack &gp, const char *) {
             continue;
 
         notifier.Subscribe(i, &gcpif);
-        io::BinaryPairedStreams paired_streams = paired_binary_readers(dataset.reads[i], false, 0, false);
+        io::BinaryPairedStreams paired_streams = paired_binary_readers(dataset.reads[i], false, 0, false,
+                                                                       SequenceMapperNotifier::STREAM_SPLIT_FACTOR);
         notifier.ProcessLibrary(paired_streams, i, *gcpif.GetMapper());
 
         INFO("Initializing gap closer");
@@ -102,6 +102,9 @@ int main(int argc, char **argv) {
         VERIFY(cfg::get().K % 2 != 0);
 
         utils::limit_memory(cfg::get().max_memory * GB);
+        if (cfg::get().pin_threads)
+            utils::pin_omp_threads(cfg::get().max_threads);
+        utils::set_numa_policy(cfg::get().numa_policy);
 
         // assemble it!
         START_BANNER("SPAdes");
@@ -114,6 +117,9 @@ int main(int argc, char **argv) {
                                                cfg::get().tt.granularity,
                                                cfg::get().output_dir, std::to_string(cfg::get().K)));
             INFO("Time tracing is enabled");
+            if (cfg::get().tt.per_thread)
+                utils::trace::enable(cfg::get().output_dir + "spades_thread_trace_" + std::to_string(cfg::get().K) + "_",
+                                     cfg::get().tt.per_thread_buffer);
         }
 
         TIME_TRACE_SCOPE("spades");
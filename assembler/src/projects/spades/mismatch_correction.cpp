@@ -411,7 +411,8 @@ private:
 
             notifier.Subscribe(i, &statistics);
             auto &reads = cfg::get_writable().ds.reads[i];
-            auto single_streams = single_binary_readers(reads, /*followed by rc */true, /*binary*/true);
+            auto single_streams = single_binary_readers(reads, /*followed by rc */true, /*binary*/true,
+                                                        SequenceMapperNotifier::STREAM_SPLIT_FACTOR);
             notifier.ProcessLibrary(single_streams, i, *mapper);
         }
 
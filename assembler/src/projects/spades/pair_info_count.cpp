@@ -210,7 +210,7 @@ bool CollectLibInformation(const GraphPack &gp,
     SequencingLib &reads = cfg::get_writable().ds.reads[ilib];
     auto &data = reads.data();
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, /*insert_size*/0,
-                                                /*include_merged*/true);
+                                                /*include_merged*/true, SequenceMapperNotifier::STREAM_SPLIT_FACTOR);
 
     notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
     //Check read length after lib processing since mate pairs a not used until this step
@@ -270,7 +270,8 @@ size_t ProcessSingleReads(GraphPack &gp, size_t ilib,
 
     auto mapper_ptr = ChooseProperMapper(gp, reads);
     if (use_binary) {
-        auto single_streams = single_binary_readers(reads, false, map_paired);
+        auto single_streams = single_binary_readers(reads, false, map_paired,
+                                                    SequenceMapperNotifier::STREAM_SPLIT_FACTOR);
         notifier.ProcessLibrary(single_streams, ilib, *mapper_ptr);
     } else {
         auto single_streams = single_easy_readers(reads, false,
@@ -319,7 +320,7 @@ void ProcessPairedReads(GraphPack &gp,
     notifier.Subscribe(ilib, &pif);
 
     auto paired_streams = paired_binary_readers(reads, /*followed by rc*/false, (size_t) data.mean_insert_size,
-                                                /*include merged*/true);
+                                                /*include merged*/true, SequenceMapperNotifier::STREAM_SPLIT_FACTOR);
     notifier.ProcessLibrary(paired_streams, ilib, *ChooseProperMapper(gp, reads));
 }
 
@@ -394,7 +395,8 @@ void PairInfoCount::run(GraphPack &gp, const char *) {
                         notifier.Subscribe(i, &filter_counter);
 
                         VERIFY(lib.data().unmerged_read_length != 0);
-                        auto reads = paired_binary_readers(lib, /*followed by rc*/false, 0, /*include merged*/true);
+                        auto reads = paired_binary_readers(lib, /*followed by rc*/false, 0, /*include merged*/true,
+                                                           SequenceMapperNotifier::STREAM_SPLIT_FACTOR);
                         notifier.ProcessLibrary(reads, i, *ChooseProperMapper(gp, lib));
                     }
                 }
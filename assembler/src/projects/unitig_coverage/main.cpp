@@ -7,8 +7,10 @@
 
 #include "profile_storage.hpp"
 #include "io/dataset_support/dataset_readers.hpp"
+#include "io/dataset_support/read_converter.hpp"
 #include "modules/alignment/kmer_mapper.hpp"
 #include "modules/alignment/sequence_mapper.hpp"
+#include "modules/alignment/sequence_mapper_notifier.hpp"
 
 #include "projects/mts/contig_abundance.hpp"
 #include "toolchain/edge_label_helper.hpp"
@@ -32,25 +34,9 @@ using namespace debruijn_graph;
 typedef io::DataSet<config::LibraryData> DataSet;
 typedef io::SequencingLibrary<config::LibraryData> SequencingLib;
 
-static io::ReadStreamList<io::SingleRead>
-single_easy_readers_for_libs(DataSet& dataset_info,
-                             const std::vector<size_t>& libs,
-                             bool followed_by_rc = true,
-                             bool including_paired_reads = true,
-                             bool handle_Ns = true,
-                             io::OffsetType offset_type = io::PhredOffset) {
-    VERIFY(!libs.empty());
-    io::ReadStreamList<io::SingleRead> streams;
-    for (auto l_id : libs) {
-        streams.push_back(io::single_easy_reader(dataset_info[l_id],
-                                             followed_by_rc,
-                                             including_paired_reads, handle_Ns, offset_type));
-    }
-    return streams;
-}
-
 static void Run(const std::string &graph_path, const std::string &dataset_desc, size_t K,
-         const std::string &profiles_fn, size_t nthreads, const std::string &tmpdir) {
+         const std::string &profiles_fn, size_t nthreads, const std::string &tmpdir,
+         size_t minimizer_window) {
     DataSet dataset;
     dataset.load(dataset_desc);
 
@@ -65,18 +51,32 @@ static void Run(const std::string &graph_path, const std::string &dataset_desc,
 
     config::init_libs(dataset, nthreads, tmpdir);
 
-    gp.EnsureBasicMapping();
-
-    std::vector<size_t> libs(dataset.lib_count());
-    std::iota(libs.begin(), libs.end(), 0);
+    // Minimizer index replaces the full k-mer one to save memory
+    std::unique_ptr<MinimizerEdgeIndex<Graph>> sparse_index;
+    if (minimizer_window) {
+        sparse_index.reset(new MinimizerEdgeIndex<Graph>(graph, minimizer_window));
+        sparse_index->Refill();
+        gp.get_mutable<KmerMapper<Graph>>().Normalize();
+    } else {
+        gp.EnsureBasicMapping();
+    }
 
-    auto single_readers = single_easy_readers_for_libs(dataset, libs,
-            /*followed by rc*/true, /*including paired*/true);
+    // Every sample is split into several binary streams to be mapped by all the threads
+    std::vector<io::BinarySingleStreams> single_readers;
+    for (size_t i = 0; i < dataset.lib_count(); ++i) {
+        io::ReadConverter::ConvertToBinary(dataset[i]);
+        single_readers.push_back(io::single_binary_readers(dataset[i], /*followed by rc*/true,
+                                                           /*including paired*/true,
+                                                           SequenceMapperNotifier::STREAM_SPLIT_FACTOR));
+    }
 
     size_t sample_cnt = dataset.lib_count();
     debruijn_graph::coverage_profiles::EdgeProfileStorage profile_storage(graph, sample_cnt);
 
-    profile_storage.Fill(single_readers, *MapperInstance(gp));
+    if (sparse_index)
+        profile_storage.Fill(single_readers, *MapperInstance(gp, *sparse_index));
+    else
+        profile_storage.Fill(single_readers, *MapperInstance(gp));
 
     std::ofstream os(profiles_fn);
     profile_storage.Save(os, label_helper.edge_naming_f());
@@ -85,7 +85,8 @@ static void Run(const std::string &graph_path, const std::string &dataset_desc,
 struct gcfg {
     gcfg()
         : k(21), tmpdir("tmp"), outfile("-"),
-          nthreads(omp_get_max_threads() / 2 + 1)
+          nthreads(omp_get_max_threads() / 2 + 1),
+          minimizer_window(0)
     {}
 
     unsigned k;
@@ -94,6 +95,7 @@ struct gcfg {
     std::string tmpdir;
     std::string outfile;
     unsigned nthreads;
+    unsigned minimizer_window;
 };
 
 static void process_cmdline(int argc, char **argv, gcfg &cfg) {
@@ -105,7 +107,8 @@ static void process_cmdline(int argc, char **argv, gcfg &cfg) {
       cfg.outfile << value("output filename"),
       (option("-k") & integer("value", cfg.k)) % "k-mer length to use",
       (option("-t", "--threads") & integer("value", cfg.nthreads)) % "# of threads to use",
-      (option("--tmpdir") & value("dir", cfg.tmpdir)) % "scratch directory to use"
+      (option("--tmpdir") & value("dir", cfg.tmpdir)) % "scratch directory to use",
+      (option("--minimizer-window") & integer("value", cfg.minimizer_window)) % "map reads using the index of (w,k)-minimizers with the given window instead of all k-mers (0 to disable)"
   );
 
   auto result = parse(argc, argv, cli);
@@ -138,7 +141,7 @@ int main(int argc, char** argv) {
         omp_set_num_threads((int) nthreads);
         INFO("# of threads to use: " << nthreads);
 
-        Run(cfg.graph, cfg.file, k, cfg.outfile, nthreads, tmpdir);
+        Run(cfg.graph, cfg.file, k, cfg.outfile, nthreads, tmpdir, cfg.minimizer_window);
     } catch (const std::string &s) {
         std::cerr << s << std::endl;
         return EINTR;
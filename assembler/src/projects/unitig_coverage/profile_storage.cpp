@@ -11,33 +11,36 @@ namespace debruijn_graph {
 namespace coverage_profiles {
 
 void EdgeProfileStorage::HandleDelete(EdgeId e) {
-    profiles_.erase(e);
+    if (has_profile(e)) {
+        std::fill_n(row(e), sample_cnt_, 0);
+        has_profile_[e.int_id()] = false;
+    }
 }
 
 void EdgeProfileStorage::HandleMerge(const std::vector<EdgeId> &old_edges, EdgeId new_edge) {
     RawAbundanceVector total(sample_cnt_, 0);
     for (EdgeId e : old_edges) {
-        Add(total, utils::get(profiles_, e));
+        Add(total, raw_profile(e));
     }
-    profiles_[new_edge] = std::move(total);
+    set_raw_profile(new_edge, total);
 }
 
 void EdgeProfileStorage::HandleGlue(EdgeId new_edge, EdgeId edge1, EdgeId edge2) {
-    RawAbundanceVector total(utils::get(profiles_, edge1));
-    Add(total, utils::get(profiles_, edge2));
-    profiles_[new_edge] = std::move(total);
+    RawAbundanceVector total(raw_profile(edge1));
+    Add(total, raw_profile(edge2));
+    set_raw_profile(new_edge, total);
 }
 
 void EdgeProfileStorage::HandleSplit(EdgeId old_edge, EdgeId new_edge1, EdgeId new_edge2) {
     AbundanceVector abund = profile(old_edge);
     if (old_edge == g().conjugate(old_edge)) {
         RawAbundanceVector raw1 = MultiplyEscapeZero(abund, g().length(new_edge1));
-        profiles_[new_edge1] = raw1;
-        profiles_[g().conjugate(new_edge1)] = std::move(raw1);
-        profiles_[new_edge2] = MultiplyEscapeZero(abund, g().length(new_edge2));
+        set_raw_profile(new_edge1, raw1);
+        set_raw_profile(g().conjugate(new_edge1), raw1);
+        set_raw_profile(new_edge2, MultiplyEscapeZero(abund, g().length(new_edge2)));
     } else {
-        profiles_[new_edge1] = MultiplyEscapeZero(abund, g().length(new_edge1));
-        profiles_[new_edge2] = MultiplyEscapeZero(abund, g().length(new_edge2));
+        set_raw_profile(new_edge1, MultiplyEscapeZero(abund, g().length(new_edge1)));
+        set_raw_profile(new_edge2, MultiplyEscapeZero(abund, g().length(new_edge2)));
     }
 }
 
@@ -61,14 +64,14 @@ void EdgeProfileStorage::Load(std::istream &is,
         ss >> label;
         EdgeId e = label_helper.edge(label);
         auto p = MultiplyEscapeZero(LoadAbundanceVector(ss), g().length(e));
-        profiles_[e] = p;
-        profiles_[g().conjugate(e)] = std::move(p);
+        set_raw_profile(e, p);
+        set_raw_profile(g().conjugate(e), p);
     }
 
     if (check_consistency) {
         for (auto it = g().ConstEdgeBegin(); !it.IsEnd(); ++it) {
             EdgeId e = *it;
-            CHECK_FATAL_ERROR(profiles_.count(e) > 0, "Failed to load profile for one of the edges");
+            CHECK_FATAL_ERROR(has_profile(e), "Failed to load profile for one of the edges");
         }
     }
 }
@@ -8,6 +8,7 @@
 #include "assembly_graph/core/graph.hpp"
 #include "assembly_graph/handlers/id_track_handler.hpp"
 #include "toolchain/edge_label_helper.hpp"
+#include "utils/parallel/openmp_wrapper.h"
 
 #include <vector>
 
@@ -21,8 +22,46 @@ class EdgeProfileStorage : public omnigraph::GraphActionHandler<Graph> {
     typedef std::vector<size_t> RawAbundanceVector;
     typedef std::vector<double> AbundanceVector;
 
+    static constexpr size_t READ_BATCH_SIZE = 1000;
+
     size_t sample_cnt_;
-    std::unordered_map<EdgeId, RawAbundanceVector> profiles_;
+    // Dense matrix of raw profiles, row of the edge starts at int_id() * sample_cnt_
+    std::vector<size_t> profiles_;
+    std::vector<bool> has_profile_;
+
+    void ReserveRows(size_t rows) {
+        if (rows <= has_profile_.size())
+            return;
+        has_profile_.resize(rows, false);
+        profiles_.resize(rows * sample_cnt_, 0);
+    }
+
+    size_t *row(EdgeId e) {
+        size_t id = e.int_id();
+        if (id >= has_profile_.size())
+            ReserveRows(std::max(id + 1, has_profile_.size() * 3 / 2));
+        return profiles_.data() + id * sample_cnt_;
+    }
+
+    const size_t *row(EdgeId e) const {
+        VERIFY_MSG(has_profile(e), "No profile for edge " << e.int_id());
+        return profiles_.data() + e.int_id() * sample_cnt_;
+    }
+
+    bool has_profile(EdgeId e) const {
+        return e.int_id() < has_profile_.size() && has_profile_[e.int_id()];
+    }
+
+    RawAbundanceVector raw_profile(EdgeId e) const {
+        const size_t *r = row(e);
+        return RawAbundanceVector(r, r + sample_cnt_);
+    }
+
+    void set_raw_profile(EdgeId e, const RawAbundanceVector &p) {
+        VERIFY(p.size() == sample_cnt_);
+        std::copy(p.begin(), p.end(), row(e));
+        has_profile_[e.int_id()] = true;
+    }
 
     AbundanceVector Normalize(const RawAbundanceVector &p, size_t length) const {
         AbundanceVector answer(sample_cnt_);
@@ -57,14 +96,30 @@ class EdgeProfileStorage : public omnigraph::GraphActionHandler<Graph> {
         return total;
     }
 
-    template<class SingleStream, class Mapper>
-    void Fill(SingleStream &reader, size_t stream_id, const Mapper &mapper) {
-        typename SingleStream::ReadT read;
-        while (!reader.eof()) {
-            reader >> read;
-
-            for (const auto &e_mr: mapper.MapSequence(read.sequence())) {
-                profiles_[e_mr.first][stream_id] += e_mr.second.mapped_range.size();
+    // Streams of the sample are dispatched to the threads dynamically, every thread maps the reads
+    // of its stream in batches and adds the mapped lengths right to the profile column of the sample
+    template<class SingleStreams, class Mapper>
+    void Fill(SingleStreams &streams, size_t stream_id, const Mapper &mapper) {
+#       pragma omp parallel for schedule(dynamic, 1)
+        for (size_t i = 0; i < streams.size(); ++i) {
+            auto &stream = streams[i];
+            std::vector<Sequence> batch;
+            typename SingleStreams::ReadT read;
+            while (!stream.eof()) {
+                batch.clear();
+                while (batch.size() < READ_BATCH_SIZE && !stream.eof()) {
+                    stream >> read;
+                    batch.push_back(read.sequence());
+                }
+
+                for (const auto &path : mapper.MapSequences(batch)) {
+                    for (const auto &e_mr : path) {
+                        size_t &count = profiles_[e_mr.first.int_id() * sample_cnt_ + stream_id];
+                        size_t len = e_mr.second.mapped_range.size();
+#                       pragma omp atomic
+                        count += len;
+                    }
+                }
             }
         }
     };
@@ -74,15 +129,16 @@ public:
             omnigraph::GraphActionHandler<Graph>(g, "EdgeProfileStorage"),
             sample_cnt_(sample_cnt) {}
 
-    template<class SingleStreamList, class Mapper>
-    void Fill(SingleStreamList &streams, const Mapper &mapper) {
+    // streams[i] is the list of streams of the i-th sample
+    template<class SingleStreamLists, class Mapper>
+    void Fill(SingleStreamLists &streams, const Mapper &mapper) {
         //Initialize profiles
-        for (auto it = g().ConstEdgeBegin(); !it.IsEnd(); ++it) {
-            profiles_[*it] = RawAbundanceVector(sample_cnt_, 0);
-        }
+        for (auto it = g().ConstEdgeBegin(); !it.IsEnd(); ++it)
+            set_raw_profile(*it, RawAbundanceVector(sample_cnt_, 0));
+        ReserveRows(g().max_eid() + 1);
 
-#       pragma omp parallel for
         for (size_t i = 0; i < sample_cnt_; ++i) {
+            INFO("Filling profiles for sample " << i);
             Fill(streams[i], i, mapper);
         }
     }
@@ -92,7 +148,7 @@ public:
     }
 
     AbundanceVector profile(EdgeId e) const {
-        return Normalize(utils::get(profiles_, e), g().length(e));
+        return Normalize(raw_profile(e), g().length(e));
     }
 
     void HandleDelete(EdgeId e) override;
@@ -0,0 +1,131 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Microbenchmark of the distance estimation kernel on histograms of the
+// realistic sizes pulled from the paired index. Compares the scalar merge
+// formerly used by DistanceEstimator with NearestDistanceKernel.
+
+#include "assembly_graph/core/graph.hpp"
+#include "paired_info/distance_kernels.hpp"
+#include "paired_info/paired_info.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include <iostream>
+#include <random>
+
+using namespace debruijn_graph;
+using namespace omnigraph::de;
+
+namespace {
+
+typedef UnclusteredPairedInfoIndexT<Graph> Index;
+
+// The former scalar loop of DistanceEstimator::EstimateEdgePairDistances
+std::vector<double> ScalarWeights(const Index::HistProxy &histogram,
+                                  const std::vector<float> &forward, float max_distance) {
+    using namespace math;
+    size_t cur_dist = 0;
+    std::vector<DEWeight> weights(forward.size(), 0);
+    for (auto point : histogram) {
+        while (cur_dist + 1 < forward.size() && forward[cur_dist + 1] < point.d)
+            ++cur_dist;
+
+        if (cur_dist + 1 < forward.size() &&
+            ls(forward[cur_dist + 1] - point.d, point.d - forward[cur_dist])) {
+            ++cur_dist;
+            if (le(std::abs(forward[cur_dist] - point.d), max_distance))
+                weights[cur_dist] += point.weight;
+        } else if (cur_dist + 1 < forward.size() &&
+                   eq(forward[cur_dist + 1] - point.d, point.d - forward[cur_dist])) {
+            if (le(std::abs(forward[cur_dist] - point.d), max_distance))
+                weights[cur_dist] += point.weight * 0.5;
+            ++cur_dist;
+            if (le(std::abs(forward[cur_dist] - point.d), max_distance))
+                weights[cur_dist] += point.weight * 0.5;
+        } else {
+            if (le(std::abs(forward[cur_dist] - point.d), max_distance))
+                weights[cur_dist] += point.weight;
+        }
+    }
+
+    return std::vector<double>(weights.begin(), weights.end());
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t pairs = argc > 1 ? std::stoul(argv[1]) : 2000;
+    const size_t rounds = 20;
+    const float max_distance = 50;
+    const std::vector<std::pair<size_t, size_t>> setups = {
+        // insert size, graph distance candidates
+        {300, 4}, {500, 16}, {5000, 64}
+    };
+
+    std::mt19937 rng(42);
+    Graph g(55);
+    std::vector<EdgeId> edges;
+    for (size_t i = 0; i < 2 * pairs; ++i) {
+        std::string s(100, 'A');
+        for (char &c : s)
+            c = nucl(char(rng() % 4));
+        edges.push_back(g.AddEdge(g.AddVertex(), g.AddVertex(), Sequence(s)));
+    }
+
+    std::cout << "bench\tinsert_size\tpoints_per_hist\tdistances\tscalar_ns\tkernel_ns\tmax_abs_diff" << std::endl;
+    for (const auto &setup : setups) {
+        size_t insert_size = setup.first, dist_cnt = setup.second;
+        std::normal_distribution<double> is_distr((double) insert_size, (double) insert_size / 10);
+
+        Index index(g);
+        for (size_t i = 0; i < pairs; ++i) {
+            // Coverage of tens to hundreds of read pairs per edge pair
+            size_t reads = 50 + rng() % 500;
+            for (size_t r = 0; r < reads; ++r)
+                index.Add(edges[2 * i], edges[2 * i + 1], RawPoint(DEDistance(int(is_distr(rng))), DEWeight(1)));
+        }
+
+        std::vector<float> forward;
+        for (size_t j = 0; j < dist_cnt; ++j)
+            forward.push_back(float(insert_size - insert_size / 5 + j * (2 * insert_size / 5) / dist_cnt));
+
+        size_t points = 0;
+        double diff = 0;
+        utils::perf_counter pc;
+        double scalar_time = 0, kernel_time = 0;
+        for (size_t round = 0; round < rounds; ++round) {
+            pc.reset();
+            std::vector<std::vector<double>> scalar(pairs);
+            for (size_t i = 0; i < pairs; ++i)
+                scalar[i] = ScalarWeights(index.Get(edges[2 * i], edges[2 * i + 1]), forward, max_distance);
+            scalar_time += pc.time();
+
+            pc.reset();
+            PointColumns columns;
+            NearestDistanceKernel kernel;
+            std::vector<double> weights;
+            for (size_t i = 0; i < pairs; ++i) {
+                columns.clear();
+                for (auto point : index.Get(edges[2 * i], edges[2 * i + 1]))
+                    columns.push_back(point);
+                kernel(columns, forward, max_distance, weights);
+                if (round == 0) {
+                    points += columns.size();
+                    for (size_t j = 0; j < weights.size(); ++j)
+                        diff = std::max(diff, std::abs(weights[j] - scalar[i][j]));
+                }
+            }
+            kernel_time += pc.time();
+        }
+
+        double hists = double(pairs * rounds);
+        std::cout << "de_kernel\t" << insert_size << "\t" << points / pairs << "\t" << dist_cnt << "\t"
+                  << scalar_time / hists * 1e9 << "\t" << kernel_time / hists * 1e9 << "\t"
+                  << diff << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,107 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Memory footprint and mapping throughput of the full k-mer EdgeIndex versus
+// MinimizerEdgeIndex on a graph built from a random genome with repeats.
+// Reads are sampled from the genome with substitution errors.
+
+#include "modules/alignment/sequence_mapper.hpp"
+#include "modules/graph_construction.hpp"
+#include "io/reads/rc_reader_wrapper.hpp"
+#include "io/reads/read_stream_vector.hpp"
+#include "io/reads/vector_reader.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/memory_limit.hpp"
+#include "utils/perf/perfcounter.hpp"
+
+#include "test/debruijn/test_utils.hpp"
+
+#include <iostream>
+#include <random>
+
+using namespace debruijn_graph;
+using test_utils::RandomSeq;
+
+namespace {
+
+template<class Mapper>
+std::pair<double, size_t> MapReads(const Mapper &mapper, const std::vector<Sequence> &reads) {
+    utils::perf_counter pc;
+    size_t mapped = 0;
+#   pragma omp parallel for reduction(+:mapped)
+    for (size_t i = 0; i < reads.size(); ++i)
+        mapped += mapper.MapSequence(reads[i]).size() > 0;
+    return { double(reads.size()) / pc.time(), mapped };
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t genome_len = argc > 1 ? std::stoul(argv[1]) : 5000000;
+    size_t nreads = argc > 2 ? std::stoul(argv[2]) : 200000;
+    const size_t k = 55, read_len = 150;
+    const std::vector<size_t> windows = { 5, 10, 20 };
+
+    logging::logger *lg = logging::create_logger("", logging::L_WARN);
+    lg->add_writer(std::make_shared<logging::console_writer>());
+    logging::attach_logger(lg);
+
+    std::mt19937 rng(42);
+    // Every tenth fragment is a copy of one of a few repeats
+    std::vector<std::string> repeats;
+    for (size_t i = 0; i < 20; ++i)
+        repeats.push_back(RandomSeq(rng, 1000));
+    std::string genome;
+    while (genome.size() < genome_len)
+        genome += (rng() % 10 == 0) ? repeats[rng() % repeats.size()] : RandomSeq(rng, 5000);
+
+    std::vector<Sequence> reads;
+    for (size_t i = 0; i < nreads; ++i) {
+        std::string read = genome.substr(rng() % (genome.size() - read_len), read_len);
+        for (char &c : read)
+            if (rng() % 200 == 0)
+                c = "ACGT"[rng() % 4];
+        reads.emplace_back(read);
+    }
+
+    GraphPack gp(k, "tmp", 0);
+    auto workdir = fs::tmp::make_temp_dir(gp.workdir(), "bench");
+    auto &graph = gp.get_mutable<Graph>();
+    auto &index = gp.get_mutable<EdgeIndex<Graph>>();
+    {
+        io::ReadStreamList<io::SingleRead> streams(
+            io::RCWrap<io::SingleRead>(io::VectorReadStream<io::SingleRead>(io::SingleRead("genome", genome))));
+        ConstructGraph(config::debruijn_config::construction(), workdir, streams, graph);
+    }
+    gp.get_mutable<KmerMapper<Graph>>().Attach();
+
+    size_t kmers = 0;
+    for (EdgeId e : graph.canonical_edges())
+        kmers += graph.length(e);
+
+    std::cout << "bench\tindex\tsampled_kmers\tindex_mb\tbytes_per_graph_kmer\treads_per_s\tmapped_fraction" << std::endl;
+    auto report = [&](const std::string &name, size_t sampled, size_t mem, std::pair<double, size_t> res) {
+        std::cout << "mapping_index\t" << name << "\t" << sampled << "\t" << double(mem) / 1024 / 1024 << "\t"
+                  << double(mem) / double(kmers) << "\t" << res.first << "\t"
+                  << double(res.second) / double(reads.size()) << std::endl;
+    };
+
+    size_t before = utils::get_used_memory();
+    index.Refill();
+    size_t full_mem = utils::get_used_memory() - before;
+    report("full", kmers, full_mem, MapReads(*MapperInstance(gp), reads));
+    index.clear();
+
+    for (size_t w : windows) {
+        MinimizerEdgeIndex<Graph> sparse_index(graph, w);
+        sparse_index.Refill();
+        report("minimizer_w" + std::to_string(w), sparse_index.size(), sparse_index.mem_size(),
+               MapReads(*MapperInstance(gp, sparse_index), reads));
+    }
+
+    return 0;
+}
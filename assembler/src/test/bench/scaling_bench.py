@@ -0,0 +1,134 @@
+#!/usr/bin/env python3
+
+############################################################################
+# Copyright (c) 2023 Saint Petersburg State University
+# All Rights Reserved
+# See file LICENSE for details.
+############################################################################
+
+# Per-stage scaling of spades-core on a synthetic dataset. Generates the
+# dataset with synthetic_dataset, assembles it with every thread count given
+# (time tracing enabled) and collects the totals of the TIME_TRACE_SCOPE
+# sections from the time traces into a table:
+#   scope  threads  seconds  speedup  efficiency
+# Speedup and efficiency are relative to the smallest thread count.
+# Everything runs locally, no data is downloaded.
+
+import argparse
+import glob
+import json
+import logging
+import os
+import shutil
+import subprocess
+import sys
+
+
+def parse_args():
+    repo_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), "..", "..", ".."))
+    parser = argparse.ArgumentParser(description="Per-stage scaling benchmark of spades-core on synthetic data")
+    parser.add_argument("-o", "--output-dir", required=True, help="working directory")
+    parser.add_argument("-t", "--threads", default="1,2,4,8,16,32,64,128",
+                        help="comma-separated thread counts, the ones above the number of CPUs are skipped")
+    parser.add_argument("--all-threads", action="store_true",
+                        help="do not skip the thread counts above the number of CPUs")
+    parser.add_argument("-k", type=int, default=55, help="k-mer length")
+    parser.add_argument("-m", "--memory", type=int, default=250, help="memory limit in Gb")
+    parser.add_argument("--spades", default=os.path.join(repo_dir, "spades.py"), help="spades.py to run")
+    parser.add_argument("--generator", default=shutil.which("synthetic_dataset") or
+                        os.path.join(repo_dir, "build_spades", "bin", "synthetic_dataset"),
+                        help="synthetic_dataset executable")
+    parser.add_argument("--min-share", type=float, default=0.01,
+                        help="scopes taking less than this share of the total time are not reported")
+    parser.add_argument("--table", help="write the table to this file as well")
+    parser.add_argument("generator_args", nargs=argparse.REMAINDER,
+                        help="options passed to synthetic_dataset after --, e.g. -- -l 10000000 -g 10")
+    return parser.parse_args()
+
+
+def run(log, cmd, **kwargs):
+    log.info("Running: " + " ".join(cmd))
+    subprocess.check_call(cmd, **kwargs)
+
+
+def generate_dataset(log, args):
+    prefix = os.path.join(args.output_dir, "dataset")
+    generator_args = [a for a in args.generator_args if a != "--"]
+    run(log, [args.generator, prefix] + generator_args)
+    genomes = 1
+    with open(prefix + ".fasta") as reference:
+        genomes = sum(1 for line in reference if line.startswith(">"))
+    return prefix + "_1.fastq", prefix + "_2.fastq", genomes > 1
+
+
+def assemble(log, args, reads, meta, threads):
+    outdir = os.path.join(args.output_dir, "t%d" % threads)
+    cmd = [sys.executable, args.spades, "--only-assembler", "--trace-time",
+           "-k", str(args.k), "-t", str(threads), "-m", str(args.memory),
+           "-1", reads[0], "-2", reads[1], "-o", outdir]
+    if meta:
+        cmd.append("--meta")
+    with open(os.path.join(args.output_dir, "t%d.log" % threads), "w") as out:
+        run(log, cmd, stdout=out, stderr=subprocess.STDOUT)
+
+    traces = glob.glob(os.path.join(outdir, "K%d" % args.k, "spades_time_trace_*.json"))
+    if not traces:
+        log.error("No time trace was written to " + outdir)
+        sys.exit(1)
+    return traces[0]
+
+
+# Totals of the scopes in seconds. The trace has a "Total <scope>" event for every scope name,
+# it counts only the outermost instances of nested scopes of the same name.
+def scope_totals(trace):
+    with open(trace) as f:
+        events = json.load(f)["traceEvents"]
+    totals = dict()
+    for event in events:
+        name = event.get("name", "")
+        if event.get("ph") == "X" and name.startswith("Total "):
+            totals[name[len("Total "):]] = event["dur"] / 1e6
+    return totals
+
+
+def main():
+    args = parse_args()
+    log = logging.getLogger("scaling bench")
+    log.setLevel(logging.INFO)
+    console = logging.StreamHandler(sys.stderr)
+    console.setFormatter(logging.Formatter("%(message)s"))
+    log.addHandler(console)
+
+    threads = sorted(set(int(t) for t in args.threads.split(",")))
+    if not args.all_threads:
+        threads = [t for t in threads if t <= os.cpu_count()] or [1]
+
+    os.makedirs(args.output_dir, exist_ok=True)
+    *reads, meta = generate_dataset(log, args)
+
+    totals = dict()
+    for t in threads:
+        totals[t] = scope_totals(assemble(log, args, reads, meta, t))
+
+    base = totals[threads[0]]
+    overall = max(base.values())
+    scopes = sorted((s for s in base if base[s] >= args.min_share * overall), key=lambda s: -base[s])
+
+    lines = ["scope\tthreads\tseconds\tspeedup\tefficiency"]
+    for scope in scopes:
+        for t in threads:
+            seconds = totals[t].get(scope)
+            if seconds is None:
+                continue
+            speedup = base[scope] / seconds if seconds > 0 else 0
+            lines.append("%s\t%d\t%.3f\t%.2f\t%.2f" % (scope, t, seconds, speedup, speedup * threads[0] / t))
+
+    table = "\n".join(lines) + "\n"
+    sys.stdout.write(table)
+    if args.table:
+        with open(args.table, "w") as f:
+            f.write(table)
+
+
+if __name__ == "__main__":
+    main()
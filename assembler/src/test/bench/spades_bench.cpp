@@ -0,0 +1,438 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Microbenchmarks of the hot kernels on synthetic data generated in-process.
+// Every kernel is run several rounds after an untimed warm-up, one TSV line
+// per kernel is printed, so that the results can be tracked across versions.
+//
+// Usage: spades-bench [scale] [rounds] [filter]
+//   scale  - multiplier of the data sizes (1 by default)
+//   rounds - number of timed runs of every kernel (5 by default)
+//   filter - only the kernels with the name containing it are run
+
+#include "adt/concurrent_dsu.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+#include "assembly_graph/paths/bidirectional_path.hpp"
+#include "io/reads/binary_converter.hpp"
+#include "io/reads/binary_streams.hpp"
+#include "io/reads/fasta_fastq_gz_parser.hpp"
+#include "io/reads/rc_reader_wrapper.hpp"
+#include "io/reads/read_stream_vector.hpp"
+#include "io/reads/vector_reader.hpp"
+#include "modules/graph_construction.hpp"
+#include "paired_info/histogram.hpp"
+#include "utils/filesystem/temporary.hpp"
+#include "utils/kmer_mph/kmer_splitters.hpp"
+#include "utils/logger/log_writers.hpp"
+#include "utils/parallel/numa.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+#include "utils/perf/perfcounter.hpp"
+#include "utils/ph_map/perfect_hash_map_builder.hpp"
+#include "version.hpp"
+
+#include "test/debruijn/test_utils.hpp"
+
+#include <zlib.h>
+
+#include <algorithm>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <random>
+
+using namespace debruijn_graph;
+using test_utils::RandomSeq;
+
+namespace {
+
+// Synthetic data shared by the kernels
+struct Dataset {
+    std::string genome;
+    std::vector<std::string> reads;
+    fs::TmpDir workdir;
+};
+
+Dataset GenerateDataset(size_t scale, const std::string &tmp_dir) {
+    const size_t genome_len = 1000000 * scale, nreads = 100000 * scale, read_len = 150;
+    std::mt19937 rng(42);
+    Dataset data;
+
+    // Unique fragments interleaved with copies of short repeats, so that the
+    // graph of the genome has thousands of vertices for the graph kernels
+    std::vector<std::string> repeats;
+    for (size_t i = 0; i < 500 * scale; ++i)
+        repeats.push_back(RandomSeq(rng, 100 + rng() % 200));
+    while (data.genome.size() < genome_len) {
+        data.genome += RandomSeq(rng, 200 + rng() % 1800);
+        data.genome += repeats[rng() % repeats.size()];
+    }
+
+    for (size_t i = 0; i < nreads; ++i) {
+        std::string read = data.genome.substr(rng() % (data.genome.size() - read_len), read_len);
+        for (char &c : read)
+            if (rng() % 200 == 0)
+                c = "ACGT"[rng() % 4];
+        data.reads.push_back(read);
+    }
+
+    data.workdir = fs::tmp::make_temp_dir(tmp_dir, "spades_bench");
+    return data;
+}
+
+// A kernel prepared for timing. The checksum it returns keeps the work
+// observable for the compiler and allows to compare the runs.
+struct Kernel {
+    size_t items;
+    std::function<size_t()> run;
+};
+
+typedef std::function<Kernel(const Dataset&)> KernelFactory;
+
+Kernel RtSeqRolling(const Dataset &data) {
+    const unsigned k = 55;
+    Sequence genome(data.genome);
+    return { genome.size() - k + 1, [=]() {
+        size_t checksum = 0;
+        RtSeq kmer = genome.start<RtSeq>(k) >> 'A';
+        for (size_t i = k - 1; i < genome.size(); ++i) {
+            kmer <<= genome[i];
+            checksum += kmer[0];
+        }
+        return checksum;
+    } };
+}
+
+Kernel RtSeqCanonical(const Dataset &data) {
+    const unsigned k = 55;
+    Sequence genome(data.genome);
+    return { genome.size() - k + 1, [=]() {
+        size_t checksum = 0;
+        RtSeq kmer = genome.start<RtSeq>(k) >> 'A';
+        for (size_t i = k - 1; i < genome.size(); ++i) {
+            kmer <<= genome[i];
+            RtSeq canonical = kmer.IsMinimal() ? kmer : !kmer;
+            checksum += canonical[0];
+        }
+        return checksum;
+    } };
+}
+
+Kernel KMerIndexLookup(const Dataset &data) {
+    typedef utils::PerfectHashMap<RtSeq, uint32_t, utils::slim_kmer_index_traits<RtSeq>, utils::DefaultStoring> Index;
+    const unsigned k = 31;
+
+    auto index = std::make_shared<Index>(k);
+    {
+        io::ReadStreamList<io::SingleRead> streams(
+            io::RCWrap<io::SingleRead>(io::VectorReadStream<io::SingleRead>(io::SingleRead("genome", data.genome))));
+        using Splitter = utils::DeBruijnReadKMerSplitter<io::SingleRead, utils::StoringTypeFilter<utils::DefaultStoring>>;
+        kmers::KMerDiskCounter<RtSeq> counter(data.workdir, Splitter(data.workdir, k, streams));
+        utils::PerfectHashMapBuilder().BuildIndex(*index, counter, 16, omp_get_max_threads());
+    }
+
+    // The k-mers of the reads are looked up, so some of them are absent
+    std::vector<RtSeq> queries;
+    for (const auto &read : data.reads) {
+        Sequence seq(read);
+        RtSeq kmer = seq.start<RtSeq>(k) >> 'A';
+        for (size_t i = k - 1; i < seq.size(); ++i) {
+            kmer <<= seq[i];
+            queries.push_back(kmer.IsMinimal() ? kmer : !kmer);
+        }
+    }
+
+    return { queries.size(), [=]() {
+        size_t checksum = 0;
+#       pragma omp parallel for reduction(+:checksum)
+        for (size_t i = 0; i < queries.size(); ++i)
+            checksum += index->ConstructKWH(queries[i]).idx();
+        return checksum;
+    } };
+}
+
+Kernel DSUUnion(const Dataset &data) {
+    // As many elements as k-mers in the genome, the unions form long chains with random shortcuts
+    size_t size = data.genome.size();
+    std::mt19937 rng(42);
+    std::vector<std::pair<size_t, size_t>> unions;
+    for (size_t i = 0; i + 1 < size; ++i)
+        unions.emplace_back(i, (rng() % 8 == 0) ? rng() % size : i + 1);
+    std::shuffle(unions.begin(), unions.end(), rng);
+
+    return { unions.size(), [=]() {
+        dsu::ConcurrentDSU dsu(size);
+#       pragma omp parallel for
+        for (size_t i = 0; i < unions.size(); ++i)
+            dsu.unite(unions[i].first, unions[i].second);
+        return dsu.num_sets();
+    } };
+}
+
+Kernel HistogramMerge(const Dataset &data) {
+    typedef omnigraph::de::RawHistogram Histogram;
+    // Histograms of the paired info of the edge pairs, tens of points each
+    size_t count = data.reads.size() / 10;
+    std::mt19937 rng(42);
+    std::normal_distribution<double> distance(500, 50);
+    auto random_histogram = [&]() {
+        Histogram res;
+        size_t points = 10 + rng() % 100;
+        for (size_t i = 0; i < points; ++i)
+            res.merge_point(omnigraph::de::RawPoint(omnigraph::de::DEDistance(int(distance(rng))), 1));
+        return res;
+    };
+    std::vector<Histogram> left, right;
+    for (size_t i = 0; i < count; ++i) {
+        left.push_back(random_histogram());
+        right.push_back(random_histogram());
+    }
+
+    return { count, [=]() {
+        size_t checksum = 0;
+        for (size_t i = 0; i < left.size(); ++i) {
+            Histogram merged(left[i]);
+            merged.merge(right[i]);
+            checksum += merged.size();
+        }
+        return checksum;
+    } };
+}
+
+// Graph of the genome shared by the graph kernels
+std::shared_ptr<Graph> GenomeGraph(const Dataset &data) {
+    static std::shared_ptr<Graph> graph;
+    if (graph)
+        return graph;
+
+    graph = std::make_shared<Graph>(55);
+    io::ReadStreamList<io::SingleRead> streams(
+        io::RCWrap<io::SingleRead>(io::VectorReadStream<io::SingleRead>(io::SingleRead("genome", data.genome))));
+    ConstructGraph(config::debruijn_config::construction(), data.workdir, streams, *graph);
+    return graph;
+}
+
+Kernel PathGrowth(const Dataset &data) {
+    auto graph = GenomeGraph(data);
+    // Random walks over the graph, the paths are grown edge by edge as the extenders do
+    std::mt19937 rng(42);
+    std::vector<std::vector<EdgeId>> walks;
+    std::vector<EdgeId> edges;
+    for (EdgeId e : graph->edges())
+        edges.push_back(e);
+    size_t total = 0;
+    for (size_t i = 0; i < data.reads.size() / 100; ++i) {
+        std::vector<EdgeId> walk = { edges[rng() % edges.size()] };
+        while (walk.size() < 1000) {
+            VertexId v = graph->EdgeEnd(walk.back());
+            if (graph->OutgoingEdgeCount(v) == 0)
+                break;
+            auto it = graph->OutgoingEdges(v).begin();
+            std::advance(it, rng() % graph->OutgoingEdgeCount(v));
+            walk.push_back(*it);
+        }
+        total += walk.size();
+        walks.push_back(std::move(walk));
+    }
+
+    return { total, [=]() {
+        size_t checksum = 0;
+        for (const auto &walk : walks) {
+            auto path = path_extend::BidirectionalPath::create(*graph);
+            for (EdgeId e : walk)
+                path->PushBack(e);
+            checksum += path->Length();
+        }
+        return checksum;
+    } };
+}
+
+Kernel BoundedDijkstra(const Dataset &data) {
+    typedef omnigraph::DijkstraHelper<Graph> Helper;
+    auto graph = GenomeGraph(data);
+    std::vector<VertexId> starts;
+    for (VertexId v : *graph)
+        starts.push_back(v);
+    std::mt19937 rng(42);
+    std::shuffle(starts.begin(), starts.end(), rng);
+    starts.resize(std::min(starts.size(), data.reads.size() / 100));
+
+    return { starts.size(), [=]() {
+        size_t checksum = 0;
+        for (VertexId v : starts) {
+            auto dijkstra = Helper::CreateBoundedDijkstra(*graph, 5000, 1000);
+            dijkstra.Run(v);
+            checksum += dijkstra.ReachedVertices().size();
+        }
+        return checksum;
+    } };
+}
+
+Kernel BinaryReadDecoding(const Dataset &data) {
+    std::string prefix = fs::append_path(data.workdir->dir(), "reads");
+    {
+        std::vector<io::SingleRead> reads;
+        for (const auto &read : data.reads)
+            reads.emplace_back("read", read);
+        io::ReadStream<io::SingleRead> stream(io::VectorReadStream<io::SingleRead>(std::move(reads)));
+        io::BinaryWriter(prefix).ToBinary(stream);
+    }
+
+    return { data.reads.size(), [=]() {
+        size_t checksum = 0;
+        io::BinaryFileSingleStream stream(prefix, 1, 0);
+        io::SingleReadSeq read;
+        while (!stream.eof()) {
+            stream >> read;
+            checksum += read.sequence().size();
+        }
+        return checksum;
+    } };
+}
+
+std::string FastqRecords(const Dataset &data) {
+    std::string res;
+    for (size_t i = 0; i < data.reads.size(); ++i)
+        res += "@read_" + std::to_string(i) + "\n" + data.reads[i] + "\n+\n" + std::string(data.reads[i].size(), 'I') + "\n";
+    return res;
+}
+
+Kernel FastqParsing(const std::string &filename, size_t nreads) {
+    return { nreads, [=]() {
+        size_t checksum = 0;
+        io::FastaFastqGzParser parser(filename);
+        io::SingleRead read;
+        while (!parser.eof()) {
+            parser >> read;
+            checksum += read.size();
+        }
+        return checksum;
+    } };
+}
+
+Kernel FastqParser(const Dataset &data) {
+    std::string filename = fs::append_path(data.workdir->dir(), "reads.fastq");
+    std::ofstream(filename) << FastqRecords(data);
+    return FastqParsing(filename, data.reads.size());
+}
+
+Kernel FastqGzParser(const Dataset &data) {
+    std::string filename = fs::append_path(data.workdir->dir(), "reads.fastq.gz");
+    std::string records = FastqRecords(data);
+    gzFile file = gzopen(filename.c_str(), "wb");
+    VERIFY(file);
+    gzwrite(file, records.data(), unsigned(records.size()));
+    gzclose(file);
+    return FastqParsing(filename, data.reads.size());
+}
+
+// Value array of 256 MB (times the scale) placed as PerfectHashMap places its values under the
+// given NUMA policy. The policies only make a difference on multi-node machines.
+std::shared_ptr<std::vector<uint32_t>> PlacedValues(const Dataset &data, utils::NumaPolicy policy) {
+    // Partition relies on the pinned threads, the pinning stays for the kernels run after
+    if (policy == utils::NumaPolicy::Partition)
+        utils::pin_omp_threads(unsigned(omp_get_max_threads()));
+    utils::set_numa_policy(policy);
+
+    size_t size = data.genome.size() * 64;
+    auto values = std::make_shared<std::vector<uint32_t>>();
+    values->resize(size);
+    utils::numa_place(values->data(), size * sizeof(uint32_t), unsigned(omp_get_max_threads()));
+    utils::set_numa_policy(utils::NumaPolicy::None);
+
+#   pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < size; ++i)
+        (*values)[i] = uint32_t(i * 2654435761u);
+    return values;
+}
+
+// Reads at random positions, as the k-mer lookups in the perfect hash maps do
+KernelFactory NumaRandomAccess(utils::NumaPolicy policy) {
+    return [=](const Dataset &data) {
+        auto values = PlacedValues(data, policy);
+        size_t lookups = values->size() / 4;
+        return Kernel{ lookups, [=]() {
+            size_t checksum = 0, size = values->size();
+#           pragma omp parallel for schedule(static) reduction(+:checksum)
+            for (size_t i = 0; i < lookups; ++i)
+                checksum += (*values)[(i * 0x9E3779B97F4A7C15ull) % size];
+            return checksum;
+        } };
+    };
+}
+
+// Reads of the chunks of the static schedule, as the passes over all values do
+KernelFactory NumaStaticScan(utils::NumaPolicy policy) {
+    return [=](const Dataset &data) {
+        auto values = PlacedValues(data, policy);
+        return Kernel{ values->size(), [=]() {
+            size_t checksum = 0;
+#           pragma omp parallel for schedule(static) reduction(+:checksum)
+            for (size_t i = 0; i < values->size(); ++i)
+                checksum += (*values)[i];
+            return checksum;
+        } };
+    };
+}
+
+}
+
+int main(int argc, char **argv) {
+    size_t scale = argc > 1 ? std::stoul(argv[1]) : 1;
+    size_t rounds = argc > 2 ? std::stoul(argv[2]) : 5;
+    std::string filter = argc > 3 ? argv[3] : "";
+    VERIFY(scale > 0 && rounds > 0);
+
+    logging::logger *lg = logging::create_logger("", logging::L_WARN);
+    lg->add_writer(std::make_shared<logging::console_writer>());
+    logging::attach_logger(lg);
+
+    const std::vector<std::pair<std::string, KernelFactory>> kernels = {
+        { "rtseq_rolling", RtSeqRolling },
+        { "rtseq_canonical", RtSeqCanonical },
+        { "kmer_index_lookup", KMerIndexLookup },
+        { "concurrent_dsu", DSUUnion },
+        { "histogram_merge", HistogramMerge },
+        { "path_growth", PathGrowth },
+        { "dijkstra", BoundedDijkstra },
+        { "binary_read_decoding", BinaryReadDecoding },
+        { "fastq_parser", FastqParser },
+        { "fastq_gz_parser", FastqGzParser },
+        // Partition pins the threads, so these kernels go last
+        { "numa_random_none", NumaRandomAccess(utils::NumaPolicy::None) },
+        { "numa_random_interleave", NumaRandomAccess(utils::NumaPolicy::Interleave) },
+        { "numa_scan_none", NumaStaticScan(utils::NumaPolicy::None) },
+        { "numa_scan_interleave", NumaStaticScan(utils::NumaPolicy::Interleave) },
+        { "numa_random_partition", NumaRandomAccess(utils::NumaPolicy::Partition) },
+        { "numa_scan_partition", NumaStaticScan(utils::NumaPolicy::Partition) },
+    };
+
+    Dataset data = GenerateDataset(scale, "/tmp");
+
+    std::cout << "bench\tkernel\trevision\tthreads\tscale\titems\trounds\tmin_ns_per_item\tmedian_ns_per_item\tchecksum" << std::endl;
+    for (const auto &entry : kernels) {
+        if (entry.first.find(filter) == std::string::npos)
+            continue;
+
+        Kernel kernel = entry.second(data);
+        // Warm-up, also the reference checksum for the timed runs
+        size_t checksum = kernel.run();
+        std::vector<double> times;
+        for (size_t round = 0; round < rounds; ++round) {
+            utils::perf_counter pc;
+            VERIFY_MSG(kernel.run() == checksum, "Kernel " << entry.first << " is not deterministic");
+            times.push_back(pc.time());
+        }
+        std::sort(times.begin(), times.end());
+
+        double items = double(std::max<size_t>(kernel.items, 1));
+        std::cout << "spades_bench\t" << entry.first << "\t" << version::gitrev() << "\t" << omp_get_max_threads() << "\t"
+                  << scale << "\t" << kernel.items << "\t" << rounds << "\t"
+                  << times.front() / items * 1e9 << "\t" << times[times.size() / 2] / items * 1e9 << "\t"
+                  << checksum << std::endl;
+    }
+
+    return 0;
+}
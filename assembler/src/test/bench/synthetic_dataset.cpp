@@ -0,0 +1,202 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+// Generator of synthetic datasets for the scaling benchmarks. Makes a random
+// genome (or several genomes with log-normal abundances for a metagenome),
+// plants copies of repeat families into it and simulates paired-end reads
+// with substitution errors. Writes <prefix>.fasta with the reference and
+// <prefix>_1.fastq, <prefix>_2.fastq with the reads in FR orientation.
+
+#include "sequence/nucl.hpp"
+#include "utils/verify.hpp"
+
+#include <clipp/clipp.h>
+
+#include <algorithm>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+
+struct gcfg {
+    gcfg()
+        : genome_length(5000000), genomes(1), abundance_sigma(1.0),
+          repeat_families(50), repeat_length(2000), repeat_copies(4), repeat_divergence(0.01),
+          coverage(50), read_length(150), insert_size(350), insert_size_dev(30),
+          error_rate(0.002), seed(42)
+    {}
+
+    std::string prefix;
+    size_t genome_length;
+    unsigned genomes;
+    double abundance_sigma;
+    unsigned repeat_families;
+    size_t repeat_length;
+    unsigned repeat_copies;
+    double repeat_divergence;
+    double coverage;
+    size_t read_length;
+    size_t insert_size;
+    size_t insert_size_dev;
+    double error_rate;
+    unsigned seed;
+};
+
+void process_cmdline(int argc, char **argv, gcfg &cfg) {
+    using namespace clipp;
+
+    auto cli = (
+        cfg.prefix << value("output prefix"),
+        (option("-l", "--genome-length") & integer("value", cfg.genome_length)) % "length of every genome",
+        (option("-g", "--genomes") & integer("value", cfg.genomes)) % "number of genomes, more than one makes a metagenome",
+        (option("--abundance-sigma") & number("value", cfg.abundance_sigma)) % "sigma of the log-normal genome abundances",
+        (option("--repeat-families") & integer("value", cfg.repeat_families)) % "number of repeat families",
+        (option("--repeat-length") & integer("value", cfg.repeat_length)) % "length of the repeats",
+        (option("--repeat-copies") & integer("value", cfg.repeat_copies)) % "copies of every repeat family",
+        (option("--repeat-divergence") & number("value", cfg.repeat_divergence)) % "substitution rate between the copies of a repeat",
+        (option("-c", "--coverage") & number("value", cfg.coverage)) % "mean read coverage",
+        (option("-r", "--read-length") & integer("value", cfg.read_length)) % "read length",
+        (option("-i", "--insert-size") & integer("value", cfg.insert_size)) % "mean insert size",
+        (option("--insert-size-dev") & integer("value", cfg.insert_size_dev)) % "standard deviation of the insert size",
+        (option("-e", "--error-rate") & number("value", cfg.error_rate)) % "substitution error rate of the reads",
+        (option("--seed") & integer("value", cfg.seed)) % "random seed"
+    );
+
+    auto result = parse(argc, argv, cli);
+    if (!result) {
+        std::cout << make_man_page(cli, argv[0]);
+        exit(1);
+    }
+}
+
+class DatasetGenerator {
+    const gcfg &cfg_;
+    std::mt19937_64 rng_;
+    std::uniform_real_distribution<double> unit_;
+
+    char RandomNucl() {
+        return nucl(char(rng_() % 4));
+    }
+
+    std::string RandomSeq(size_t len) {
+        std::string res(len, 'A');
+        for (char &c : res)
+            c = RandomNucl();
+        return res;
+    }
+
+    // Replaces every position with a different nucleotide with the given probability
+    void Mutate(std::string &s, double rate) {
+        if (rate <= 0)
+            return;
+        for (char &c : s) {
+            if (unit_(rng_) < rate)
+                c = nucl(char((dignucl(c) + 1 + rng_() % 3) % 4));
+        }
+    }
+
+    static std::string ReverseComplement(const std::string &s) {
+        std::string res(s.rbegin(), s.rend());
+        for (char &c : res)
+            c = nucl_complement(c);
+        return res;
+    }
+
+public:
+    DatasetGenerator(const gcfg &cfg)
+            : cfg_(cfg), rng_(cfg.seed), unit_(0, 1) {}
+
+    std::vector<std::string> Genomes() {
+        std::vector<std::string> genomes;
+        for (unsigned i = 0; i < cfg_.genomes; ++i)
+            genomes.push_back(RandomSeq(cfg_.genome_length));
+
+        // Copies of the same family go to random genomes, so that a metagenome has inter-genome repeats
+        for (unsigned i = 0; i < cfg_.repeat_families; ++i) {
+            std::string repeat = RandomSeq(cfg_.repeat_length);
+            for (unsigned j = 0; j < cfg_.repeat_copies; ++j) {
+                std::string &genome = genomes[rng_() % genomes.size()];
+                if (genome.size() <= repeat.size())
+                    continue;
+                std::string copy = repeat;
+                Mutate(copy, cfg_.repeat_divergence);
+                genome.replace(rng_() % (genome.size() - copy.size()), copy.size(), copy);
+            }
+        }
+
+        return genomes;
+    }
+
+    std::vector<double> Abundances(size_t count) {
+        std::vector<double> res;
+        std::lognormal_distribution<double> abundance(0, cfg_.abundance_sigma);
+        for (size_t i = 0; i < count; ++i)
+            res.push_back(count > 1 ? abundance(rng_) : 1.);
+        return res;
+    }
+
+    void SimulateReads(const std::vector<std::string> &genomes, const std::vector<double> &abundances,
+                       std::ostream &left, std::ostream &right) {
+        // Pairs are sampled from the genomes proportionally to abundance * length,
+        // the coverage averaged over all genomes is the requested one
+        std::vector<double> weights;
+        double total_length = 0;
+        for (size_t i = 0; i < genomes.size(); ++i) {
+            weights.push_back(abundances[i] * double(genomes[i].size()));
+            total_length += double(genomes[i].size());
+        }
+        std::discrete_distribution<size_t> genome_distr(weights.begin(), weights.end());
+        std::normal_distribution<double> insert_distr(double(cfg_.insert_size), double(cfg_.insert_size_dev));
+
+        size_t pairs = size_t(cfg_.coverage * total_length / double(2 * cfg_.read_length));
+        const std::string quality(cfg_.read_length, 'I');
+        for (size_t i = 0; i < pairs; ++i) {
+            const std::string &genome = genomes[genome_distr(rng_)];
+            size_t insert = std::max(cfg_.read_length, size_t(std::max(0., insert_distr(rng_))));
+            if (insert >= genome.size())
+                continue;
+
+            std::string fragment = genome.substr(rng_() % (genome.size() - insert), insert);
+            if (rng_() % 2)
+                fragment = ReverseComplement(fragment);
+
+            std::string left_read = fragment.substr(0, cfg_.read_length);
+            std::string right_read = ReverseComplement(fragment.substr(insert - cfg_.read_length));
+            Mutate(left_read, cfg_.error_rate);
+            Mutate(right_read, cfg_.error_rate);
+
+            std::string name = "read_" + std::to_string(i);
+            left << '@' << name << "/1\n" << left_read << "\n+\n" << quality << '\n';
+            right << '@' << name << "/2\n" << right_read << "\n+\n" << quality << '\n';
+        }
+    }
+};
+
+}
+
+int main(int argc, char **argv) {
+    gcfg cfg;
+    process_cmdline(argc, argv, cfg);
+    VERIFY_MSG(cfg.genomes > 0 && cfg.read_length > 0 && cfg.insert_size >= cfg.read_length,
+               "Invalid dataset parameters");
+
+    DatasetGenerator generator(cfg);
+    auto genomes = generator.Genomes();
+    auto abundances = generator.Abundances(genomes.size());
+
+    std::ofstream reference(cfg.prefix + ".fasta");
+    for (size_t i = 0; i < genomes.size(); ++i)
+        reference << ">genome_" << i << " abundance=" << abundances[i] << '\n' << genomes[i] << '\n';
+
+    std::ofstream left(cfg.prefix + "_1.fastq"), right(cfg.prefix + "_2.fastq");
+    generator.SimulateReads(genomes, abundances, left, right);
+    VERIFY_MSG(reference && left && right, "Failed to write the dataset to " << cfg.prefix);
+
+    return 0;
+}
@@ -13,10 +13,15 @@
 #include "pipeline/graph_pack.hpp" // FIXME: get rid of it
 #include "modules/graph_construction.hpp"
 #include "modules/alignment/edge_index.hpp"
+#include "modules/alignment/sequence_mapper.hpp"
+#include "utils/kmer_mph/kmer_splitters.hpp"
+#include "utils/ph_map/coverage_hash_map_builder.hpp"
 
 #include "test_utils.hpp"
 #include "tmp_folder_fixture.hpp"
 
+#include <random>
+#include <sstream>
 #include <vector>
 #include <set>
 #include <string>
@@ -96,6 +101,213 @@ TEST_F( GraphConstruction, TestKmerFreeIndex ) {
     CheckIndex(reads, tmp_folder(), 5);
 }
 
+TEST_F( GraphConstruction, MinimizerIndex ) {
+    const size_t k = 21;
+
+    std::mt19937 rnd(42);
+    std::string genome = RandomGenomeWithRepeats(rnd, 1500, 300);
+
+    GraphPack gp(k, tmp_folder(), 0);
+    ConstructGraphFromReads(gp, { genome });
+    const auto &graph = gp.get<Graph>();
+    const auto &index = gp.get<EdgeIndex<Graph>>();
+
+    MinimizerEdgeIndex<Graph> sparse_index(graph, 10);
+    sparse_index.Refill();
+    EXPECT_LT(sparse_index.size() * 3, genome.size());
+
+    // Sampled k-mers are found at the same positions
+    Sequence genome_seq(genome);
+    RtSeq kmer = genome_seq.start<RtSeq>(k + 1) >> 'A';
+    for (size_t i = k; i < genome_seq.size(); ++i) {
+        kmer <<= genome_seq[i];
+        auto pos = sparse_index.get(kmer);
+        if (pos.second != MinimizerEdgeIndex<Graph>::NOT_FOUND)
+            EXPECT_EQ(index.get(kmer), pos);
+        auto rc_pos = sparse_index.get(!kmer);
+        if (rc_pos.second != MinimizerEdgeIndex<Graph>::NOT_FOUND)
+            EXPECT_EQ(index.get(!kmer), rc_pos);
+    }
+
+    // Sparse mapping loses at most the edges before the first seed
+    auto mapper = MapperInstance(gp);
+    auto sparse_mapper = MapperInstance(gp, sparse_index);
+    size_t reads = 0, same = 0;
+    for (size_t pos = 0; pos + 150 <= genome.size(); pos += 37, ++reads) {
+        Sequence read(genome.substr(pos, 150));
+        auto path = mapper->MapSequence(read).simple_path();
+        auto sparse_path = sparse_mapper->MapSequence(read).simple_path();
+        ASSERT_LE(sparse_path.size(), path.size());
+        EXPECT_TRUE(std::equal(sparse_path.rbegin(), sparse_path.rend(), path.rbegin()));
+        same += (sparse_path == path);
+    }
+    EXPECT_GT(same * 10, reads * 9);
+}
+
+TEST_F( GraphConstruction, BatchMapping ) {
+    const size_t k = 21;
+
+    std::mt19937 rnd(43);
+    std::string genome = RandomGenomeWithRepeats(rnd, 1500, 300);
+
+    GraphPack gp(k, tmp_folder(), 0);
+    ConstructGraphFromReads(gp, { genome });
+    gp.get_mutable<KmerMapper<Graph>>().Attach();
+    MinimizerEdgeIndex<Graph> sparse_index(gp.get<Graph>(), 10);
+    sparse_index.Refill();
+
+    // Reads with errors, some of them shorter than k-mers
+    std::vector<Sequence> reads;
+    for (size_t i = 0; i < 500; ++i) {
+        size_t len = 10 + rnd() % 200;
+        std::string read = genome.substr(rnd() % (genome.size() - len), len);
+        for (char &c : read)
+            if (rnd() % 50 == 0)
+                c = "ACGT"[rnd() % 4];
+        reads.emplace_back(read);
+    }
+
+    std::vector<std::shared_ptr<SequenceMapper<Graph>>> mappers = { MapperInstance(gp),
+                                                                    MapperInstance(gp, sparse_index) };
+    for (const auto &mapper : mappers) {
+        for (bool only_simple : { false, true }) {
+            auto paths = mapper->MapSequences(reads, only_simple);
+            ASSERT_EQ(reads.size(), paths.size());
+            for (size_t i = 0; i < reads.size(); ++i) {
+                auto path = mapper->MapSequence(reads[i], only_simple);
+                ASSERT_EQ(path.size(), paths[i].size());
+                for (size_t j = 0; j < path.size(); ++j) {
+                    EXPECT_EQ(path[j].first, paths[i][j].first);
+                    EXPECT_EQ(path[j].second, paths[i][j].second);
+                }
+            }
+        }
+    }
+}
+
+TEST_F( GraphConstruction, CountedCoverage ) {
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    using CoverageMap = utils::PerfectHashMap<RtSeq, uint32_t, utils::slim_kmer_index_traits<RtSeq>, utils::DefaultStoring>;
+    const unsigned k = 22;
+
+    std::mt19937 rnd(17);
+    std::string genome = RandomGenomeWithRepeats(rnd, 1000, 200);
+    std::vector<std::string> reads;
+    for (size_t i = 0; i < 2000; ++i) {
+        std::string read = genome.substr(rnd() % (genome.size() - 100), 100);
+        if (rnd() % 10 == 0)
+            read[rnd() % read.size()] = 'A';
+        reads.push_back(read);
+    }
+    // K-mers of the contigs are present, but not counted
+    std::string contig = RandomSeq(rnd, 500);
+
+    auto workdir = fs::tmp::make_temp_dir(tmp_folder(), "tests");
+    io::ReadStreamList<io::SingleRead> streams, contigs;
+    streams.push_back(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
+    contigs.push_back(RawStream(MakeReads({ contig })));
+
+    using Splitter = utils::DeBruijnReadKMerSplitter<io::SingleRead, utils::StoringTypeFilter<utils::DefaultStoring>>;
+    Splitter splitter(workdir, k, streams);
+    splitter.set_count_multiplicities(true);
+    splitter.set_extra_streams(contigs);
+    kmers::KMerDiskCounter<RtSeq> counter(workdir, std::move(splitter));
+    auto kmers = counter.Count(4, 1);
+    ASSERT_TRUE(kmers.has_counts());
+
+    CoverageMap counted(k), scanned(k), atomic(k);
+    utils::CoverageHashMapBuilder().BuildIndexFromCounts(counted, kmers, 1);
+    // Small batches to go through several rounds of bucketed updates
+    utils::CoverageHashMapBuilder(/* bucketed */ true, 1000).BuildIndex(scanned, kmers, streams);
+    utils::CoverageHashMapBuilder(/* bucketed */ false).BuildIndex(atomic, kmers, streams);
+
+    size_t total = 0, uncounted = 0;
+    for (size_t i = 0; i < kmers.num_buckets(); ++i) {
+        for (auto kmer : kmers.bucket(i)) {
+            auto kwh = counted.ConstructKWH(RtSeq(k, kmer.first));
+            ASSERT_TRUE(kwh.is_minimal());
+            uint32_t cov = counted.get_raw_value_reference(kwh);
+            EXPECT_EQ(scanned.get_raw_value_reference(scanned.ConstructKWH(RtSeq(k, kmer.first))), cov);
+            EXPECT_EQ(atomic.get_raw_value_reference(atomic.ConstructKWH(RtSeq(k, kmer.first))), cov);
+            total += cov;
+            uncounted += (cov == 0);
+        }
+    }
+    // Every k-mer instance is counted either for the read or for its reverse complement
+    EXPECT_EQ(reads.size() * (100 - k + 1), total);
+
+    // Only canonical k-mers are stored
+    size_t contig_kmers = 0;
+    Sequence contig_seq(contig);
+    RtSeq kmer = contig_seq.start<RtSeq>(k) >> 'A';
+    for (size_t i = k - 1; i < contig_seq.size(); ++i) {
+        kmer <<= contig_seq[i];
+        contig_kmers += kmer.IsMinimal();
+    }
+    EXPECT_EQ(contig_kmers, uncounted);
+}
+
+TEST_F( GraphConstruction, SaveLoadStorage ) {
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    const unsigned k = 21;
+
+    std::mt19937 rnd(239);
+    std::vector<std::string> reads;
+    for (size_t i = 0; i < 200; ++i) {
+        std::string read;
+        for (size_t j = 0; j < 100; ++j)
+            read += "ACGT"[rnd() % 4];
+        reads.push_back(read);
+    }
+
+    auto workdir = fs::tmp::make_temp_dir(tmp_folder(), "tests");
+    io::ReadStreamList<io::SingleRead> streams;
+    streams.push_back(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
+
+    using Splitter = utils::DeBruijnReadKMerSplitter<io::SingleRead, utils::StoringTypeFilter<utils::DefaultStoring>>;
+    Splitter splitter(workdir, k + 1, streams);
+    splitter.set_count_multiplicities(true);
+    kmers::KMerDiskCounter<RtSeq> counter(workdir, std::move(splitter));
+    auto kmers = counter.Count(4, 1);
+
+    utils::DeBruijnExtensionIndex<> ext(k);
+    utils::DeBruijnExtensionIndexBuilder().BuildExtensionIndexFromKPOMers(workdir, ext, kmers, 1);
+
+    std::stringstream ss;
+    kmers.BinWrite(ss);
+    ext.BinWrite(ss);
+
+    auto loaddir = fs::tmp::make_temp_dir(tmp_folder(), "tests");
+    kmers::KMerDiskStorage<RtSeq> loaded_kmers;
+    utils::DeBruijnExtensionIndex<> loaded_ext(k);
+    loaded_kmers.BinRead(ss, loaddir);
+    loaded_ext.BinRead(ss, loaddir);
+
+    ASSERT_EQ(kmers.k(), loaded_kmers.k());
+    ASSERT_EQ(kmers.num_buckets(), loaded_kmers.num_buckets());
+    ASSERT_TRUE(loaded_kmers.has_counts());
+    for (size_t i = 0; i < kmers.num_buckets(); ++i) {
+        std::vector<RtSeq> expected, actual;
+        for (auto kmer : kmers.bucket(i))
+            expected.emplace_back(k + 1, kmer.first);
+        for (auto kmer : loaded_kmers.bucket(i))
+            actual.emplace_back(k + 1, kmer.first);
+        EXPECT_EQ(expected, actual);
+
+        auto counts = kmers.bucket_counts(i), loaded_counts = loaded_kmers.bucket_counts(i);
+        EXPECT_TRUE(std::equal(counts.begin(), counts.end(), loaded_counts.begin(), loaded_counts.end()));
+    }
+
+    size_t checked = 0;
+    for (auto it = loaded_ext.kmer_begin(); it.good(); ++it) {
+        RtSeq kmer(k, *it);
+        EXPECT_EQ(ext.get_value(ext.ConstructKWH(kmer)).get_mask(),
+                  loaded_ext.get_value(loaded_ext.ConstructKWH(kmer)).get_mask());
+        checked += 1;
+    }
+    EXPECT_EQ(ext.size(), checked);
+}
+
 TEST_F( GraphConstruction, SimpleTestEarlyPairedInfo ) {
     std::vector<MyPairedRead> paired_reads = {{"CCCAC", "CCACG"}, {"ACCAC", "CCACA"}};
     std::vector<MyEdge> edges = {"CCCA", "ACCA", "CCAC", "CACG", "CACA"};
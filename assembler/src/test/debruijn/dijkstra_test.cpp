@@ -0,0 +1,88 @@
+//***************************************************************************
+//* Copyright (c) 2023 Saint Petersburg State University
+//* All Rights Reserved
+//* See file LICENSE for details.
+//***************************************************************************
+
+#include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/dijkstra/dijkstra_helper.hpp"
+#include "random_graph.hpp"
+
+#include <gtest/gtest.h>
+
+using namespace debruijn_graph;
+
+typedef omnigraph::DijkstraHelper<Graph> Helper;
+typedef omnigraph::DijkstraHelper<Graph, omnigraph::RadixHeapDijkstra> RadixHelper;
+
+TEST( Dijkstra, RadixHeapMatchesBinaryHeap ) {
+    Graph g(55);
+    RandomGraph<Graph>(g, /*max_size*/ 100).Generate(/*iterations*/ 1000);
+
+    const size_t bound = 3000;
+    auto radix = RadixHelper::CreateBoundedDijkstra(g, bound, -1ul, true);
+    for (VertexId start : g) {
+        auto dijkstra = Helper::CreateBoundedDijkstra(g, bound, -1ul, true);
+        dijkstra.Run(start);
+        // The same radix dijkstra is reused for all starts
+        radix.Run(start);
+
+        ASSERT_EQ(dijkstra.ReachedVertices(), radix.ReachedVertices());
+        for (VertexId v : g) {
+            ASSERT_EQ(dijkstra.DistanceCounted(v), radix.DistanceCounted(v));
+            if (!radix.DistanceCounted(v))
+                continue;
+
+            EXPECT_EQ(dijkstra.GetDistance(v), radix.GetDistance(v));
+            EXPECT_EQ(dijkstra.ProcessedVertices().count(v), radix.ProcessedVertices().count(v));
+
+            auto path = radix.GetShortestPathTo(v);
+            size_t len = 0;
+            VertexId curr = start;
+            for (EdgeId e : path) {
+                ASSERT_EQ(curr, g.EdgeStart(e));
+                len += g.length(e);
+                curr = g.EdgeEnd(e);
+            }
+            EXPECT_EQ(v, curr);
+            EXPECT_EQ(radix.GetDistance(v), len);
+        }
+    }
+}
+
+TEST( Dijkstra, RadixHeapVertexLimit ) {
+    Graph g(55);
+    RandomGraph<Graph>(g, /*max_size*/ 100).Generate(/*iterations*/ 1000);
+
+    for (VertexId start : g) {
+        auto dijkstra = Helper::CreateBoundedDijkstra(g, 3000, 10);
+        auto radix = RadixHelper::CreateBoundedDijkstra(g, 3000, 10);
+        dijkstra.Run(start);
+        radix.Run(start);
+        EXPECT_EQ(dijkstra.VertexLimitExceeded(), radix.VertexLimitExceeded());
+    }
+}
+
+TEST( Dijkstra, RadixHeapStorageRelease ) {
+    Graph g(55);
+    RandomGraph<Graph>(g, /*max_size*/ 100).Generate(/*iterations*/ 1000);
+    VertexId start = *g.begin();
+
+    auto alive = RadixHelper::CreateBoundedDijkstra(g, 3000);
+    alive.Run(start);
+    {
+        auto finished = RadixHelper::CreateBoundedDijkstra(g, 3000);
+        finished.Run(start);
+    }
+    // The storage of the alive search is kept, the pooled one is freed
+    omnigraph::ReleaseDijkstraStorages();
+
+    auto dijkstra = Helper::CreateBoundedDijkstra(g, 3000);
+    dijkstra.Run(start);
+    auto radix = RadixHelper::CreateBoundedDijkstra(g, 3000);
+    radix.Run(start);
+    for (VertexId v : dijkstra.ReachedVertices()) {
+        EXPECT_EQ(dijkstra.GetDistance(v), radix.GetDistance(v));
+        EXPECT_EQ(dijkstra.GetDistance(v), alive.GetDistance(v));
+    }
+}
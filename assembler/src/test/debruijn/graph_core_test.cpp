@@ -5,6 +5,7 @@
 //***************************************************************************
 
 #include "assembly_graph/core/graph.hpp"
+#include "assembly_graph/components/connected_component.hpp"
 
 #include <vector>
 #include <set>
@@ -106,3 +107,36 @@ TEST( GraphCore, SelfRCEdgeMerge ) {
     EXPECT_EQ(1u, g.OutgoingEdgeCount(v1));
     EXPECT_EQ(Sequence("AACGCTATTCACGTGAATAGCGTT"), g.EdgeNucls(g.GetUniqueOutgoingEdge(v1)));
 }
+
+TEST( GraphCore, EdgeComponents ) {
+    Graph g(11);
+    auto chain = createGraph(g, 3);
+    auto single = createGraph(g, 1);
+    // Two edges from the same vertex join a component through it
+    EdgeId branch = g.AddEdge(chain.first[0], g.AddVertex(), Sequence("AAAAAAAAAAAAAAAAA"));
+
+    EdgeComponents components(g);
+    components.Calculate();
+    // Conjugate edges go to the same component
+    EXPECT_EQ(2u, components.size());
+    size_t comp = components.component(chain.second[0]);
+    for (EdgeId e : chain.second) {
+        EXPECT_EQ(comp, components.component(e));
+        EXPECT_EQ(comp, components.component(g.conjugate(e)));
+    }
+    EXPECT_EQ(comp, components.component(branch));
+    EXPECT_NE(comp, components.component(single.second[0]));
+    EXPECT_EQ(8u, components.edge_count(comp));
+    EXPECT_EQ(8 * g.length(branch), components.length(comp));
+
+    std::set<EdgeId> edges(components.edges(comp).begin(), components.edges(comp).end());
+    EXPECT_EQ(8u, edges.size());
+    EXPECT_EQ(1u, edges.count(g.conjugate(branch)));
+
+    ConnectedComponentCounter counter(g);
+    EXPECT_FALSE(counter.IsFilled());
+    // The largest component goes first
+    EXPECT_EQ(0u, counter.GetComponent(branch));
+    EXPECT_EQ(1u, counter.GetComponent(g.conjugate(single.second[0])));
+    EXPECT_TRUE(counter.IsFilled());
+}
@@ -10,9 +10,17 @@
 #include "io/binary/graph.hpp"
 #include "io/binary/kmer_mapper.hpp"
 #include "io/binary/paired_index.hpp"
+#include "io/graph/gfa_reader.hpp"
+#include "io/graph/gfa_writer.hpp"
+#include "utils/perf/timetracer.hpp"
+#include "utils/parallel/openmp_wrapper.h"
+
+#include "tmp_folder_fixture.hpp"
 
 #include <gtest/gtest.h>
 
+#include <thread>
+
 using namespace debruijn_graph;
 
 template<typename T>
@@ -109,3 +117,92 @@ TEST(Io, KmerMapper) {
 
     CompareContainers(kmer_mapper, new_mapper);
 }
+
+TEST(Io, GFA) {
+    const auto &graph = CommonGraph();
+
+    std::string gfa_file = std::string(file_name) + ".gfa";
+    {
+        std::ofstream os(gfa_file);
+        gfa::GFAWriter(graph, os).WriteSegmentsAndLinks();
+    }
+
+    gfa::GFAReader gfa(gfa_file);
+    ASSERT_TRUE(gfa.valid());
+    EXPECT_EQ(graph.k(), gfa.k());
+
+    Graph new_graph(graph.k());
+    io::IdMapper<std::string> id_mapper;
+    gfa.to_graph(new_graph, &id_mapper);
+    EXPECT_EQ(graph.e_size(), new_graph.e_size());
+
+    std::unordered_map<std::string, EdgeId> by_name;
+    for (EdgeId e : new_graph.edges())
+        by_name[id_mapper[e.int_id()]] = e;
+
+    io::CanonicalEdgeHelper<Graph> namer(graph);
+    auto new_edge = [&](EdgeId e) {
+        EdgeId ce = namer.Canonical(e);
+        EdgeId ne = by_name.at(namer.EdgeString(ce));
+        return ce == e ? ne : new_graph.conjugate(ne);
+    };
+
+    for (EdgeId e : graph.edges()) {
+        EdgeId ne = new_edge(e);
+        EXPECT_EQ(graph.EdgeNucls(e), new_graph.EdgeNucls(ne));
+        for (EdgeId next : graph.OutgoingEdges(graph.EdgeEnd(e)))
+            EXPECT_EQ(new_graph.EdgeEnd(ne), new_graph.EdgeStart(new_edge(next)));
+    }
+}
+
+TEST(Io, PerThreadTrace) {
+    TmpFolderFixture fixture("tmp_trace");
+    utils::trace::enable(fixture.tmp_folder() + "/trace_", 1024);
+    // Other tests should not be traced even if this one fails
+    struct Disabler {
+        ~Disabler() { utils::trace::disable(); }
+    } disabler;
+
+    const size_t chunks = 16;
+    {
+        TIME_TRACE_THREAD_SCOPE("outer");
+        #pragma omp parallel for num_threads(4)
+        for (size_t i = 0; i < chunks; ++i) {
+            TIME_TRACE_THREAD_SCOPE("chunk");
+            TIME_TRACE_COUNTER(BytesRead, 100);
+        }
+        TIME_TRACE_COUNTER(ReadsMapped, 42);
+    }
+    // Short-lived threads take over the buffers of the exited ones
+    const size_t short_threads = 8;
+    for (size_t i = 0; i < short_threads; ++i)
+        std::thread([]() { TIME_TRACE_THREAD_SCOPE("short"); }).join();
+    utils::trace::flush("stage");
+
+    std::ifstream is(fixture.tmp_folder() + "/trace_stage.json");
+    ASSERT_TRUE(is.good());
+    std::string trace((std::istreambuf_iterator<char>(is)), std::istreambuf_iterator<char>());
+
+    auto occurrences = [&](const std::string &pattern) {
+        size_t res = 0;
+        for (size_t pos = trace.find(pattern); pos != std::string::npos; pos = trace.find(pattern, pos + 1))
+            ++res;
+        return res;
+    };
+    EXPECT_EQ(chunks, occurrences("\"name\":\"chunk\""));
+    EXPECT_EQ(1u, occurrences("\"name\":\"outer\""));
+    EXPECT_LE(1u, occurrences("\"name\":\"reads mapped (thread 0)\""));
+    EXPECT_LE(1u, occurrences("\"value\":42}"));
+    EXPECT_LE(1u, occurrences("\"name\":\"bytes read (thread"));
+    EXPECT_EQ(short_threads, occurrences("\"name\":\"short\""));
+    EXPECT_GE(5u, occurrences("\"name\":\"thread_name\""));
+
+    // Only the events since the previous flush are exported
+    utils::trace::flush("next");
+    std::ifstream next(fixture.tmp_folder() + "/trace_next.json");
+    std::string next_trace((std::istreambuf_iterator<char>(next)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(std::string::npos, next_trace.find("\"chunk\""));
+
+    utils::trace::disable();
+    EXPECT_FALSE(utils::trace::enabled());
+}
@@ -6,6 +6,7 @@
 
 #include "random_graph.hpp"
 
+#include "paired_info/distance_estimation.hpp"
 #include "paired_info/index_point.hpp"
 #include "paired_info/paired_info_helpers.hpp"
 //#include "io/binary/paired_index.hpp"
@@ -458,3 +459,24 @@ TEST(PairedInfo, RandomSymmetry) {
         }
     }
 }
+
+TEST(PairedInfo, BoundedPathLengthsMatchPathProcessor) {
+    debruijn_graph::Graph graph(55);
+    debruijn_graph::RandomGraph<debruijn_graph::Graph>(graph, /*max_size*/100).Generate(/*iterations*/1000);
+
+    const size_t max_len = 1500;
+    for (VertexId start : graph) {
+        auto lengths = BoundedPathLengths::Compute(graph, start, max_len, -1ul);
+        ASSERT_TRUE(lengths);
+        for (VertexId end : graph) {
+            for (size_t min_len : {0ul, 500ul}) {
+                omnigraph::DistancesLengthsCallback<debruijn_graph::Graph> callback(graph);
+                omnigraph::ProcessPaths(graph, min_len, max_len, start, end, callback);
+
+                std::vector<size_t> swept;
+                lengths->Lengths(end, min_len, swept);
+                EXPECT_EQ(callback.distances(), swept);
+            }
+        }
+    }
+}
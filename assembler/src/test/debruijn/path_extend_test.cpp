@@ -755,3 +755,43 @@ TEST( PathExtend, BidirectionalPathLoopDetector ) {
     EXPECT_EQ(path1->Size(), 12);
     EXPECT_EQ(path1->Back(), e7);
 }
+
+TEST( PathExtend, GraphCoverageMapBulk ) {
+    Graph g(13);
+    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/path_extend/distance_estimation", g));
+    EdgeId start = *g.ConstEdgeBegin();
+
+    EdgeId e1 = g.conjugate(start);
+    EdgeId e2 = *(g.OutgoingEdges(g.EdgeEnd(e1)).begin());
+    EdgeId e3 = *(g.OutgoingEdges(g.EdgeEnd(e2)).begin());
+    EdgeId e4 = *(g.OutgoingEdges(g.EdgeEnd(e3)).begin());
+    EdgeId e5 = *(g.OutgoingEdges(g.EdgeEnd(e4)).begin());
+    auto it5 = g.OutgoingEdges(g.EdgeEnd(e5)).begin();
+    ++it5;
+    EdgeId e6 = *it5;
+
+    PathContainer paths;
+    auto &path1 = paths.Create(g, std::vector<EdgeId>{e1, e2, e3, e4});
+    auto &path2 = paths.Create(g, std::vector<EdgeId>{e4, e5, e6, e5, e6, e5});
+    paths.Create(g, std::vector<EdgeId>{e2, e3});
+
+    GraphCoverageMap bulk_map(g, paths);
+    GraphCoverageMap subscribed_map(g, paths, true);
+
+    EXPECT_EQ(bulk_map.size(), subscribed_map.size());
+    for (EdgeId e : g.edges()) {
+        EXPECT_EQ(bulk_map.GetCoverage(e), subscribed_map.GetCoverage(e));
+        EXPECT_EQ(bulk_map.GetCoveringPaths(e), subscribed_map.GetCoveringPaths(e));
+        for (const auto &path_pair : paths) {
+            EXPECT_EQ(bulk_map.Count(e, *path_pair.first), subscribed_map.Count(e, *path_pair.first));
+            EXPECT_EQ(bulk_map.Count(e, *path_pair.second), subscribed_map.Count(e, *path_pair.second));
+        }
+    }
+
+    EXPECT_EQ(bulk_map.GetCoverage(e2), 2);
+    EXPECT_EQ(bulk_map.GetCoverage(e4), 2);
+    EXPECT_EQ(bulk_map.Count(e5, path2), 3);
+    EXPECT_EQ(bulk_map.Count(e5, path1), 0);
+    EXPECT_EQ(bulk_map.Count(g.conjugate(e1), *path1.GetConjPath()), 1);
+    EXPECT_TRUE(bulk_map.IsCovered(path1));
+}
@@ -247,6 +247,37 @@ TEST_F( Simplification,  MFUniquePath ) {
     EXPECT_EQ(12, g.size());
 }
 
+TEST_F( Simplification,  FlowNetwork ) {
+    // The network from CLRS with maximum flow 23, plus one more unit from 4 to 5
+    omnigraph::FlowNetwork network;
+    std::vector<size_t> v;
+    for (size_t i = 0; i < 6; ++i)
+        v.push_back(network.AddVertex());
+    network.AddArc(v[0], v[1], 16);
+    network.AddArc(v[0], v[2], 13);
+    network.AddArc(v[1], v[3], 12);
+    network.AddArc(v[2], v[1], 4);
+    network.AddArc(v[2], v[4], 14);
+    network.AddArc(v[3], v[2], 9);
+    network.AddArc(v[3], v[5], 20);
+    network.AddArc(v[4], v[3], 7);
+    network.AddArc(v[4], v[5], 4);
+    // Parallel arc and a self-loop do not break anything
+    network.AddArc(v[4], v[5], 1);
+    network.AddArc(v[3], v[3], 5);
+    network.Build();
+
+    EXPECT_EQ(24, network.MaxFlow(v[0], v[5]));
+    EXPECT_EQ(0, network.MaxFlow(v[0], v[5]));
+    EXPECT_TRUE(network.HasOutgoingResidual(v[0]));
+
+    // Minimum cut separates {0, 1, 2, 4} from {3, 5}, no residual path crosses it backwards
+    auto colouring = network.ResidualComponents();
+    for (size_t i : {0, 1, 2, 4})
+        for (size_t j : {3, 5})
+            EXPECT_NE(colouring[v[i]], colouring[v[j]]);
+}
+
 //TEST( Simplification,  TopologyTC ) {
 //    Graph g(55);
 //    ASSERT_TRUE(graphio::ScanBasicGraph("./src/test/debruijn/graph_fragments/topology_ec/unique_path", g));
@@ -227,4 +227,22 @@ void AssertGraph(size_t k, const std::vector<MyPairedRead> &paired_reads, size_t
     AssertPairInfo(graph, paired_indices[0], AddComplement(AddBackward(etalon_pair_info)));
 }
 
+std::string RandomGenomeWithRepeats(std::mt19937 &rng, size_t region_len, size_t repeat_len) {
+    std::string repeat = RandomSeq(rng, repeat_len);
+    std::string genome = RandomSeq(rng, region_len);
+    for (size_t i = 0; i < 2; ++i) {
+        genome += repeat;
+        genome += RandomSeq(rng, region_len);
+    }
+    return genome;
+}
+
+void ConstructGraphFromReads(GraphPack &gp, const std::vector<std::string> &reads) {
+    typedef io::VectorReadStream<io::SingleRead> RawStream;
+    auto workdir = fs::tmp::make_temp_dir(gp.workdir(), "tests");
+    io::ReadStreamList<io::SingleRead> streams(io::RCWrap<io::SingleRead>(RawStream(MakeReads(reads))));
+    ConstructGraphWithIndex(config::debruijn_config::construction(), workdir, streams,
+                            gp.get_mutable<Graph>(), gp.get_mutable<EdgeIndex<Graph>>());
+}
+
 }
@@ -12,6 +12,8 @@
 #include <unordered_set>
 #include <string>
 #include <map>
+#include <random>
+#include <vector>
 
 typedef std::string MyRead;
 typedef std::pair<MyRead, MyRead> MyPairedRead;
@@ -25,6 +27,7 @@ namespace debruijn_graph {
 class DeBruijnGraph;
 typedef DeBruijnGraph ConjugateDeBruijnGraph;
 typedef ConjugateDeBruijnGraph Graph;
+class GraphPack;
 }
 
 namespace test_utils {
@@ -43,4 +46,17 @@ void AssertCoverage(debruijn_graph::Graph& g, const CoverageInfo& etalon_coverag
 void AssertGraph(size_t k, const std::vector<MyPairedRead> &paired_reads, size_t /*rl*/, size_t insert_size,
                  const std::vector<MyEdge> &etalon_edges, const CoverageInfo &etalon_coverage,
                  const EdgePairInfo &etalon_pair_info);
+
+// Random nucleotide sequence, the benchmarks generate their data with it as well
+inline std::string RandomSeq(std::mt19937 &rng, size_t len) {
+    std::string res(len, 'A');
+    for (char &c : res)
+        c = "ACGT"[rng() % 4];
+    return res;
+}
+
+// Three random regions separated by two copies of a random repeat
+std::string RandomGenomeWithRepeats(std::mt19937 &rng, size_t region_len, size_t repeat_len);
+// Constructs the graph and the k-mer index of the pack from the reads and their reverse complements
+void ConstructGraphFromReads(debruijn_graph::GraphPack &gp, const std::vector<std::string> &reads);
 };